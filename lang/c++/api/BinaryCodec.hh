@@ -0,0 +1,837 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BinaryCodec_hh__
+#define avro_BinaryCodec_hh__
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+
+#include "boost/array.hpp"
+#include "boost/static_assert.hpp"
+
+#include "Config.hh"
+#include "Exception.hh"
+#include "Stream.hh"
+#include "Specific.hh"
+
+/**
+ * Encoding and decoding of specific types straight to and from memory in
+ * Avro binary format, without going through Encoder or Decoder.
+ *
+ * binary_codec_traits plays the role of codec_traits for this path. It is
+ * specialized here for the same C++ types as codec_traits, and avrogencpp
+ * generates specializations for records, enums and unions when run with
+ * --binary-codec. A specialization has the static methods:
+ * \li static bool encode(uint8_t*& p, uint8_t* end, const T& value);
+ * \li static bool decode(const uint8_t*& p, const uint8_t* end, T& value);
+ * which return false if [p, end) is too short for the value, and
+ * \li static size_t size(const T& value);
+ * which returns the exact length of the value's encoding. Types whose
+ * encoding has an upper bound on its size also have
+ * \li static const size_t maxSize;
+ * \li static void put(uint8_t*& p, const T& value);
+ * where put() assumes that at least maxSize bytes are available at p. This
+ * lets a record check the space for a run of such fields just once.
+ *
+ * The functions encodeBinary(), decodeBinary() and encodedSize() are the
+ * entry points.
+ * The stream versions work directly on the stream's buffers and fall back
+ * to the Encoder/Decoder path for values that straddle two buffers.
+ */
+namespace avro {
+
+template <typename T>
+struct binary_codec_traits {
+};
+
+/**
+ * holds_views<T>::value is true if T has StringView or BytesView parts,
+ * which decoding points into the input or an Arena. avrogencpp
+ * specializes it, when run with --views, for the records and unions that
+ * hold strings or bytes.
+ */
+template <typename T>
+struct holds_views {
+    static const bool value = false;
+};
+
+template <> struct holds_views<StringView> {
+    static const bool value = true;
+};
+
+template <> struct holds_views<BytesView> {
+    static const bool value = true;
+};
+
+template <typename T> struct holds_views<std::vector<T> > {
+    static const bool value = holds_views<T>::value;
+};
+
+template <typename T> struct holds_views<std::map<std::string, T> > {
+    static const bool value = holds_views<T>::value;
+};
+
+namespace binary {
+
+/**
+ * Writes \p l as a zig-zag varint. There must be room for 10 bytes at p.
+ */
+inline void putLong(uint8_t*& p, int64_t l)
+{
+    uint64_t v = (static_cast<uint64_t>(l) << 1) ^
+        static_cast<uint64_t>(l >> 63);
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+}
+
+/**
+ * Returns the length of the zig-zag varint encoding of \p l.
+ */
+inline size_t longSize(int64_t l)
+{
+    uint64_t v = (static_cast<uint64_t>(l) << 1) ^
+        static_cast<uint64_t>(l >> 63);
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * Writes \p l as a zig-zag varint if it fits before \p end.
+ */
+inline bool encodeLong(uint8_t*& p, uint8_t* end, int64_t l)
+{
+    if (end - p >= 10) {
+        putLong(p, l);
+        return true;
+    }
+    uint8_t buf[10];
+    uint8_t* q = buf;
+    putLong(q, l);
+    size_t n = q - buf;
+    if (static_cast<size_t>(end - p) < n) {
+        return false;
+    }
+    ::memcpy(p, buf, n);
+    p += n;
+    return true;
+}
+
+/**
+ * Reads a zig-zag varint if all of it lies before \p end.
+ */
+inline bool decodeLong(const uint8_t*& p, const uint8_t* end, int64_t& l)
+{
+    uint64_t encoded = 0;
+    int shift = 0;
+    const uint8_t* q = p;
+    uint8_t u;
+    do {
+        if (q == end) {
+            return false;
+        }
+        if (shift >= 64) {
+            throw Exception("Invalid Avro varint");
+        }
+        u = *q++;
+        encoded |= static_cast<uint64_t>(u & 0x7f) << shift;
+        shift += 7;
+    } while (u & 0x80);
+
+    l = static_cast<int64_t>((encoded >> 1) ^ -(encoded & 1));
+    p = q;
+    return true;
+}
+
+/**
+ * Reads a varint that holds a length or count.
+ */
+inline bool decodeSize(const uint8_t*& p, const uint8_t* end, size_t& n)
+{
+    int64_t l;
+    if (! decodeLong(p, end, l)) {
+        return false;
+    }
+    if (l < 0) {
+        throw Exception("Negative length in Avro binary data");
+    }
+    n = static_cast<size_t>(l);
+    return true;
+}
+
+/**
+ * Reads the item count that starts each block of an array or a map.
+ */
+inline bool decodeBlockCount(const uint8_t*& p, const uint8_t* end,
+    size_t& n)
+{
+    int64_t l;
+    if (! decodeLong(p, end, l)) {
+        return false;
+    }
+    if (l < 0) {
+        if (l == std::numeric_limits<int64_t>::min()) {
+            throw Exception("Invalid block count in Avro binary data");
+        }
+        int64_t byteCount;
+        if (! decodeLong(p, end, byteCount)) {
+            return false;
+        }
+        if (byteCount < 0) {
+            throw Exception("Negative block size in Avro binary data");
+        }
+        l = -l;
+    }
+    n = static_cast<size_t>(l);
+    return true;
+}
+
+/**
+ * Writes a length prefixed byte sequence.
+ */
+inline bool encodeBytes(uint8_t*& p, uint8_t* end, const uint8_t* b,
+    size_t n)
+{
+    uint8_t* q = p;
+    if (! encodeLong(q, end, n) || static_cast<size_t>(end - q) < n) {
+        return false;
+    }
+    if (n > 0) {
+        ::memcpy(q, b, n);
+    }
+    p = q + n;
+    return true;
+}
+
+/**
+ * Unchecked encode through the binary_codec_traits of \p T.
+ */
+template <typename T>
+void put(uint8_t*& p, const T& t)
+{
+    binary_codec_traits<T>::put(p, t);
+}
+
+/**
+ * Checked encode through the binary_codec_traits of \p T.
+ */
+template <typename T>
+bool encode(uint8_t*& p, uint8_t* end, const T& t)
+{
+    return binary_codec_traits<T>::encode(p, end, t);
+}
+
+/**
+ * Checked decode through the binary_codec_traits of \p T.
+ */
+template <typename T>
+bool decode(const uint8_t*& p, const uint8_t* end, T& t)
+{
+    return binary_codec_traits<T>::decode(p, end, t);
+}
+
+/**
+ * Encoded size through the binary_codec_traits of \p T.
+ */
+template <typename T>
+size_t size(const T& t)
+{
+    return binary_codec_traits<T>::size(t);
+}
+
+/**
+ * Common implementation of encode() for types that have put().
+ */
+template <typename T>
+struct bounded_codec {
+    static bool encode(uint8_t*& p, uint8_t* end, const T& t) {
+        if (static_cast<size_t>(end - p) < binary_codec_traits<T>::maxSize) {
+            return false;
+        }
+        binary_codec_traits<T>::put(p, t);
+        return true;
+    }
+};
+
+}   // namespace binary
+
+/**
+ * binary_codec_traits for Avro boolean.
+ */
+template <> struct binary_codec_traits<bool> :
+    public binary::bounded_codec<bool> {
+    static const size_t maxSize = 1;
+
+    static size_t size(bool) {
+        return 1;
+    }
+
+    static void put(uint8_t*& p, bool b) {
+        *p++ = b ? 1 : 0;
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end, bool& b) {
+        if (p == end) {
+            return false;
+        }
+        if (*p > 1) {
+            throw Exception("Invalid value for bool");
+        }
+        b = *p++ != 0;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro int.
+ */
+template <> struct binary_codec_traits<int32_t> :
+    public binary::bounded_codec<int32_t> {
+    static const size_t maxSize = 5;
+
+    static size_t size(int32_t i) {
+        return binary::longSize(i);
+    }
+
+    static void put(uint8_t*& p, int32_t i) {
+        binary::putLong(p, i);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end, int32_t& i) {
+        int64_t l;
+        if (! binary::decodeLong(p, end, l)) {
+            return false;
+        }
+        if (static_cast<int32_t>(l) != l) {
+            throw Exception("Value out of range for Avro int");
+        }
+        i = static_cast<int32_t>(l);
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro long.
+ */
+template <> struct binary_codec_traits<int64_t> :
+    public binary::bounded_codec<int64_t> {
+    static const size_t maxSize = 10;
+
+    static size_t size(int64_t l) {
+        return binary::longSize(l);
+    }
+
+    static void put(uint8_t*& p, int64_t l) {
+        binary::putLong(p, l);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end, int64_t& l) {
+        return binary::decodeLong(p, end, l);
+    }
+};
+
+/**
+ * binary_codec_traits for Avro float.
+ */
+template <> struct binary_codec_traits<float> :
+    public binary::bounded_codec<float> {
+    static const size_t maxSize = sizeof(float);
+
+    static size_t size(float) {
+        return sizeof(float);
+    }
+
+    static void put(uint8_t*& p, float f) {
+        ::memcpy(p, &f, sizeof(float));
+        p += sizeof(float);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end, float& f) {
+        if (static_cast<size_t>(end - p) < sizeof(float)) {
+            return false;
+        }
+        ::memcpy(&f, p, sizeof(float));
+        p += sizeof(float);
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro double.
+ */
+template <> struct binary_codec_traits<double> :
+    public binary::bounded_codec<double> {
+    static const size_t maxSize = sizeof(double);
+
+    static size_t size(double) {
+        return sizeof(double);
+    }
+
+    static void put(uint8_t*& p, double d) {
+        ::memcpy(p, &d, sizeof(double));
+        p += sizeof(double);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end, double& d) {
+        if (static_cast<size_t>(end - p) < sizeof(double)) {
+            return false;
+        }
+        ::memcpy(&d, p, sizeof(double));
+        p += sizeof(double);
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro fixed.
+ */
+template <size_t N> struct binary_codec_traits<boost::array<uint8_t, N> > :
+    public binary::bounded_codec<boost::array<uint8_t, N> > {
+    static const size_t maxSize = N;
+
+    static size_t size(const boost::array<uint8_t, N>&) {
+        return N;
+    }
+
+    static void put(uint8_t*& p, const boost::array<uint8_t, N>& b) {
+        ::memcpy(p, b.data(), N);
+        p += N;
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        boost::array<uint8_t, N>& b) {
+        if (static_cast<size_t>(end - p) < N) {
+            return false;
+        }
+        ::memcpy(b.c_array(), p, N);
+        p += N;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro string.
+ */
+template <> struct binary_codec_traits<std::string> {
+    static size_t size(const std::string& s) {
+        return binary::longSize(s.size()) + s.size();
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end, const std::string& s) {
+        return binary::encodeBytes(p, end,
+            reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        std::string& s) {
+        const uint8_t* q = p;
+        size_t n;
+        if (! binary::decodeSize(q, end, n) ||
+            static_cast<size_t>(end - q) < n) {
+            return false;
+        }
+        s.assign(reinterpret_cast<const char*>(q), n);
+        p = q + n;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro bytes.
+ */
+template <> struct binary_codec_traits<std::vector<uint8_t> > {
+    static size_t size(const std::vector<uint8_t>& b) {
+        return binary::longSize(b.size()) + b.size();
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end,
+        const std::vector<uint8_t>& b) {
+        return binary::encodeBytes(p, end, b.empty() ? 0 : &b[0], b.size());
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        std::vector<uint8_t>& b) {
+        const uint8_t* q = p;
+        size_t n;
+        if (! binary::decodeSize(q, end, n) ||
+            static_cast<size_t>(end - q) < n) {
+            return false;
+        }
+        b.assign(q, q + n);
+        p = q + n;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro string decoded into a view. The view refers
+ * to the decoded data in place.
+ */
+template <> struct binary_codec_traits<StringView> {
+    static size_t size(const StringView& s) {
+        return binary::longSize(s.size()) + s.size();
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end, const StringView& s) {
+        return binary::encodeBytes(p, end,
+            reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        StringView& s) {
+        const uint8_t* q = p;
+        size_t n;
+        if (! binary::decodeSize(q, end, n) ||
+            static_cast<size_t>(end - q) < n) {
+            return false;
+        }
+        s = StringView(reinterpret_cast<const char*>(q), n);
+        p = q + n;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro bytes decoded into a view.
+ */
+template <> struct binary_codec_traits<BytesView> {
+    static size_t size(const BytesView& b) {
+        return binary::longSize(b.size()) + b.size();
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end, const BytesView& b) {
+        return binary::encodeBytes(p, end, b.data(), b.size());
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        BytesView& b) {
+        const uint8_t* q = p;
+        size_t n;
+        if (! binary::decodeSize(q, end, n) ||
+            static_cast<size_t>(end - q) < n) {
+            return false;
+        }
+        b = BytesView(q, n);
+        p = q + n;
+        return true;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro arrays.
+ */
+template <typename T> struct binary_codec_traits<std::vector<T> > {
+    static size_t size(const std::vector<T>& b) {
+        if (b.empty()) {
+            return 1;
+        }
+        size_t result = binary::longSize(b.size()) + 1;
+        for (typename std::vector<T>::const_iterator it = b.begin();
+            it != b.end(); ++it) {
+            result += binary::size(*it);
+        }
+        return result;
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end, const std::vector<T>& b) {
+        if (! b.empty()) {
+            if (! binary::encodeLong(p, end, b.size())) {
+                return false;
+            }
+            for (typename std::vector<T>::const_iterator it = b.begin();
+                it != b.end(); ++it) {
+                if (! binary::encode(p, end, *it)) {
+                    return false;
+                }
+            }
+        }
+        return binary::encodeLong(p, end, 0);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        std::vector<T>& s) {
+        size_t pos = 0;
+        size_t n;
+        while (binary::decodeBlockCount(p, end, n)) {
+            if (n == 0) {
+                s.resize(pos);
+                return true;
+            }
+            // The count comes from the data, so size the vector for no
+            // more items than there are bytes left and grow it from there.
+            size_t m = std::min(n, static_cast<size_t>(end - p));
+            if (s.size() < pos + m) {
+                s.resize(pos + m);
+            }
+            for (size_t i = 0; i < n; ++i, ++pos) {
+                if (pos == s.size()) {
+                    s.resize(pos + 1);
+                }
+                if (! binary::decode(p, end, s[pos])) {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro arrays of booleans.
+ */
+template <> struct binary_codec_traits<std::vector<bool> > {
+    static size_t size(const std::vector<bool>& b) {
+        return b.empty() ? 1 : binary::longSize(b.size()) + b.size() + 1;
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end, const std::vector<bool>& b) {
+        if (! b.empty()) {
+            if (! binary::encodeLong(p, end, b.size()) ||
+                static_cast<size_t>(end - p) < b.size()) {
+                return false;
+            }
+            for (std::vector<bool>::const_iterator it = b.begin();
+                it != b.end(); ++it) {
+                *p++ = *it ? 1 : 0;
+            }
+        }
+        return binary::encodeLong(p, end, 0);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        std::vector<bool>& s) {
+        s.clear();
+        size_t n;
+        while (binary::decodeBlockCount(p, end, n)) {
+            if (n == 0) {
+                return true;
+            }
+            if (n > static_cast<size_t>(end - p)) {
+                return false;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                bool b;
+                if (! binary::decode(p, end, b)) {
+                    return false;
+                }
+                s.push_back(b);
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * binary_codec_traits for Avro maps.
+ */
+template <typename T> struct binary_codec_traits<std::map<std::string, T> > {
+    static size_t size(const std::map<std::string, T>& b) {
+        if (b.empty()) {
+            return 1;
+        }
+        size_t result = binary::longSize(b.size()) + 1;
+        for (typename std::map<std::string, T>::const_iterator
+            it = b.begin(); it != b.end(); ++it) {
+            result += binary::size(it->first) + binary::size(it->second);
+        }
+        return result;
+    }
+
+    static bool encode(uint8_t*& p, uint8_t* end,
+        const std::map<std::string, T>& b) {
+        if (! b.empty()) {
+            if (! binary::encodeLong(p, end, b.size())) {
+                return false;
+            }
+            for (typename std::map<std::string, T>::const_iterator
+                it = b.begin(); it != b.end(); ++it) {
+                if (! binary::encode(p, end, it->first) ||
+                    ! binary::encode(p, end, it->second)) {
+                    return false;
+                }
+            }
+        }
+        return binary::encodeLong(p, end, 0);
+    }
+
+    static bool decode(const uint8_t*& p, const uint8_t* end,
+        std::map<std::string, T>& s) {
+        s.clear();
+        std::string k;
+        size_t n;
+        while (binary::decodeBlockCount(p, end, n)) {
+            if (n == 0) {
+                return true;
+            }
+            // Each entry takes at least a byte for its key.
+            if (n > static_cast<size_t>(end - p)) {
+                return false;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (! binary::decode(p, end, k) ||
+                    ! binary::decode(p, end, s[k])) {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * Returns the number of bytes in the Avro binary encoding of \p t.
+ */
+template <typename T>
+size_t encodedSize(const T& t)
+{
+    return binary::size(t);
+}
+
+/**
+ * Encodes \p t into [p, end) in Avro binary format. On success, advances
+ * p past the encoded value and returns true. If the value does not fit,
+ * returns false and leaves p unchanged; the contents of [p, end) are
+ * then unspecified.
+ */
+template <typename T>
+bool encodeBinary(const T& t, uint8_t*& p, uint8_t* end)
+{
+    uint8_t* q = p;
+    if (binary::encode(q, end, t)) {
+        p = q;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Decodes \p t from the Avro binary data in [p, end). On success, advances
+ * p past the decoded value and returns true. If the data ends before the
+ * value does, returns false and leaves p unchanged; \p t is then in a
+ * valid but unspecified state.
+ */
+template <typename T>
+bool decodeBinary(const uint8_t*& p, const uint8_t* end, T& t)
+{
+    const uint8_t* q = p;
+    if (binary::decode(q, end, t)) {
+        p = q;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Encodes \p t onto \p os in Avro binary format. The value is written
+ * straight into the stream's current buffer; if it does not fit there,
+ * it is written through a binary Encoder instead.
+ */
+template <typename T>
+void encodeBinary(OutputStream& os, const T& t)
+{
+    uint8_t* b;
+    size_t n;
+    if (os.next(&b, &n)) {
+        uint8_t* p = b;
+        if (encodeBinary(t, p, b + n)) {
+            os.backup(b + n - p);
+            return;
+        }
+        os.backup(n);
+    }
+
+    EncoderPtr e = binaryEncoder();
+    e->init(os);
+    avro::encode(*e, t);
+    // Re-initializing the encoder returns its unused space to os
+    // without flushing os.
+    std::auto_ptr<OutputStream> none = memoryOutputStream();
+    e->init(*none);
+}
+
+namespace binary {
+
+/**
+ * Decodes \p t from \p is, straight from the stream's current buffer if
+ * \p direct is set and the value lies within it, and otherwise through a
+ * binary Decoder that copies into \p arena, or its own arena if null.
+ */
+template <typename T>
+void decodeStream(InputStream& is, T& t, bool direct, Arena* arena)
+{
+    const uint8_t* b;
+    size_t n;
+    if (direct && is.next(&b, &n)) {
+        const uint8_t* p = b;
+        if (decodeBinary(p, b + n, t)) {
+            is.backup(b + n - p);
+            return;
+        }
+        is.backup(n);
+    }
+
+    DecoderPtr d = arena == 0 ? binaryDecoder() : binaryDecoder(*arena);
+    d->init(is);
+    avro::decode(*d, t);
+    // Re-initializing the decoder returns the bytes it read ahead to is.
+    std::auto_ptr<InputStream> none = memoryInputStream(0, 0);
+    d->init(*none);
+}
+
+}   // namespace binary
+
+/**
+ * Decodes \p t from the Avro binary data on \p is. The value is read
+ * straight from the stream's current buffer; if it continues into the
+ * next buffer, it is read through a binary Decoder instead.
+ */
+template <typename T>
+void decodeBinary(InputStream& is, T& t)
+{
+    // Views decoded here could outlive the memory they refer to. Decode
+    // types that hold them with the version below, which takes an Arena.
+    BOOST_STATIC_ASSERT(! holds_views<T>::value);
+    binary::decodeStream(is, t, true, 0);
+}
+
+/**
+ * Decodes \p t, which may hold views, from the Avro binary data on \p is.
+ * The views refer to the stream's buffers if the stream is stable, and
+ * otherwise to copies in \p arena, so they are valid for as long as both
+ * the stream and the arena's current contents are.
+ */
+template <typename T>
+void decodeBinary(InputStream& is, T& t, Arena& arena)
+{
+    binary::decodeStream(is, t, is.stable(), &arena);
+}
+
+}   // namespace avro
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BinaryComparator_hh__
+#define avro_BinaryComparator_hh__
+
+#include <vector>
+
+#include "Config.hh"
+#include "SchemaTable.hh"
+#include "ValidSchema.hh"
+
+/// \file
+///
+/// Comparison of Avro binary-encoded values without decoding them.
+
+namespace avro {
+
+/**
+ * Compares two values of one schema in the Avro sort order, directly on
+ * their binary encodings, the way GenericComparator compares them decoded.
+ * Nothing is built: the comparison reads both values side by side and
+ * stops at the first difference, reading no further. Bytes, fixeds and
+ * strings compare with memcmp() on the encoded bytes; fields whose order
+ * is "ignore" are skipped over, a whole block at a time where the encoder
+ * wrote block sizes.
+ *
+ * Maps have no order, so comparing values that hold maps, other than in
+ * ignored fields, throws.
+ */
+class AVRO_DECL BinaryComparator {
+    const SchemaTable table_;
+    // Whether the values of each node of table_ encode to no bytes at all.
+    std::vector<bool> zeroWidth_;
+
+    class Cursor;
+    int compare(size_t n, Cursor& a, Cursor& b) const;
+    void skip(size_t n, Cursor& c) const;
+
+public:
+    /**
+     * Constructs a comparator for values of the given schema.
+     */
+    explicit BinaryComparator(const ValidSchema& schema);
+
+    /**
+     * Returns a negative number, zero or a positive number as the value
+     * encoded in the \p na bytes at \p a orders before, with or after the
+     * one in the \p nb bytes at \p b. Throws if a value runs past its
+     * bytes; bytes after the end of a value are not looked at.
+     */
+    int compare(const uint8_t* a, size_t na,
+        const uint8_t* b, size_t nb) const;
+};
+
+}   // namespace avro
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_ChunkPool_hh__
+#define avro_ChunkPool_hh__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "boost/shared_ptr.hpp"
+#include "boost/utility.hpp"
+
+#include "Config.hh"
+
+namespace avro {
+
+/**
+ * Usage statistics of a ChunkPool.
+ */
+struct ChunkPoolStats {
+    /**
+     * The number of chunks handed out and not yet released.
+     */
+    size_t live;
+
+    /**
+     * The number of released chunks held by the pool for reuse.
+     */
+    size_t pooled;
+
+    /**
+     * The number of chunks the pool has obtained from the global
+     * allocator over its lifetime.
+     */
+    size_t allocated;
+};
+
+/**
+ * The allocator for the memory chunks that back memory output streams
+ * and the buffers of the buffer library.
+ *
+ * Implementations must be thread-safe. A chunk is always released to the
+ * pool it was allocated from, with the size it was allocated with.
+ */
+class AVRO_DECL ChunkPool : boost::noncopyable {
+protected:
+    /**
+     * An empty constuctor.
+     */
+    ChunkPool() { }
+
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~ChunkPool() { }
+
+    /**
+     * Returns a chunk of at least \p size bytes.
+     */
+    virtual uint8_t* allocate(size_t size) = 0;
+
+    /**
+     * Returns the chunk \p chunk, obtained from allocate() with the
+     * given \p size, to the pool.
+     */
+    virtual void release(uint8_t* chunk, size_t size) = 0;
+
+    /**
+     * Returns the current statistics of this pool.
+     */
+    virtual ChunkPoolStats stats() const = 0;
+};
+
+typedef boost::shared_ptr<ChunkPool> ChunkPoolPtr;
+
+/**
+ * Returns a new pool that keeps released chunks for reuse.
+ *
+ * Chunk sizes are rounded up to size classes, powers of two from 1 KB to
+ * 64 KB; larger chunks are not pooled. Each thread keeps up to
+ * \p threadCacheSize chunks per size class to itself, so that most
+ * allocations and releases need no locking. The chunks beyond that are
+ * kept in a shared pool of at most \p maxPooledBytes bytes; any more are
+ * returned to the global allocator.
+ */
+AVRO_DECL ChunkPoolPtr cachingChunkPool(
+    size_t maxPooledBytes = 64 * 1024 * 1024, size_t threadCacheSize = 64);
+
+/**
+ * Returns a new pool that does not pool at all, but allocates every
+ * chunk from and releases it to the global allocator.
+ */
+AVRO_DECL ChunkPoolPtr newDeleteChunkPool();
+
+/**
+ * Returns the pool used for the chunks allocated from now on. Unless
+ * replaced with setChunkPool(), this is a caching pool with the default
+ * limits.
+ */
+AVRO_DECL ChunkPoolPtr chunkPool();
+
+#ifndef _WIN32
+/**
+ * Returns the pool chunkPool() would, as the calling thread last saw it.
+ * It takes no lock and copies no pointer unless setChunkPool() has been
+ * called since. The reference is valid until the thread calls this again
+ * or exits.
+ */
+AVRO_DECL const ChunkPoolPtr& threadChunkPool();
+#endif
+
+/**
+ * Installs \p pool as the pool for the chunks allocated from now on.
+ * Chunks that are already allocated are released to the pool they came
+ * from. This may be called while other threads allocate chunks.
+ *
+ * Each thread keeps the pool it last allocated from, so a pool that was
+ * replaced goes away, with the chunks it keeps for reuse, once none of
+ * its chunks is live and every thread that used it has allocated again
+ * or exited.
+ */
+AVRO_DECL void setChunkPool(const ChunkPoolPtr& pool);
+
+}   // namespace avro
+
+#endif
@@ -22,6 +22,10 @@
 #include "Config.hh"
 #include <stdint.h>
 #include <istream>
+#include <memory>
+#include <string>
+
+#include "boost/utility.hpp"
 
 namespace avro {
 
@@ -48,6 +52,9 @@ AVRO_DECL void compileJsonSchema(std::istream &is, ValidSchema &schema);
 AVRO_DECL bool compileJsonSchema(std::istream &is, ValidSchema &schema,
     std::string &error);
 
+/// Compiles the JSON schema at the current position of \p is. Only the
+/// schema is read; whatever follows it is left in the stream.
+
 AVRO_DECL ValidSchema compileJsonSchemaFromStream(InputStream& is);
 
 AVRO_DECL ValidSchema compileJsonSchemaFromMemory(const uint8_t* input, size_t len);
@@ -58,6 +65,46 @@ AVRO_DECL ValidSchema compileJsonSchemaFromString(const std::string& input);
 
 AVRO_DECL ValidSchema compileJsonSchemaFromFile(const char* filename);
 
+/// Returns the schema with the given \p fingerprint, compiling it from
+/// \p json the first time it is asked for. The schemas are kept for the
+/// lifetime of the program, and may be asked for from several threads at
+/// once. The schema_traits avrogencpp generates use this.
+
+AVRO_DECL const ValidSchema& compiledSchema(uint64_t fingerprint,
+    const char* json);
+
+/// A cache of compiled schemas, for programs that compile the same few
+/// schemas over and over, say from message headers. It holds up to a given
+/// number of schemas, keyed by their JSON text; when full, it forgets the
+/// one used least recently. A SchemaCache can be shared between threads.
+///
+/// The schemas handed out share their nodes with the cached copy; being
+/// valid schemas, those are locked against modification.
+
+class AVRO_DECL SchemaCache : boost::noncopyable {
+    class Impl;
+    std::auto_ptr<Impl> impl_;
+
+public:
+    /// Constructs a cache that holds up to \p capacity schemas.
+    explicit SchemaCache(size_t capacity = 64);
+
+    ~SchemaCache();
+
+    /// Returns the schema for the given JSON text, compiling it only if it
+    /// is not in the cache. Throws if the schema cannot be compiled; texts
+    /// that fail are not cached.
+    ValidSchema compile(const uint8_t* input, size_t len);
+
+    ValidSchema compile(const std::string& input);
+
+    /// Returns the number of schemas in the cache.
+    size_t size() const;
+
+    /// Empties the cache.
+    void clear();
+};
+
 } // namespace avro
 
 #endif
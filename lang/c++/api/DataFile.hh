@@ -49,6 +49,7 @@ class AVRO_DECL DataFileWriterBase : boost::noncopyable {
     const std::string filename_;
     const ValidSchema schema_;
     const EncoderPtr encoderPtr_;
+    const EncoderPtr dataEncoderPtr_;
     const size_t syncInterval_;
 
     std::auto_ptr<OutputStream> stream_;
@@ -73,9 +74,9 @@ class AVRO_DECL DataFileWriterBase : boost::noncopyable {
 
 public:
     /**
-     * Returns the current encoder for this writer.
+     * Returns the encoder through which data is written.
      */
-    Encoder& encoder() const { return *encoderPtr_; }
+    Encoder& encoder() const { return *dataEncoderPtr_; }
     
     /**
      * Returns true if the buffer has sufficient data for a sync to be
@@ -91,9 +92,11 @@ public:
     }
     /**
      * Constructs a data file writer with the given sync interval and name.
+     * Data is written through \p encoder, which must be a binary encoder
+     * or wrap one; if it is null, a plain binary encoder is used.
      */
     DataFileWriterBase(const char* filename, const ValidSchema& schema,
-        size_t syncInterval);
+        size_t syncInterval, const EncoderPtr& encoder = EncoderPtr());
 
     ~DataFileWriterBase();
     /**
@@ -119,13 +122,23 @@ public:
 template <typename T>
 class DataFileWriter : boost::noncopyable {
     std::auto_ptr<DataFileWriterBase> base_;
+
+    static EncoderPtr makeEncoder(const ValidSchema& schema) {
+        return has_schema_fingerprint<T>::value ?
+            checkedEncoder<T>(schema, binaryEncoder()) : binaryEncoder();
+    }
 public:
     /**
      * Constructs a new data file.
+     * If T was generated by avrogencpp, its schema's fingerprint is
+     * compared with that of \p schema here. If they differ, every datum
+     * written is validated against \p schema; if they match, none needs
+     * to be.
      */
     DataFileWriter(const char* filename, const ValidSchema& schema,
         size_t syncInterval = 16 * 1024) :
-        base_(new DataFileWriterBase(filename, schema, syncInterval)) { }
+        base_(new DataFileWriterBase(filename, schema, syncInterval,
+            makeEncoder(schema))) { }
 
     /**
      * Writes the given piece of data into the file.
@@ -158,9 +171,12 @@ public:
  */
 class AVRO_DECL DataFileReaderBase : boost::noncopyable {
     const std::string filename_;
-    const std::auto_ptr<InputStream> stream_;
+    const std::auto_ptr<SeekableInputStream> stream_;
     const DecoderPtr decoder_;
     int64_t objectCount_;
+    bool eof_;
+    int64_t blockStart_;
+    int64_t blockEnd_;
 
     ValidSchema readerSchema_;
     ValidSchema dataSchema_;
@@ -174,6 +190,7 @@ class AVRO_DECL DataFileReaderBase : boost::noncopyable {
     void readHeader();
 
     bool readDataBlock();
+    void doSeek(int64_t position);
 public:
     /**
      * Returns the current decoder for this reader.
@@ -227,6 +244,50 @@ public:
      * Closes the reader. No further operation is possible on this reader.
      */
     void close();
+
+    /**
+     * Discards the objects yet to be read in the current block. Reading
+     * resumes with the next block and the payload of the discarded
+     * objects is skipped over rather than read.
+     */
+    void skipBlock();
+
+    /**
+     * Returns the number of objects from the current position to the
+     * end of the file. Only the block headers are read, the payloads
+     * are skipped over. The reader is left at the end of the file.
+     */
+    int64_t countRecords();
+
+    /**
+     * Moves to a specific sync point previously obtained through
+     * previousSync().
+     */
+    void seek(int64_t position);
+
+    /**
+     * Moves to the first sync point at or after \p position. Reading
+     * resumes with the block that follows that sync point. If there is
+     * no such sync point, the reader is positioned at the end of the file.
+     */
+    void sync(int64_t position);
+
+    /**
+     * Returns true if the current block starts past the sync marker that
+     * begins at or after \p position, or if the end of file is reached.
+     *
+     * Together with sync() this allows a file to be split into byte
+     * ranges [start, end) processed independently: call sync(start) and
+     * read while ! pastSync(end). Every block is read by exactly one
+     * such range.
+     */
+    bool pastSync(int64_t position);
+
+    /**
+     * Returns the position at which the current block starts, that is,
+     * the position just past the sync marker that precedes it.
+     */
+    int64_t previousSync();
 };
 
 /**
@@ -310,6 +371,39 @@ public:
      * Closes the reader. No further operation is possible on this reader.
      */
     void close() { return base_->close(); }
+
+    /**
+     * Discards the objects yet to be read in the current block.
+     */
+    void skipBlock() { base_->skipBlock(); }
+
+    /**
+     * Returns the number of objects from the current position to the
+     * end of the file, reading only the block headers.
+     */
+    int64_t countRecords() { return base_->countRecords(); }
+
+    /**
+     * Moves to a specific sync point previously obtained through
+     * previousSync().
+     */
+    void seek(int64_t position) { base_->seek(position); }
+
+    /**
+     * Moves to the first sync point at or after \p position.
+     */
+    void sync(int64_t position) { base_->sync(position); }
+
+    /**
+     * Returns true if the current block starts past the sync marker that
+     * begins at or after \p position, or if the end of file is reached.
+     */
+    bool pastSync(int64_t position) { return base_->pastSync(position); }
+
+    /**
+     * Returns the position at which the current block starts.
+     */
+    int64_t previousSync() { return base_->previousSync(); }
 };
 
 }   // namespace avro
@@ -23,9 +23,12 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "ValidSchema.hh"
 #include "Stream.hh"
+#include "View.hh"
+#include "Exception.hh"
 
 #include <boost/shared_ptr.hpp>
 
@@ -87,6 +90,16 @@ public:
     /// Skips a string on the current stream.
     virtual void skipString() = 0;
 
+    /**
+     * Decodes a string into a view instead of a copy. Where the decoder can,
+     * the view refers to the input itself; otherwise it refers to memory the
+     * decoder owns until it is next initialized, or to the arena it was
+     * created with. The default implementation throws.
+     */
+    virtual void decodeStringView(StringView& value) {
+        throw Exception("This decoder does not support views");
+    }
+
     /// Decodes arbitray binary data from the current stream.
     std::vector<uint8_t> decodeBytes() {
         std::vector<uint8_t> result;
@@ -101,6 +114,12 @@ public:
     /// Skips bytes on the current stream.
     virtual void skipBytes() = 0;
 
+    /// Decodes binary data into a view, in the same manner as
+    /// decodeStringView().
+    virtual void decodeBytesView(BytesView& value) {
+        throw Exception("This decoder does not support views");
+    }
+
     /**
      * Decodes fixed length binary from the current stream.
      * \param[in] n The size (byte count) of the fixed being read.
@@ -121,6 +140,19 @@ public:
      */
     virtual void decodeFixed(size_t n, std::vector<uint8_t>& value) = 0;
 
+    /**
+     * Decodes a fixed from the current stream directly into the given
+     * storage.
+     * \param[in] n The size (byte count) of the fixed being read.
+     * \param[out] value The storage that receives the fixed. It must have
+     * room for at least \p n bytes.
+     */
+    virtual void decodeFixed(size_t n, uint8_t* value) {
+        std::vector<uint8_t> v;
+        decodeFixed(n, v);
+        std::copy(v.begin(), v.end(), value);
+    }
+
     /// Skips fixed length binary on the current stream.
     virtual void skipFixed(size_t n) = 0;
 
@@ -158,6 +190,15 @@ public:
     /// the parse tree. Needed for resolving decoders where the code generated by a
     /// reader schema has fewer fields than the writer's schema
     virtual size_t doSkip() = 0;
+
+    /// Returns the order in which the fields of the record about to be
+    /// decoded come, as ResolvingDecoder::fieldOrder() does, or null if
+    /// they come in the order of the schema. Code generated by avrogencpp
+    /// calls it at the start of each record with more than one field, so
+    /// that decoders other than resolving ones pay only for the call.
+    virtual const std::vector<size_t>* recordFieldOrder() {
+        return 0;
+    }
 };
 
 /**
@@ -176,7 +217,14 @@ public:
     /// order in the schema because the writer's field order could
     /// be different. In order to avoid buffering and later use,
     /// we return the values in the writer's field order.
+    /// It must be called at the start of each record. The vector returned
+    /// belongs to the decoder and stays valid for as long as the decoder
+    /// does.
     virtual const std::vector<size_t>& fieldOrder() = 0;
+
+    const std::vector<size_t>* recordFieldOrder() {
+        return &fieldOrder();
+    }
 };
 
 /**
@@ -185,9 +233,22 @@ public:
 typedef boost::shared_ptr<ResolvingDecoder> ResolvingDecoderPtr;
 /**
  *  Returns an decoder that can decode binary Avro standard.
+ *  Strings and bytes decoded into views that cannot refer to the input,
+ *  because it is not stable, are copied into memory the decoder keeps
+ *  until it is next initialized. That memory grows with every such view,
+ *  so a decoder that decodes views from an unstable stream for a long
+ *  time should be initialized again now and then, or be given an arena
+ *  that its user clears.
  */
 AVRO_DECL DecoderPtr binaryDecoder();
 
+/**
+ *  Returns an decoder that can decode binary Avro standard, and that copies
+ *  strings and bytes decoded into views, when they cannot refer to the
+ *  input, into the given arena. The arena must outlive the decoder.
+ */
+AVRO_DECL DecoderPtr binaryDecoder(Arena& arena);
+
 /**
  *  Returns an decoder that validates sequence of calls to an underlying
  *  Decoder against the given schema.
@@ -197,6 +258,8 @@ AVRO_DECL DecoderPtr validatingDecoder(const ValidSchema& schema,
 
 /**
  *  Returns an decoder that can decode Avro standard for JSON.
+ *  Every string and bytes decoded into a view is copied into memory the
+ *  decoder keeps until it is next initialized, and which grows until then.
  */
 AVRO_DECL DecoderPtr jsonDecoder(const ValidSchema& schema);
 
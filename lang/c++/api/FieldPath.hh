@@ -0,0 +1,129 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_FieldPath_hh__
+#define avro_FieldPath_hh__
+
+#include <string>
+#include <vector>
+
+#include "Config.hh"
+#include "Generic.hh"
+#include "ValidSchema.hh"
+
+/// \file
+///
+/// Access to values nested in generic records by precompiled paths.
+
+namespace avro {
+
+/**
+ * A path from a generic datum of a given schema to a value nested in it,
+ * through the fields of records. The path is resolved against the schema
+ * once, when it is made, into a list of field positions; following it
+ * into a datum then costs an index per step.
+ *
+ * Paths are field names separated by dots, as in "a.b.c". Where the path
+ * goes through a union, the branch to take is the one record that has the
+ * next field; it can be named instead by putting the branch's type name,
+ * or its position, in brackets after the field, as in "a[com.x.R].b" or
+ * "a[1].b". A path can end with a branch, to select only values in that
+ * branch. If the datum holds another branch of a union on the way, the
+ * value is not there.
+ *
+ * A path only works with data made from the schema it was resolved
+ * against.
+ */
+class AVRO_DECL FieldPath {
+    enum Kind {
+        // Go to the field at index of the record.
+        FIELD,
+        // Check that the union is in the branch at index.
+        BRANCH
+    };
+
+    struct Step {
+        Kind kind;
+        size_t index;
+    };
+
+    std::string path_;
+    std::vector<Step> steps_;
+
+    template <typename D>
+    D* follow(D* d) const;
+
+public:
+    /**
+     * Resolves \p path against \p schema. Throws if the path names a field
+     * or branch the schema does not have.
+     */
+    FieldPath(const ValidSchema& schema, const std::string& path);
+
+    /**
+     * Returns the path as given.
+     */
+    const std::string& path() const {
+        return path_;
+    }
+
+    /**
+     * Returns the value at this path in \p d, or null if a union on the
+     * way holds another branch.
+     */
+    const GenericDatum* find(const GenericDatum& d) const {
+        return follow(&d);
+    }
+
+    /**
+     * Returns the value at this path in \p d, which can be used to change
+     * it, or null if a union on the way holds another branch.
+     */
+    GenericDatum* find(GenericDatum& d) const {
+        return follow(&d);
+    }
+
+    /**
+     * Returns the value at this path in \p d. Throws if it is not there.
+     */
+    const GenericDatum& get(const GenericDatum& d) const;
+
+    /**
+     * Returns the value at this path in \p d, which can be used to change
+     * it. Throws if it is not there.
+     */
+    GenericDatum& get(GenericDatum& d) const;
+};
+
+template <typename D>
+D* FieldPath::follow(D* d) const
+{
+    for (std::vector<Step>::const_iterator it = steps_.begin();
+        it != steps_.end(); ++it) {
+        if (it->kind == FIELD) {
+            d = &d->template value<GenericRecord>().fieldAt(it->index);
+        } else if (d->unionBranch() != it->index) {
+            return 0;
+        }
+    }
+    return d;
+}
+
+}   // namespace avro
+
+#endif
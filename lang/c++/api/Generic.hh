@@ -32,8 +32,17 @@
 #include "Encoder.hh"
 #include "Decoder.hh"
 #include "ValidSchema.hh"
+#include "SchemaTable.hh"
+#include "Hash.hh"
+
+#if __cplusplus >= 201103L
+#include <functional>
+#endif
 
 namespace avro {
+
+struct GenericAccess;
+
 /**
  * Generic datum which can hold any Avro type. The datum has a type
  * and a value. The type is one of the Avro data types. The C++ type for
@@ -60,6 +69,8 @@ class AVRO_DECL GenericDatum {
     Type type_;
     boost::any value_;
 
+    friend struct GenericAccess;
+
     GenericDatum(Type t) : type_(t) { }
 
     template <typename T>
@@ -178,6 +189,8 @@ class AVRO_DECL GenericUnion : public GenericContainer {
     size_t curBranch_;
     GenericDatum datum_;
 
+    friend struct GenericAccess;
+
 public:
     /**
      * Constructs a generic union corresponding to the given schema \p schema,
@@ -447,7 +460,15 @@ class AVRO_DECL GenericReader : boost::noncopyable {
     const ValidSchema schema_;
     const bool isResolving_;
     const DecoderPtr decoder_;
-
+    const SchemaTable table_;
+    // A new datum for each entry of table_ that is not symbolic, and for
+    // each union, one with each of its branches selected. Values are read
+    // into copies of these.
+    std::vector<GenericDatum> prototypes_;
+    std::vector<std::vector<GenericDatum> > branches_;
+
+    void init();
+    void read(size_t n, GenericDatum& datum, Decoder& d) const;
     static void read(GenericDatum& datum, Decoder& d, bool isResolving);
 public:
     /**
@@ -486,7 +507,9 @@ public:
 class AVRO_DECL GenericWriter : boost::noncopyable {
     const ValidSchema schema_;
     const EncoderPtr encoder_;
+    const SchemaTable table_;
 
+    void write(size_t n, const GenericDatum& datum, Encoder& e) const;
     static void write(const GenericDatum& datum, Encoder& e);
 public:
     /**
@@ -513,6 +536,96 @@ public:
     }
 };
 
+/**
+ * Returns the number of bytes in the Avro binary encoding of \p datum.
+ */
+AVRO_DECL size_t encodedSize(const GenericDatum& datum);
+
+/**
+ * Compares, tests for equality and hashes generic data of one schema in
+ * the Avro sort order. Records compare field by field, skipping fields
+ * whose order is "ignore" and reversing those whose order is
+ * "descending". Unions compare by branch and then by value, arrays item
+ * by item, and strings, bytes and fixeds byte by byte, as unsigned. Enums
+ * compare by position and numbers by value; -0 equals 0 and NaN equals
+ * NaN, after all other numbers. Maps have no order, so compare() throws
+ * for them, but equals() and hash() accept them, whatever the order of
+ * their entries.
+ *
+ * The schema is flattened once, when the comparator is made, so the data
+ * are not asked for their types as they are walked; they must have been
+ * made from this schema. Hashes are those avro::hash() gives for the
+ * types avrogencpp generates from the schema.
+ */
+class AVRO_DECL GenericComparator {
+    const SchemaTable table_;
+
+public:
+    /**
+     * Constructs a comparator for data of the given schema.
+     */
+    explicit GenericComparator(const ValidSchema& schema);
+
+    /**
+     * Returns a negative number, zero or a positive number as \p a
+     * orders before, with or after \p b.
+     */
+    int compare(const GenericDatum& a, const GenericDatum& b) const;
+
+    /**
+     * Returns true if \p a and \p b are equal in the Avro sort order.
+     */
+    bool equals(const GenericDatum& a, const GenericDatum& b) const;
+
+    /**
+     * Returns a hash of \p d, the same for data that are equal.
+     */
+    size_t hash(const GenericDatum& d) const;
+};
+
+/**
+ * Compares two generic data as GenericComparator does, but without a
+ * schema: the types are read from the data as they are walked. Data of
+ * different types order by type.
+ */
+AVRO_DECL int compare(const GenericDatum& a, const GenericDatum& b);
+
+/**
+ * Tests two generic data for equality as GenericComparator does, but
+ * without a schema.
+ */
+AVRO_DECL bool equals(const GenericDatum& a, const GenericDatum& b);
+
+inline bool operator==(const GenericDatum& a, const GenericDatum& b) {
+    return equals(a, b);
+}
+
+inline bool operator!=(const GenericDatum& a, const GenericDatum& b) {
+    return ! equals(a, b);
+}
+
+/**
+ * Orders generic data for ordered containers. Throws for data with maps.
+ */
+inline bool operator<(const GenericDatum& a, const GenericDatum& b) {
+    return compare(a, b) < 0;
+}
+
+/**
+ * hash_traits for generic data. It hashes as GenericComparator does, but
+ * without a schema.
+ */
+template <> struct AVRO_DECL hash_traits<GenericDatum> {
+    static size_t hash(const GenericDatum& d);
+};
+
+/**
+ * Makes boost::hash work with generic data.
+ */
+inline size_t hash_value(const GenericDatum& d) {
+    return avro::hash(d);
+}
+
 inline Type AVRO_DECL GenericDatum::type() const {
     return (type_ == AVRO_UNION) ?
         boost::any_cast<GenericUnion>(&value_)->type() : type_;
@@ -576,5 +689,22 @@ template <> struct codec_traits<GenericDatum> {
 };
     
 }   // namespace avro
+
+#if __cplusplus >= 201103L
+namespace std {
+
+/**
+ * Makes std::hash, and with it std::unordered containers, work with
+ * generic data.
+ */
+template <> struct hash<avro::GenericDatum> {
+    size_t operator()(const avro::GenericDatum& d) const {
+        return avro::hash(d);
+    }
+};
+
+}   // namespace std
+#endif
+
 #endif
 
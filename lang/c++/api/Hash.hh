@@ -0,0 +1,270 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Hash_hh__
+#define avro_Hash_hh__
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "boost/array.hpp"
+#include "boost/cstdint.hpp"
+
+#include "Config.hh"
+#include "View.hh"
+
+/**
+ * Hashing of specific types, consistent with equality under the Avro sort
+ * order: values that compare equal hash to the same value.
+ *
+ * hash_traits plays the role of codec_traits for hashing. It is specialized
+ * here for the same C++ types as codec_traits, and avrogencpp generates
+ * specializations for records, enums and unions when run with --compare.
+ * The hashes are meant for in-memory containers; they are not stable
+ * across platforms or versions.
+ */
+namespace avro {
+
+/**
+ * Hash_traits tells avro how to hash an object of given type.
+ *
+ * The class is expected to have one static method:
+ * \li static size_t hash(const T& value);
+ * The default is empty.
+ */
+template <typename T>
+struct hash_traits {
+};
+
+/**
+ * Generic hash function that makes use of the hash_traits.
+ */
+template <typename T>
+size_t hash(const T& t) {
+    return hash_traits<T>::hash(t);
+}
+
+namespace hashing {
+
+/**
+ * Scrambles the bits of h so that nearby inputs give unrelated outputs.
+ */
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Folds the hash h of the next component into seed.
+ */
+inline size_t combine(size_t seed, size_t h) {
+    return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * Hashes n bytes at p, eight at a time. This is MurmurHash64A.
+ */
+inline size_t hashBytes(const uint8_t* p, size_t n) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    uint64_t h = 0x8445d61a4e774912ULL ^ (n * m);
+    const uint8_t* end = p + (n & ~static_cast<size_t>(7));
+    for (; p != end; p += 8) {
+        uint64_t k;
+        ::memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    switch (n & 7) {
+    case 7: h ^= static_cast<uint64_t>(p[6]) << 48;
+    case 6: h ^= static_cast<uint64_t>(p[5]) << 40;
+    case 5: h ^= static_cast<uint64_t>(p[4]) << 32;
+    case 4: h ^= static_cast<uint64_t>(p[3]) << 24;
+    case 3: h ^= static_cast<uint64_t>(p[2]) << 16;
+    case 2: h ^= static_cast<uint64_t>(p[1]) << 8;
+    case 1: h ^= static_cast<uint64_t>(p[0]);
+        h *= m;
+    }
+    h ^= h >> 47;
+    h *= m;
+    h ^= h >> 47;
+    return static_cast<size_t>(h);
+}
+
+}   // namespace hashing
+
+/**
+ * hash_traits for Avro boolean.
+ */
+template <> struct hash_traits<bool> {
+    static size_t hash(bool b) {
+        return b ? 1 : 0;
+    }
+};
+
+/**
+ * hash_traits for Avro int.
+ */
+template <> struct hash_traits<int32_t> {
+    static size_t hash(int32_t i) {
+        return static_cast<size_t>(
+            hashing::mix(static_cast<uint64_t>(static_cast<int64_t>(i))));
+    }
+};
+
+/**
+ * hash_traits for Avro long.
+ */
+template <> struct hash_traits<int64_t> {
+    static size_t hash(int64_t l) {
+        return static_cast<size_t>(hashing::mix(static_cast<uint64_t>(l)));
+    }
+};
+
+/**
+ * hash_traits for Avro float.
+ */
+template <> struct hash_traits<float> {
+    static size_t hash(float f) {
+        // 0.0 and -0.0 are equal, so they must hash alike.
+        if (f == 0) {
+            return 0;
+        }
+        uint32_t u;
+        ::memcpy(&u, &f, sizeof(u));
+        return static_cast<size_t>(hashing::mix(u));
+    }
+};
+
+/**
+ * hash_traits for Avro double.
+ */
+template <> struct hash_traits<double> {
+    static size_t hash(double d) {
+        if (d == 0) {
+            return 0;
+        }
+        uint64_t u;
+        ::memcpy(&u, &d, sizeof(u));
+        return static_cast<size_t>(hashing::mix(u));
+    }
+};
+
+/**
+ * hash_traits for Avro string.
+ */
+template <> struct hash_traits<std::string> {
+    static size_t hash(const std::string& s) {
+        return hashing::hashBytes(
+            reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+};
+
+/**
+ * hash_traits for Avro bytes.
+ */
+template <> struct hash_traits<std::vector<uint8_t> > {
+    static size_t hash(const std::vector<uint8_t>& b) {
+        return b.empty() ? hashing::hashBytes(0, 0) :
+            hashing::hashBytes(&b[0], b.size());
+    }
+};
+
+/**
+ * hash_traits for Avro string held in a view. It hashes like std::string.
+ */
+template <> struct hash_traits<StringView> {
+    static size_t hash(const StringView& s) {
+        return hashing::hashBytes(
+            reinterpret_cast<const uint8_t*>(s.data()), s.size());
+    }
+};
+
+/**
+ * hash_traits for Avro bytes held in a view.
+ */
+template <> struct hash_traits<BytesView> {
+    static size_t hash(const BytesView& b) {
+        return hashing::hashBytes(b.data(), b.size());
+    }
+};
+
+/**
+ * hash_traits for Avro fixed.
+ */
+template <size_t N> struct hash_traits<boost::array<uint8_t, N> > {
+    static size_t hash(const boost::array<uint8_t, N>& f) {
+        return hashing::hashBytes(f.data(), N);
+    }
+};
+
+/**
+ * hash_traits for Avro arrays.
+ */
+template <typename T> struct hash_traits<std::vector<T> > {
+    static size_t hash(const std::vector<T>& v) {
+        size_t h = v.size();
+        for (typename std::vector<T>::const_iterator it = v.begin();
+            it != v.end(); ++it) {
+            h = hashing::combine(h, avro::hash(*it));
+        }
+        return h;
+    }
+};
+
+/**
+ * hash_traits for Avro arrays of booleans.
+ */
+template <> struct hash_traits<std::vector<bool> > {
+    static size_t hash(const std::vector<bool>& v) {
+        size_t h = v.size();
+        for (std::vector<bool>::const_iterator it = v.begin();
+            it != v.end(); ++it) {
+            h = hashing::combine(h, *it ? 1 : 0);
+        }
+        return h;
+    }
+};
+
+/**
+ * hash_traits for Avro maps. std::map keeps its entries sorted, so equal
+ * maps are visited in the same order.
+ */
+template <typename T> struct hash_traits<std::map<std::string, T> > {
+    static size_t hash(const std::map<std::string, T>& m) {
+        size_t h = m.size();
+        for (typename std::map<std::string, T>::const_iterator it = m.begin();
+            it != m.end(); ++it) {
+            h = hashing::combine(h, avro::hash(it->first));
+            h = hashing::combine(h, avro::hash(it->second));
+        }
+        return h;
+    }
+};
+
+}   // namespace avro
+
+#endif
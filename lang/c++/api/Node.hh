@@ -132,6 +132,12 @@ class AVRO_DECL Node : private boost::noncopyable
     virtual const std::string &nameAt(int index) const = 0;
     virtual bool nameIndex(const std::string &name, size_t &index) const = 0;
 
+    /// Returns the sort order of the field at index. Only records have
+    /// fields whose order is not ascending.
+    virtual SortOrder sortOrderAt(int index) const {
+        return AVRO_ASCENDING;
+    }
+
     void setFixedSize(int size) {
         checkLock();
         doSetFixedSize(size);
@@ -24,6 +24,7 @@
 #include <vector>
 #include <map>
 #include "Exception.hh"
+#include "Hash.hh"
 
 namespace avro {
 
@@ -189,33 +190,84 @@ struct NameIndexConcept {
     }
 };
 
+/// Field names and enum symbols are looked up in an open-addressing hash
+/// table, with linear probing, kept at most half full. The hash of each
+/// name is stored with it, so that probes compare strings only when the
+/// hashes agree, and growing the table does not hash the names again.
 template<>
 struct NameIndexConcept < MultiAttribute<std::string> > 
 {
-    typedef std::map<std::string, size_t> IndexMap;
-
     bool lookup(const std::string &name, size_t &index) const {
-        IndexMap::const_iterator iter = map_.find(name); 
-        if(iter == map_.end()) {
+        size_t pos;
+        if (! find(name, hashOf(name), pos)) {
             return false;
         }
-        index = iter->second;
+        index = entries_[slots_[pos] - 1].index;
         return true;
     }
 
     bool add(const::std::string &name, size_t index) {
-        bool added = false;
-        IndexMap::iterator lb = map_.lower_bound(name); 
-        if(lb == map_.end() || map_.key_comp()(name, lb->first)) {
-            map_.insert(lb, IndexMap::value_type(name, index));
-            added = true;
+        const size_t h = hashOf(name);
+        size_t pos;
+        if (find(name, h, pos)) {
+            return false;
         }
-        return added;
+        Entry e = { name, h, index };
+        entries_.push_back(e);
+        if (entries_.size() * 2 > slots_.size()) {
+            rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        } else {
+            slots_[pos] = entries_.size();
+        }
+        return true;
     }
 
   private:
 
-    IndexMap map_;
+    struct Entry {
+        std::string name;
+        size_t hash;
+        size_t index;
+    };
+
+    static size_t hashOf(const std::string &name) {
+        return hashing::hashBytes(
+            reinterpret_cast<const uint8_t*>(name.data()), name.size());
+    }
+
+    /// Sets pos to the slot holding name, and returns true, or to the
+    /// empty slot where it would go, and returns false. Before the table
+    /// is first grown, pos is 0.
+    bool find(const std::string &name, size_t h, size_t &pos) const {
+        pos = 0;
+        if (slots_.empty()) {
+            return false;
+        }
+        const size_t mask = slots_.size() - 1;
+        for (pos = h & mask; slots_[pos] != 0; pos = (pos + 1) & mask) {
+            const Entry &e = entries_[slots_[pos] - 1];
+            if (e.hash == h && e.name == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void rehash(size_t n) {
+        slots_.assign(n, 0);
+        const size_t mask = n - 1;
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            size_t pos = entries_[i].hash & mask;
+            while (slots_[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            slots_[pos] = i + 1;
+        }
+    }
+
+    std::vector<Entry> entries_;
+    // One more than the position in entries_, or 0 for an empty slot.
+    std::vector<size_t> slots_;
 };
 
 } // namespace concepts
@@ -23,6 +23,7 @@
 
 #include <limits>
 #include <set>
+#include <vector>
 #include <boost/weak_ptr.hpp>
 
 #include "Node.hh"
@@ -269,8 +270,10 @@ class AVRO_DECL NodeRecord : public NodeImplRecord
         NodeImplRecord(AVRO_RECORD) 
     { }
 
-    NodeRecord(const HasName &name, const MultiLeaves &fields, const LeafNames &fieldsNames) :
-        NodeImplRecord(AVRO_RECORD, name, fields, fieldsNames, NoSize())
+    NodeRecord(const HasName &name, const MultiLeaves &fields, const LeafNames &fieldsNames,
+        const std::vector<SortOrder> &sortOrders = std::vector<SortOrder>()) :
+        NodeImplRecord(AVRO_RECORD, name, fields, fieldsNames, NoSize()),
+        sortOrders_(sortOrders)
     { 
         for(size_t i=0; i < leafNameAttributes_.size(); ++i) {
             if(!nameIndex_.add(leafNameAttributes_.get(i), i)) {
@@ -281,6 +284,12 @@ class AVRO_DECL NodeRecord : public NodeImplRecord
 
     void swap(NodeRecord& r) {
         NodeImplRecord::swap(r);
+        sortOrders_.swap(r.sortOrders_);
+    }
+
+    SortOrder sortOrderAt(int index) const {
+        return static_cast<size_t>(index) < sortOrders_.size() ?
+            sortOrders_[index] : AVRO_ASCENDING;
     }
 
     SchemaResolution resolve(const Node &reader)  const;
@@ -293,6 +302,10 @@ class AVRO_DECL NodeRecord : public NodeImplRecord
                 (leafAttributes_.size() == leafNameAttributes_.size())
                );
     }
+
+  private:
+
+    std::vector<SortOrder> sortOrders_;
 };
 
 class AVRO_DECL NodeEnum : public NodeImplEnum
@@ -0,0 +1,174 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_SchemaTable_hh__
+#define avro_SchemaTable_hh__
+
+#include <string>
+#include <vector>
+
+#include "Config.hh"
+#include "Node.hh"
+#include "Types.hh"
+#include "ValidSchema.hh"
+
+namespace avro {
+
+/**
+ * A flattened, read-only copy of a ValidSchema, for code that walks a
+ * schema over and over. The nodes sit in one array, in depth-first order
+ * with the root first, and refer to their leaves by index; field names,
+ * enum symbols and type names are kept once each in a shared pool.
+ *
+ * A reference to a named type defined elsewhere in the schema keeps an
+ * entry of type AVRO_SYMBOLIC, so that walkers can tell it from the
+ * definition, but it points straight at the definition: resolve() costs
+ * an array lookup rather than locking a weak pointer.
+ */
+class AVRO_DECL SchemaTable {
+    struct Entry {
+        Type type;
+        size_t fixedSize;
+        // Index of the name in names_, or npos.
+        size_t name;
+        // The definition of a symbolic entry, or the entry itself.
+        size_t target;
+        size_t firstLeaf;
+        size_t leafCount;
+        size_t firstLabel;
+        size_t labelCount;
+    };
+
+    std::vector<Entry> entries_;
+    // The leaves of every entry, each entry's contiguous.
+    std::vector<size_t> leaves_;
+    // The sort order of each leaf, ascending but for record fields.
+    std::vector<SortOrder> orders_;
+    // Field names and enum symbols, as indices into names_.
+    std::vector<size_t> labels_;
+    std::vector<std::string> names_;
+    std::vector<NodePtr> nodes_;
+
+    class Builder;
+
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * Flattens the given schema.
+     */
+    explicit SchemaTable(const ValidSchema& schema);
+
+    /**
+     * Returns the index of the root, which is always 0.
+     */
+    size_t root() const {
+        return 0;
+    }
+
+    /**
+     * Returns the number of entries.
+     */
+    size_t size() const {
+        return entries_.size();
+    }
+
+    /**
+     * Returns the type of entry \p n, which is AVRO_SYMBOLIC for a
+     * reference to a named type.
+     */
+    Type type(size_t n) const {
+        return entries_[n].type;
+    }
+
+    /**
+     * Returns \p n, or the entry it refers to if \p n is symbolic.
+     */
+    size_t resolve(size_t n) const {
+        return entries_[n].target;
+    }
+
+    /**
+     * Returns the number of leaves of entry \p n: the fields of a record,
+     * the branches of a union, one for the items of an array and two, key
+     * and value, for a map.
+     */
+    size_t leaves(size_t n) const {
+        return entries_[n].leafCount;
+    }
+
+    /**
+     * Returns the index of leaf \p i of entry \p n.
+     */
+    size_t leafAt(size_t n, size_t i) const {
+        return leaves_[entries_[n].firstLeaf + i];
+    }
+
+    /**
+     * Returns the sort order of field \p i of record entry \p n.
+     */
+    SortOrder sortOrderAt(size_t n, size_t i) const {
+        return orders_[entries_[n].firstLeaf + i];
+    }
+
+    /**
+     * Returns the number of field names of a record, or symbols of an enum.
+     */
+    size_t names(size_t n) const {
+        return entries_[n].labelCount;
+    }
+
+    /**
+     * Returns field name or symbol \p i of entry \p n.
+     */
+    const std::string& nameAt(size_t n, size_t i) const {
+        return names_[labels_[entries_[n].firstLabel + i]];
+    }
+
+    /**
+     * Returns true if entry \p n is of a named type, or refers to one.
+     */
+    bool hasName(size_t n) const {
+        return entries_[n].name != npos;
+    }
+
+    /**
+     * Returns the full name of entry \p n, which must have one.
+     */
+    const std::string& name(size_t n) const {
+        return names_[entries_[n].name];
+    }
+
+    /**
+     * Returns the size of a fixed.
+     */
+    size_t fixedSize(size_t n) const {
+        return entries_[n].fixedSize;
+    }
+
+    /**
+     * Returns the node that entry \p n was made from.
+     */
+    const NodePtr& node(size_t n) const {
+        return nodes_[n];
+    }
+};
+
+} // namespace avro
+
+#endif
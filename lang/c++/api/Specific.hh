@@ -171,7 +171,7 @@ template <> struct codec_traits<std::string> {
      * Decodes into a given value.
      */
     static void decode(Decoder& d, std::string& s) {
-        s = d.decodeString();
+        d.decodeString(s);
     }
 };
 
@@ -194,6 +194,47 @@ template <> struct codec_traits<std::vector<uint8_t> > {
     }
 };
 
+/**
+ * codec_traits for Avro string, decoded without a copy where the decoder
+ * can. See Decoder::decodeStringView() for how long the view is valid.
+ */
+template <> struct codec_traits<StringView> {
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder& e, const StringView& s) {
+        e.encodeString(toString(s));
+    }
+
+    /**
+     * Decodes into a given value.
+     */
+    static void decode(Decoder& d, StringView& s) {
+        d.decodeStringView(s);
+    }
+};
+
+/**
+ * codec_traits for Avro bytes, decoded without a copy where the decoder
+ * can.
+ */
+template <> struct codec_traits<BytesView> {
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder& e, const BytesView& b) {
+        uint8_t dummy = 0;
+        e.encodeBytes(b.empty() ? &dummy : b.data(), b.size());
+    }
+
+    /**
+     * Decodes into a given value.
+     */
+    static void decode(Decoder& d, BytesView& b) {
+        d.decodeBytesView(b);
+    }
+};
+
 /**
  * codec_traits for Avro fixed.
  */
@@ -209,9 +250,7 @@ template <size_t N> struct codec_traits<boost::array<uint8_t, N> > {
      * Decodes into a given value.
      */
     static void decode(Decoder& d, boost::array<uint8_t, N>& s) {
-        std::vector<uint8_t> v(N);
-        d.decodeFixed(N, v);
-        std::copy(&v[0], &v[0] + N, &s[0]);
+        d.decodeFixed(N, s.c_array());
     }
 };
 
@@ -236,15 +275,54 @@ template <typename T> struct codec_traits<std::vector<T> > {
     }
 
     /**
-     * Decodes into a given value.
+     * Decodes into a given value. The elements are decoded in place and
+     * those already in \p s are reused, along with any storage they own.
+     * The vector grows as items arrive rather than to the count in the
+     * data, which cannot be trusted.
      */
     static void decode(Decoder& d, std::vector<T>& s) {
+        size_t pos = 0;
+        for (size_t n = d.arrayStart(); n != 0; n = d.arrayNext()) {
+            for (size_t i = 0; i < n; ++i, ++pos) {
+                if (pos == s.size()) {
+                    s.resize(pos + 1);
+                }
+                avro::decode(d, s[pos]);
+            }
+        }
+        s.resize(pos);
+    }
+};
+
+/**
+ * codec_traits for Avro arrays of booleans. std::vector<bool> does not
+ * hand out references to its elements, so they cannot be decoded in place.
+ */
+template <> struct codec_traits<std::vector<bool> > {
+    /**
+     * Encodes a given value.
+     */
+    static void encode(Encoder& e, const std::vector<bool>& b) {
+        e.arrayStart();
+        if (! b.empty()) {
+            e.setItemCount(b.size());
+            for (std::vector<bool>::const_iterator it = b.begin();
+                it != b.end(); ++it) {
+                e.startItem();
+                e.encodeBool(*it);
+            }
+        }
+        e.arrayEnd();
+    }
+
+    /**
+     * Decodes into a given value.
+     */
+    static void decode(Decoder& d, std::vector<bool>& s) {
         s.clear();
         for (size_t n = d.arrayStart(); n != 0; n = d.arrayNext()) {
             for (size_t i = 0; i < n; ++i) {
-                T t;
-                avro::decode(d, t);
-                s.push_back(t);
+                s.push_back(d.decodeBool());
             }
         }
     }
@@ -273,22 +351,108 @@ template <typename T> struct codec_traits<std::map<std::string, T> > {
     }
 
     /**
-     * Decodes into a given value.
+     * Decodes into a given value. Each value is decoded directly into
+     * its map entry.
      */
     static void decode(Decoder& d, std::map<std::string, T>& s) {
         s.clear();
+        std::string k;
         for (size_t n = d.mapStart(); n != 0; n = d.mapNext()) {
             for (size_t i = 0; i < n; ++i) {
-                std::string k;
                 avro::decode(d, k);
-                T t;
-                avro::decode(d, t);
-                s[k] = t;
+                avro::decode(d, s[k]);
             }
         }
     }
 };
 
+/**
+ * Schema_traits gives the Avro schema of a type. avrogencpp specializes it
+ * for the top-level type of each schema it compiles, with:
+ * \li static const uint64_t fingerprint; the 64-bit Rabin fingerprint of
+ * the schema's Parsing Canonical Form, known at compile time;
+ * \li static const char* json(); the schema as given to avrogencpp;
+ * \li static const ValidSchema& schema(); the schema compiled on first use,
+ * with compiledSchema(), which is safe to call from several threads.
+ * The default is empty.
+ */
+template <typename T>
+struct schema_traits {
+};
+
+/**
+ * Base class for schema_traits specializations that supplies the
+ * fingerprint constant with a definition, so that it can be bound to
+ * references from a header included in many translation units.
+ */
+template <uint64_t F>
+struct static_fingerprint {
+    static const uint64_t fingerprint = F;
+};
+
+template <uint64_t F>
+const uint64_t static_fingerprint<F>::fingerprint;
+
+/**
+ * has_schema_fingerprint<T>::value is true if schema_traits<T> has a
+ * fingerprint, that is, if T was generated by avrogencpp.
+ */
+template <typename T>
+class has_schema_fingerprint {
+    typedef char yes[1];
+    typedef char no[2];
+
+    template <typename U, const uint64_t*> struct check;
+    template <typename U>
+    static yes& test(check<U, &schema_traits<U>::fingerprint>*);
+    template <typename U>
+    static no& test(...);
+public:
+    static const bool value = sizeof(test<T>(0)) == sizeof(yes);
+};
+
+namespace detail {
+
+template <typename T, bool known = has_schema_fingerprint<T>::value>
+struct conformance {
+    static bool check(const ValidSchema&) {
+        return false;
+    }
+};
+
+template <typename T>
+struct conformance<T, true> {
+    static bool check(const ValidSchema& schema) {
+        return schema.fingerprint() == schema_traits<T>::fingerprint;
+    }
+};
+
+}   // namespace detail
+
+/**
+ * Returns true if T is known to encode exactly the data that \p schema
+ * describes, because T was generated from a schema with the same Parsing
+ * Canonical Form. Returns false if T is not generated or was generated
+ * from another schema.
+ * This computes the fingerprint of \p schema; call it once, not per value.
+ */
+template <typename T>
+bool conformsTo(const ValidSchema& schema)
+{
+    return detail::conformance<T>::check(schema);
+}
+
+/**
+ * Returns an encoder for values of type T in \p schema: \p base itself if
+ * T conforms to \p schema, otherwise a validating encoder around \p base.
+ * The check is made here, once, rather than on every call to the encoder.
+ */
+template <typename T>
+EncoderPtr checkedEncoder(const ValidSchema& schema, const EncoderPtr& base)
+{
+    return conformsTo<T>(schema) ? base : validatingEncoder(schema, base);
+}
+
 /**
  * Generic encoder function that makes use of the codec_traits.
  */
@@ -30,6 +30,9 @@
 
 namespace avro {
 
+class InputBuffer;
+class OutputBuffer;
+
 /**
  * A no-copy input stream.
  */
@@ -73,6 +76,41 @@ public:
      * to be used unless, retutned back using backup.
      */
     virtual size_t byteCount() const = 0;
+
+    /**
+     * Returns true if the data made available through next stays valid,
+     * and unchanged, for as long as this stream and whatever it reads from
+     * exist. Readers may then refer to the data instead of copying it.
+     * The default is false.
+     */
+    virtual bool stable() const {
+        return false;
+    }
+};
+
+/**
+ * An InputStream which also supports seeking to a specific offset.
+ */
+class AVRO_DECL SeekableInputStream : public InputStream {
+protected:
+
+    /**
+     * An empty constuctor.
+     */
+    SeekableInputStream() { }
+
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~SeekableInputStream() { }
+
+    /**
+     * Seeks to the given absolute position in the stream. Any data
+     * obtained through an earlier call to next() becomes invalid and
+     * byteCount() is reset to \p position.
+     */
+    virtual void seek(int64_t position) = 0;
 };
 
 /**
@@ -140,6 +178,23 @@ AVRO_DECL std::auto_ptr<InputStream> memoryInputStream(const uint8_t* data, size
  */
 AVRO_DECL std::auto_ptr<InputStream> memoryInputStream(const OutputStream& source);
 
+/**
+ * Returns a new OutputStream that appends to the given OutputBuffer.
+ * The encoded data is written directly into the buffer's chunks, without
+ * an intermediate copy. Data written into the stream is guaranteed to be
+ * in the buffer only after flush() has been called on the stream; the
+ * buffer should not be written to by other means until then.
+ */
+AVRO_DECL std::auto_ptr<OutputStream> bufferOutputStream(OutputBuffer& buffer);
+
+/**
+ * Returns a new InputStream which reads the contents of the given
+ * InputBuffer. The stream shares the buffer's chunks and does not copy
+ * the data.
+ */
+AVRO_DECL std::auto_ptr<InputStream> bufferInputStream(
+    const InputBuffer& buffer);
+
 /**
  * Returns a new OutputStream whose contents would be stored in a file.
  * Data is written in chunks of given buffer size.
@@ -157,6 +212,13 @@ AVRO_DECL std::auto_ptr<OutputStream> fileOutputStream(const char* filename,
 AVRO_DECL std::auto_ptr<InputStream> fileInputStream(const char* filename,
     size_t bufferSize = 8 * 1024);
 
+/**
+ * Returns a new SeekableInputStream whose contents come from the given
+ * file. Data is read in chunks of given buffer size.
+ */
+AVRO_DECL std::auto_ptr<SeekableInputStream> fileSeekableInputStream(
+    const char* filename, size_t bufferSize = 8 * 1024);
+
 /**
  * Returns a new OutputStream whose contents will be sent to the given
  * std::ostream. The std::ostream object should outlive the returned
@@ -243,6 +305,22 @@ struct StreamReader {
         }
     }
 
+    /**
+     * If the next n bytes are available in a single chunk, returns where
+     * they are and moves past them. Otherwise returns 0 and moves nowhere.
+     */
+    const uint8_t* readInPlace(size_t n) {
+        if (next_ == end_ && ! fill()) {
+            return 0;
+        }
+        if (static_cast<size_t>(end_ - next_) < n) {
+            return 0;
+        }
+        const uint8_t* result = next_;
+        next_ += n;
+        return result;
+    }
+
     /**
      * Skips the given number of bytes. Of there are not so that many
      * bytes, throws an exception.
@@ -289,6 +367,21 @@ struct StreamReader {
     bool hasMore() {
         return (next_ == end_) ? fill() : true;
     }
+
+    /**
+     * Returns to the underlying stream the data this reader has obtained
+     * but not yet read. If \p unRead is true, the last byte read is
+     * returned as well.
+     */
+    void drain(bool unRead) {
+        if (unRead) {
+            --next_;
+        }
+        if (in_ != 0 && end_ != next_) {
+            in_->backup(end_ - next_);
+        }
+        end_ = next_;
+    }
 };
 
 /**
@@ -0,0 +1,78 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Transcoder_hh__
+#define avro_Transcoder_hh__
+
+#include "Config.hh"
+#include "Stream.hh"
+#include "ValidSchema.hh"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+
+/// \file
+///
+/// Conversion of Avro data from one encoding to another, value by value,
+/// without building a GenericDatum for each.
+
+namespace avro {
+
+/**
+ * A transcoder reads values of a schema in one encoding and writes them
+ * in another. The schema is compiled once, when the transcoder is made;
+ * after that each value is copied token by token from the decoder to the
+ * encoder.
+ */
+class AVRO_DECL Transcoder : boost::noncopyable {
+public:
+    virtual ~Transcoder() { }
+
+    /// All future values will be read from is and written to os, which
+    /// should be valid until replaced by another call to init() or this
+    /// Transcoder is destructed.
+    virtual void init(InputStream& is, OutputStream& os) = 0;
+
+    /// Converts the next value of the input.
+    virtual void transcode() = 0;
+
+    /// Flushes any output left in internal buffers.
+    virtual void flush() = 0;
+};
+
+/**
+ * Shared pointer to Transcoder.
+ */
+typedef boost::shared_ptr<Transcoder> TranscoderPtr;
+
+/**
+ * Returns a transcoder from the Avro JSON encoding to Avro binary. Binary
+ * arrays and maps are written in blocks that carry their item counts, so
+ * the items of each block are held in memory until it is complete, up to
+ * about 64K bytes per block.
+ */
+AVRO_DECL TranscoderPtr jsonToBinaryTranscoder(const ValidSchema& schema);
+
+/**
+ * Returns a transcoder from Avro binary to the Avro JSON encoding.
+ */
+AVRO_DECL TranscoderPtr binaryToJsonTranscoder(const ValidSchema& schema);
+
+}   // namespace avro
+
+#endif
@@ -55,6 +55,15 @@ enum Type {
 
 };
 
+/**
+ * The sort order of a record field, given by its "order" attribute.
+ */
+enum SortOrder {
+    AVRO_ASCENDING,     /*!< Ascending, the default */
+    AVRO_DESCENDING,    /*!< Descending */
+    AVRO_IGNORE         /*!< Field is not considered when comparing */
+};
+
 /**
  * Returns true if and only if the given type is a primitive.
  * Primitive types are: string, bytes, int, long, float, double, boolean
@@ -51,12 +51,23 @@ public:
 
     void toJson(std::ostream &os) const;
 
+    /// Writes the schema in Avro's Parsing Canonical Form, which leaves out
+    /// everything that does not affect how data is read and written.
+    void toCanonicalJson(std::ostream &os) const;
+
+    /// Returns the 64-bit Rabin fingerprint (CRC-64-AVRO) of the schema's
+    /// Parsing Canonical Form.
+    uint64_t fingerprint() const;
+
     void toFlatList(std::ostream &os) const;
 
   protected:
     NodePtr root_;
 };
 
+/// Returns the 64-bit Rabin fingerprint (CRC-64-AVRO) of the given bytes.
+AVRO_DECL uint64_t fingerprint64(const uint8_t* data, size_t len);
+
 } // namespace avro
 
 #endif
@@ -0,0 +1,203 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_View_hh__
+#define avro_View_hh__
+
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "boost/utility.hpp"
+
+#include "Config.hh"
+
+namespace avro {
+
+/**
+ * A read-only, non-owning view of a sequence of T, in the manner of
+ * std::string_view. Views compare element by element as unsigned bytes,
+ * which for UTF-8 strings is the Avro sort order.
+ */
+template <typename T>
+class View {
+    const T* data_;
+    size_t size_;
+
+public:
+    typedef const T* const_iterator;
+
+    /**
+     * Constructs an empty view.
+     */
+    View() : data_(0), size_(0) { }
+
+    /**
+     * Constructs a view of the n elements at data.
+     */
+    View(const T* data, size_t n) : data_(data), size_(n) { }
+
+    /**
+     * Constructs a view of the elements of the given container, which
+     * must outlive the view.
+     */
+    template <typename C>
+    explicit View(const C& c) :
+        data_(c.empty() ? 0 : &c[0]), size_(c.size()) { }
+
+    const T* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const T& operator[](size_t i) const {
+        return data_[i];
+    }
+
+    const_iterator begin() const {
+        return data_;
+    }
+
+    const_iterator end() const {
+        return data_ + size_;
+    }
+
+    /**
+     * Compares this view with v and returns a negative, zero or positive
+     * number as this view sorts before, together with or after v.
+     */
+    int compare(const View& v) const {
+        int r = (size_ == 0 || v.size_ == 0) ? 0 :
+            ::memcmp(data_, v.data_, std::min(size_, v.size_));
+        return r != 0 ? r : (size_ < v.size_ ? -1 : (size_ > v.size_ ? 1 : 0));
+    }
+};
+
+template <typename T>
+bool operator==(const View<T>& a, const View<T>& b) {
+    return a.size() == b.size() && a.compare(b) == 0;
+}
+
+template <typename T>
+bool operator!=(const View<T>& a, const View<T>& b) {
+    return ! (a == b);
+}
+
+template <typename T>
+bool operator<(const View<T>& a, const View<T>& b) {
+    return a.compare(b) < 0;
+}
+
+/**
+ * A view of an Avro string.
+ */
+typedef View<char> StringView;
+
+/**
+ * A view of Avro bytes.
+ */
+typedef View<uint8_t> BytesView;
+
+/**
+ * Returns a copy of the viewed string.
+ */
+inline std::string toString(const StringView& v) {
+    return std::string(v.data(), v.size());
+}
+
+/**
+ * Returns a copy of the viewed bytes.
+ */
+inline std::vector<uint8_t> toBytes(const BytesView& v) {
+    return std::vector<uint8_t>(v.begin(), v.end());
+}
+
+inline std::ostream& operator<<(std::ostream& os, const StringView& v) {
+    return os.write(v.data(), v.size());
+}
+
+/**
+ * Memory for views whose data cannot be referred to where it was read
+ * from, for instance because it straddles two chunks of the input.
+ * Allocation is a pointer bump. Memory is given back only all at once,
+ * by clear() or by destroying the arena, which invalidates all views into
+ * it.
+ */
+class AVRO_DECL Arena : boost::noncopyable {
+    const size_t blockSize_;
+    std::vector<uint8_t*> blocks_;
+    std::vector<uint8_t*> large_;
+    size_t current_;
+    uint8_t* next_;
+    uint8_t* end_;
+
+public:
+    /**
+     * Constructs an arena that takes memory from the heap in blocks of
+     * the given size.
+     */
+    explicit Arena(size_t blockSize = 4096);
+
+    ~Arena();
+
+    /**
+     * Returns room for n bytes, valid until the arena is cleared.
+     */
+    uint8_t* allocate(size_t n) {
+        if (static_cast<size_t>(end_ - next_) < n) {
+            return allocateSlow(n);
+        }
+        uint8_t* result = next_;
+        next_ += n;
+        return result;
+    }
+
+    /**
+     * Copies n bytes from data into the arena and returns the copy.
+     */
+    const uint8_t* copy(const uint8_t* data, size_t n) {
+        uint8_t* result = allocate(n);
+        if (n > 0) {
+            ::memcpy(result, data, n);
+        }
+        return result;
+    }
+
+    /**
+     * Makes all the memory available again. Blocks of the standard size
+     * are kept for reuse.
+     */
+    void clear();
+
+private:
+    uint8_t* allocateSlow(size_t n);
+};
+
+}   // namespace avro
+
+#endif
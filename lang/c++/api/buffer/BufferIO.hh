@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_BufferIO_hh__
+#define avro_BufferIO_hh__
+
+#ifndef _WIN32
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Buffer.hh"
+
+/**
+ * \file BufferIO.hh
+ *
+ * \brief Functions for scatter-gather I/O between buffers and file
+ * descriptors, using writev and readv.
+ *
+ **/
+
+namespace avro {
+
+namespace detail {
+
+/// The maximum number of iovec entries passed in a single writev or readv.
+#ifdef IOV_MAX
+const int kMaxIovecs = IOV_MAX;
+#else
+const int kMaxIovecs = 16;
+#endif
+
+inline void throwIOError(const char *what)
+{
+    throw std::runtime_error(std::string(what) + ": " + ::strerror(errno));
+}
+
+} // detail namespace
+
+/**
+ * Write the entire contents of the buffer to the file descriptor.  The
+ * chunks are written in place with writev(), at most kMaxIovecs chunks at
+ * a time, and partial writes are continued from where they stopped.  An
+ * OutputBuffer may be passed as well, in which case its data (not its
+ * free space) is written.
+ *
+ * Returns the number of bytes written, which is always the size of the
+ * buffer.  Throws std::runtime_error if writev() fails or writes
+ * nothing.
+ **/
+
+inline size_t writeBuffer(int fd, const InputBuffer &buf)
+{
+    InputBuffer src(buf);
+    std::vector<struct iovec> iov;
+    toIovec(src, iov);
+
+    size_t written = 0;
+    size_t i = 0;
+    while (i < iov.size()) {
+        int count = std::min<size_t>(iov.size() - i, detail::kMaxIovecs);
+        ssize_t n = ::writev(fd, &iov[i], count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            detail::throwIOError("writev failed");
+        }
+        if (n == 0) {
+            // nothing was written although bytes are pending; retrying
+            // would never end
+            throw std::runtime_error("writev failed: no bytes written");
+        }
+        written += n;
+
+        // skip the iovecs that were written completely and adjust the
+        // one that was written partially, if any
+        size_t remaining = n;
+        while (i < iov.size() && remaining >= iov[i].iov_len) {
+            remaining -= iov[i].iov_len;
+            ++i;
+        }
+        if (remaining) {
+            iov[i].iov_base = static_cast<char *>(iov[i].iov_base) + remaining;
+            iov[i].iov_len -= remaining;
+        }
+    }
+    return written;
+}
+
+/**
+ * Read up to size bytes from the file descriptor into a new InputBuffer.
+ * The chunks are allocated up front and filled with readv(), so the data
+ * is not copied after it is read.  Reading stops when size bytes have
+ * been read or the end of file is reached; the size of the returned
+ * buffer tells how many bytes were read.
+ *
+ * Throws std::runtime_error if readv() fails.
+ **/
+
+inline InputBuffer readBuffer(int fd, size_t size)
+{
+    OutputBuffer dest(size);
+    std::vector<struct iovec> iov;
+
+    size_t bytesRead = 0;
+    while (bytesRead < size) {
+        toIovec(dest, iov);
+
+        // the reservation may be rounded up to whole chunks, so don't
+        // read past the requested size
+        size_t count = 0;
+        size_t wanted = size - bytesRead;
+        while (count < iov.size() && count < size_t(detail::kMaxIovecs)
+               && wanted) {
+            if (iov[count].iov_len > wanted) {
+                iov[count].iov_len = wanted;
+            }
+            wanted -= iov[count].iov_len;
+            ++count;
+        }
+
+        ssize_t n = ::readv(fd, &iov[0], count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            detail::throwIOError("readv failed");
+        }
+        if (n == 0) {
+            break;
+        }
+        dest.wroteTo(n);
+        bytesRead += n;
+    }
+    return dest.extractData();
+}
+
+} // namespace
+
+#endif // _WIN32
+
+#endif
@@ -31,6 +31,8 @@
 #include <cassert>
 #include <deque>
 
+#include "ChunkPool.hh"
+
 /** 
  * \file BufferDetail.hh
  *
@@ -72,6 +74,23 @@ class CallOnDestroy {
     free_func func_;
 };
 
+/**
+ * Deleter that returns the block backing a chunk to the pool it was
+ * allocated from.
+ **/
+class ReleaseToPool {
+  public:
+    ReleaseToPool(const ChunkPoolPtr &pool, size_type size) :
+        pool_(pool), size_(size)
+    { }
+    void operator()(data_type *block) const {
+        pool_->release(reinterpret_cast<uint8_t *>(block), size_);
+    }
+  private:
+    ChunkPoolPtr pool_;
+    size_type size_;
+};
+
 /** 
  * \brief A chunk is the building block for buffers.
  *
@@ -96,9 +115,10 @@ class Chunk
 
     typedef boost::shared_ptr<Chunk> SharedPtr;
 
-    /// Default constructor, allocates a new underlying block for this chunk.
+    /// Default constructor, allocates a new underlying block for this chunk
+    /// from the current chunk pool.
     Chunk(size_type size) :
-        underlyingBlock_(new data_type[size]), 
+        underlyingBlock_(allocateBlock(size)),
         readPos_(underlyingBlock_.get()),
         writePos_(readPos_),
         endPos_(readPos_ + size)
@@ -114,6 +134,19 @@ class Chunk
     { }
 
   private:
+    /// Allocates a block from the current chunk pool, to be released to
+    /// that same pool.
+    static boost::shared_array<data_type> allocateBlock(size_type size) {
+#ifdef _WIN32
+        const ChunkPoolPtr pool = chunkPool();
+#else
+        const ChunkPoolPtr &pool = threadChunkPool();
+#endif
+        return boost::shared_array<data_type>(
+            reinterpret_cast<data_type *>(pool->allocate(size)),
+            ReleaseToPool(pool, size));
+    }
+
     // reference counted object will call a functor when it's destroyed
     boost::shared_ptr<CallOnDestroy> callOnDestroy_;
 
@@ -0,0 +1,358 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+
+#include "BinaryComparator.hh"
+#include "Exception.hh"
+#include "Zigzag.hh"
+#include "Ordering.hh"
+
+namespace avro {
+
+using ordering::compareScalar;
+using ordering::compareReal;
+using ordering::compareBytes;
+
+/**
+ * Reads an encoded value out of a block of memory.
+ */
+class BinaryComparator::Cursor {
+    const uint8_t* next_;
+    const uint8_t* const end_;
+
+public:
+    Cursor(const uint8_t* data, size_t n) : next_(data), end_(data + n) { }
+
+    /**
+     * Returns the next n bytes and moves past them.
+     */
+    const uint8_t* take(size_t n) {
+        if (static_cast<size_t>(end_ - next_) < n) {
+            throw Exception("Avro binary data ends within a value");
+        }
+        const uint8_t* result = next_;
+        next_ += n;
+        return result;
+    }
+
+    int64_t readLong() {
+        uint64_t encoded = 0;
+        int shift = 0;
+        uint8_t u;
+        do {
+            if (shift >= 64) {
+                throw Exception("Invalid Avro varint");
+            }
+            u = *take(1);
+            encoded |= static_cast<uint64_t>(u & 0x7f) << shift;
+            shift += 7;
+        } while (u & 0x80);
+        return decodeZigzag64(encoded);
+    }
+
+    size_t readSize() {
+        const int64_t n = readLong();
+        if (n < 0) {
+            throw Exception(boost::format("Invalid Avro length: %1%") % n);
+        }
+        return static_cast<size_t>(n);
+    }
+
+    /**
+     * Reads the item count that starts a block of an array or map. The
+     * count is negative when the block's byte size follows it.
+     */
+    int64_t readBlockCount() {
+        const int64_t n = readLong();
+        if (n == std::numeric_limits<int64_t>::min()) {
+            throw Exception(boost::format("Invalid Avro block count: %1%") %
+                n);
+        }
+        return n;
+    }
+
+    /**
+     * Throws unless there are bytes left for n items, each of which takes
+     * at least one.
+     */
+    void checkCount(uint64_t n) const {
+        if (static_cast<uint64_t>(end_ - next_) < n) {
+            throw Exception("Avro binary data ends within a value");
+        }
+    }
+
+    /**
+     * Reads the item count that starts a block of an array or map,
+     * dropping the byte size that comes with a negative count. Unless
+     * the items take no bytes, the count is checked against the bytes
+     * left.
+     */
+    size_t readCount(bool zeroWidth) {
+        int64_t n = readBlockCount();
+        if (n < 0) {
+            readSize();
+            n = -n;
+        }
+        if (! zeroWidth) {
+            checkCount(n);
+        }
+        return static_cast<size_t>(n);
+    }
+
+    /**
+     * Moves past a string or bytes, returning its bytes and, in n, its
+     * length.
+     */
+    const uint8_t* takeBytes(size_t& n) {
+        n = readSize();
+        return take(n);
+    }
+
+    template <typename T>
+    T readReal() {
+        T result;
+        ::memcpy(&result, take(sizeof(T)), sizeof(T));
+        return result;
+    }
+};
+
+/**
+ * Works out whether the values of node n encode to no bytes: nulls and
+ * records made only of such values. A record met again while its fields
+ * are being looked at is taken not to be.
+ */
+static bool isZeroWidth(const SchemaTable& t, size_t n,
+    std::vector<int>& state, std::vector<bool>& result)
+{
+    enum { UNKNOWN, VISITING, DONE };
+    n = t.resolve(n);
+    if (state[n] != UNKNOWN) {
+        return state[n] == DONE && result[n];
+    }
+    bool zero = false;
+    switch (t.type(n)) {
+    case AVRO_NULL:
+        zero = true;
+        break;
+    case AVRO_RECORD:
+        state[n] = VISITING;
+        zero = true;
+        for (size_t i = 0; i < t.leaves(n); ++i) {
+            if (! isZeroWidth(t, t.leafAt(n, i), state, result)) {
+                zero = false;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    state[n] = DONE;
+    result[n] = zero;
+    return zero;
+}
+
+BinaryComparator::BinaryComparator(const ValidSchema& schema) :
+    table_(schema), zeroWidth_(table_.size())
+{
+    std::vector<int> state(table_.size());
+    for (size_t n = 0; n < table_.size(); ++n) {
+        isZeroWidth(table_, n, state, zeroWidth_);
+    }
+}
+
+int BinaryComparator::compare(const uint8_t* a, size_t na,
+    const uint8_t* b, size_t nb) const
+{
+    Cursor ca(a, na);
+    Cursor cb(b, nb);
+    return compare(table_.root(), ca, cb);
+}
+
+int BinaryComparator::compare(size_t n, Cursor& a, Cursor& b) const
+{
+    n = table_.resolve(n);
+    switch (table_.type(n)) {
+    case AVRO_NULL:
+        return 0;
+    case AVRO_BOOL:
+        return compareScalar(*a.take(1), *b.take(1));
+    case AVRO_INT:
+    case AVRO_LONG:
+    case AVRO_ENUM:
+        return compareScalar(a.readLong(), b.readLong());
+    case AVRO_FLOAT:
+        return compareReal(a.readReal<float>(), b.readReal<float>());
+    case AVRO_DOUBLE:
+        return compareReal(a.readReal<double>(), b.readReal<double>());
+    case AVRO_STRING:
+    case AVRO_BYTES:
+        {
+            size_t la;
+            size_t lb;
+            const uint8_t* pa = a.takeBytes(la);
+            const uint8_t* pb = b.takeBytes(lb);
+            return compareBytes(pa, la, pb, lb);
+        }
+    case AVRO_FIXED:
+        {
+            const size_t size = table_.fixedSize(n);
+            return compareBytes(a.take(size), size, b.take(size), size);
+        }
+    case AVRO_RECORD:
+        for (size_t i = 0; i < table_.leaves(n); ++i) {
+            const size_t f = table_.leafAt(n, i);
+            const SortOrder o = table_.sortOrderAt(n, i);
+            if (o == AVRO_IGNORE) {
+                skip(f, a);
+                skip(f, b);
+                continue;
+            }
+            const int c = compare(f, a, b);
+            if (c != 0) {
+                return o == AVRO_DESCENDING ? -c : c;
+            }
+        }
+        return 0;
+    case AVRO_ARRAY:
+        {
+            const size_t item = table_.leafAt(n, 0);
+            const bool zw = zeroWidth_[table_.resolve(item)];
+            // The blocks of the two arrays need not line up.
+            size_t ra = a.readCount(zw);
+            size_t rb = b.readCount(zw);
+            while (ra != 0 && rb != 0) {
+                // Items that take no bytes are all equal; match up as
+                // many as both blocks hold at once.
+                const size_t k = zw ? std::min(ra, rb) : 1;
+                if (! zw) {
+                    const int c = compare(item, a, b);
+                    if (c != 0) {
+                        return c;
+                    }
+                }
+                ra -= k;
+                rb -= k;
+                if (ra == 0) {
+                    ra = a.readCount(zw);
+                }
+                if (rb == 0) {
+                    rb = b.readCount(zw);
+                }
+            }
+            return compareScalar(ra, rb);
+        }
+    case AVRO_MAP:
+        throw Exception("Avro maps cannot be ordered");
+    case AVRO_UNION:
+        {
+            const size_t ba = a.readSize();
+            const size_t bb = b.readSize();
+            if (ba >= table_.leaves(n) || bb >= table_.leaves(n)) {
+                throw Exception(boost::format("Invalid union branch: %1%") %
+                    std::max(ba, bb));
+            }
+            if (ba != bb) {
+                return compareScalar(ba, bb);
+            }
+            return compare(table_.leafAt(n, ba), a, b);
+        }
+    default:
+        throw Exception(boost::format("Cannot compare data of type %1%") %
+            toString(table_.type(n)));
+    }
+}
+
+void BinaryComparator::skip(size_t n, Cursor& c) const
+{
+    n = table_.resolve(n);
+    switch (table_.type(n)) {
+    case AVRO_NULL:
+        break;
+    case AVRO_BOOL:
+        c.take(1);
+        break;
+    case AVRO_INT:
+    case AVRO_LONG:
+    case AVRO_ENUM:
+        c.readLong();
+        break;
+    case AVRO_FLOAT:
+        c.take(4);
+        break;
+    case AVRO_DOUBLE:
+        c.take(8);
+        break;
+    case AVRO_STRING:
+    case AVRO_BYTES:
+        c.take(c.readSize());
+        break;
+    case AVRO_FIXED:
+        c.take(table_.fixedSize(n));
+        break;
+    case AVRO_RECORD:
+        for (size_t i = 0; i < table_.leaves(n); ++i) {
+            skip(table_.leafAt(n, i), c);
+        }
+        break;
+    case AVRO_ARRAY:
+    case AVRO_MAP:
+        {
+            const bool isMap = table_.type(n) == AVRO_MAP;
+            const size_t item = table_.leafAt(n, isMap ? 1 : 0);
+            // A map entry has at least its key's length.
+            const bool zw = ! isMap && zeroWidth_[table_.resolve(item)];
+            for (int64_t count = c.readBlockCount(); count != 0;
+                count = c.readBlockCount()) {
+                if (count < 0) {
+                    // The block's byte size follows; jump over it whole.
+                    c.take(c.readSize());
+                    continue;
+                }
+                if (zw) {
+                    continue;
+                }
+                c.checkCount(count);
+                for (int64_t i = 0; i < count; ++i) {
+                    if (isMap) {
+                        c.take(c.readSize());
+                    }
+                    skip(item, c);
+                }
+            }
+        }
+        break;
+    case AVRO_UNION:
+        {
+            const size_t b = c.readSize();
+            if (b >= table_.leaves(n)) {
+                throw Exception(boost::format("Invalid union branch: %1%") %
+                    b);
+            }
+            skip(table_.leafAt(n, b), c);
+        }
+        break;
+    default:
+        throw Exception(boost::format("Cannot skip data of type %1%") %
+            toString(table_.type(n)));
+    }
+}
+
+}   // namespace avro
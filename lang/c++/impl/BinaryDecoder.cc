@@ -24,6 +24,7 @@
 
 #include <boost/array.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/ref.hpp>
 
 namespace avro {
 
@@ -33,6 +34,9 @@ class BinaryDecoder : public Decoder {
     StreamReader in_;
     const uint8_t* next_;
     const uint8_t* end_;
+    Arena ownArena_;
+    Arena& arena_;
+    bool stable_;
 
     void init(InputStream& ib);
     void decodeNull();
@@ -43,9 +47,12 @@ class BinaryDecoder : public Decoder {
     double decodeDouble();
     void decodeString(std::string& value);
     void skipString();
+    void decodeStringView(StringView& value);
     void decodeBytes(std::vector<uint8_t>& value);
     void skipBytes();
+    void decodeBytesView(BytesView& value);
     void decodeFixed(size_t n, std::vector<uint8_t>& value);
+    void decodeFixed(size_t n, uint8_t* value);
     void skipFixed(size_t n);
     size_t decodeEnum();
     size_t arrayStart();
@@ -59,7 +66,12 @@ class BinaryDecoder : public Decoder {
 
     int64_t doDecodeLong();
     size_t doDecodeItemCount();
+    const uint8_t* doDecodeView(size_t len);
     void more();
+public:
+    BinaryDecoder() : next_(0), end_(0), arena_(ownArena_), stable_(false) { }
+    BinaryDecoder(Arena& arena) : next_(0), end_(0), arena_(arena),
+        stable_(false) { }
 };
 
 DecoderPtr binaryDecoder()
@@ -67,9 +79,16 @@ DecoderPtr binaryDecoder()
     return make_shared<BinaryDecoder>();
 }
 
+DecoderPtr binaryDecoder(Arena& arena)
+{
+    return make_shared<BinaryDecoder>(boost::ref(arena));
+}
+
 void BinaryDecoder::init(InputStream& is)
 {
     in_.reset(is);
+    stable_ = is.stable();
+    ownArena_.clear();
 }
 
 void BinaryDecoder::decodeNull()
@@ -131,6 +150,36 @@ void BinaryDecoder::skipString()
     in_.skipBytes(len);
 }
 
+/**
+ * Returns where the next len bytes are, reading them in place if the input
+ * allows and copying them into the arena otherwise.
+ */
+const uint8_t* BinaryDecoder::doDecodeView(size_t len)
+{
+    if (stable_) {
+        if (const uint8_t* p = in_.readInPlace(len)) {
+            return p;
+        }
+    }
+    uint8_t* p = arena_.allocate(len);
+    if (len > 0) {
+        in_.readBytes(p, len);
+    }
+    return p;
+}
+
+void BinaryDecoder::decodeStringView(StringView& value)
+{
+    size_t len = decodeInt();
+    value = StringView(reinterpret_cast<const char*>(doDecodeView(len)), len);
+}
+
+void BinaryDecoder::decodeBytesView(BytesView& value)
+{
+    size_t len = decodeInt();
+    value = BytesView(doDecodeView(len), len);
+}
+
 void BinaryDecoder::decodeBytes(std::vector<uint8_t>& value)
 {
     size_t len = decodeInt();
@@ -154,6 +203,13 @@ void BinaryDecoder::decodeFixed(size_t n, std::vector<uint8_t>& value)
     }
 }
 
+void BinaryDecoder::decodeFixed(size_t n, uint8_t* value)
+{
+    if (n > 0) {
+        in_.readBytes(value, n);
+    }
+}
+
 void BinaryDecoder::skipFixed(size_t n)
 {
     in_.skipBytes(n);
@@ -0,0 +1,474 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ChunkPool.hh"
+#include "Exception.hh"
+#include "Mutex.hh"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "boost/detail/atomic_count.hpp"
+
+namespace avro {
+namespace {
+
+const size_t minClassSize = 1024;
+const size_t classCount = 7;
+
+/**
+ * Returns the size class for chunks of the given size or classCount if
+ * the chunks are too large to be pooled.
+ */
+size_t sizeClass(size_t size)
+{
+    size_t c = 0;
+    for (size_t n = minClassSize; n < size && c < classCount; n <<= 1) {
+        ++c;
+    }
+    return c;
+}
+
+size_t classSize(size_t c)
+{
+    return minClassSize << c;
+}
+
+typedef std::vector<uint8_t*> FreeList;
+
+class CachingChunkPool;
+struct ThreadCache;
+
+/**
+ * What a pool shares with its thread caches. It outlives the pool, so that
+ * a thread exiting after the pool is gone can tell.
+ */
+struct CacheRegistry {
+    // Guards everything below.
+    Mutex mutex;
+    CachingChunkPool* pool;
+    std::set<ThreadCache*> caches;
+
+    CacheRegistry(CachingChunkPool* p) : pool(p) { }
+};
+
+/**
+ * The chunks one thread keeps to itself. It does not keep its pool alive;
+ * when the pool goes away, it frees the chunks of all its caches.
+ */
+struct ThreadCache {
+    boost::shared_ptr<CacheRegistry> registry;
+    FreeList lists[classCount];
+};
+
+/**
+ * The caches of one thread, one for each pool it has used.
+ */
+typedef std::vector<ThreadCache*> ThreadCaches;
+
+class CachingChunkPool : public ChunkPool {
+    const size_t maxPooledBytes_;
+    const size_t threadCacheSize_;
+
+    boost::detail::atomic_count live_;
+    boost::detail::atomic_count pooled_;
+    boost::detail::atomic_count allocated_;
+
+    // Guards everything below.
+    Mutex mutex_;
+    FreeList shared_[classCount];
+    size_t sharedBytes_;
+
+    const boost::shared_ptr<CacheRegistry> registry_;
+
+    ThreadCache* threadCache();
+    ThreadCache* newThreadCache(ThreadCaches& caches);
+    static void createCacheKey();
+    static void releaseThreadCaches(void* p);
+
+    /**
+     * Moves up to n chunks of class c from the shared pool to list.
+     */
+    void takeShared(size_t c, FreeList& list, size_t n) {
+        Lock l(mutex_);
+        FreeList& s = shared_[c];
+        n = std::min(n, s.size());
+        list.insert(list.end(), s.end() - n, s.end());
+        s.resize(s.size() - n);
+        sharedBytes_ -= n * classSize(c);
+    }
+
+    /**
+     * Moves the last n chunks of class c from list to the shared pool,
+     * freeing those that do not fit.
+     */
+    void giveShared(size_t c, FreeList& list, size_t n) {
+        Lock l(mutex_);
+        for (; n > 0; --n) {
+            uint8_t* chunk = list.back();
+            list.pop_back();
+            if (sharedBytes_ + classSize(c) <= maxPooledBytes_) {
+                shared_[c].push_back(chunk);
+                sharedBytes_ += classSize(c);
+            } else {
+                delete[] chunk;
+                --pooled_;
+            }
+        }
+    }
+
+    static void freeAll(FreeList& list) {
+        for (FreeList::const_iterator it = list.begin(); it != list.end();
+            ++it) {
+            delete[] *it;
+        }
+        FreeList().swap(list);
+    }
+
+public:
+    CachingChunkPool(size_t maxPooledBytes, size_t threadCacheSize) :
+        maxPooledBytes_(maxPooledBytes), threadCacheSize_(threadCacheSize),
+        live_(0), pooled_(0), allocated_(0), sharedBytes_(0),
+        registry_(new CacheRegistry(this)) {
+    }
+
+    ~CachingChunkPool() {
+        {
+            // The caches of threads still running are emptied but stay
+            // with their threads, which free them later.
+            Lock l(registry_->mutex);
+            for (std::set<ThreadCache*>::const_iterator it =
+                registry_->caches.begin(); it != registry_->caches.end();
+                ++it) {
+                for (size_t c = 0; c < classCount; ++c) {
+                    freeAll((*it)->lists[c]);
+                }
+            }
+            registry_->caches.clear();
+            registry_->pool = 0;
+        }
+        for (size_t c = 0; c < classCount; ++c) {
+            freeAll(shared_[c]);
+        }
+    }
+
+    uint8_t* allocate(size_t size) {
+        ++live_;
+        const size_t c = sizeClass(size);
+        if (c < classCount) {
+            if (ThreadCache* tc = threadCache()) {
+                FreeList& list = tc->lists[c];
+                if (list.empty()) {
+                    takeShared(c, list, (threadCacheSize_ + 1) / 2);
+                }
+                if (! list.empty()) {
+                    uint8_t* result = list.back();
+                    list.pop_back();
+                    --pooled_;
+                    return result;
+                }
+            } else {
+                Lock l(mutex_);
+                FreeList& s = shared_[c];
+                if (! s.empty()) {
+                    uint8_t* result = s.back();
+                    s.pop_back();
+                    sharedBytes_ -= classSize(c);
+                    --pooled_;
+                    return result;
+                }
+            }
+            size = classSize(c);
+        }
+        ++allocated_;
+        return new uint8_t[size];
+    }
+
+    void release(uint8_t* chunk, size_t size) {
+        --live_;
+        const size_t c = sizeClass(size);
+        if (c == classCount) {
+            delete[] chunk;
+            return;
+        }
+        ++pooled_;
+        if (ThreadCache* tc = threadCache()) {
+            FreeList& list = tc->lists[c];
+            list.push_back(chunk);
+            if (list.size() > threadCacheSize_) {
+                giveShared(c, list, list.size() - threadCacheSize_ / 2);
+            }
+        } else {
+            FreeList list(1, chunk);
+            giveShared(c, list, 1);
+        }
+    }
+
+    ChunkPoolStats stats() const {
+        ChunkPoolStats result;
+        result.live = live_;
+        result.pooled = pooled_;
+        result.allocated = allocated_;
+        return result;
+    }
+};
+
+#ifdef _WIN32
+
+ThreadCache* CachingChunkPool::threadCache()
+{
+    return 0;
+}
+
+#else
+
+/**
+ * The key to each thread's ThreadCaches. It is shared by all pools, so
+ * that a thread frees its caches when it exits, even those of pools that
+ * are gone.
+ */
+pthread_once_t cacheKeyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t cacheKey;
+bool hasCacheKey = false;
+
+void CachingChunkPool::createCacheKey()
+{
+    hasCacheKey =
+        ::pthread_key_create(&cacheKey, &releaseThreadCaches) == 0;
+}
+
+ThreadCache* CachingChunkPool::threadCache()
+{
+    if (threadCacheSize_ == 0) {
+        return 0;
+    }
+    ::pthread_once(&cacheKeyOnce, &createCacheKey);
+    if (! hasCacheKey) {
+        return 0;
+    }
+    ThreadCaches* caches =
+        static_cast<ThreadCaches*>(::pthread_getspecific(cacheKey));
+    if (caches == 0) {
+        caches = new ThreadCaches();
+        ::pthread_setspecific(cacheKey, caches);
+    }
+    for (ThreadCaches::const_iterator it = caches->begin();
+        it != caches->end(); ++it) {
+        if ((*it)->registry == registry_) {
+            return *it;
+        }
+    }
+    return newThreadCache(*caches);
+}
+
+/**
+ * Adds a cache for this pool to the thread's caches, dropping those of
+ * the pools that are gone.
+ */
+ThreadCache* CachingChunkPool::newThreadCache(ThreadCaches& caches)
+{
+    for (size_t i = 0; i < caches.size(); ) {
+        bool gone;
+        {
+            Lock l(caches[i]->registry->mutex);
+            gone = caches[i]->registry->pool == 0;
+        }
+        if (gone) {
+            delete caches[i];
+            caches.erase(caches.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+
+    ThreadCache* result = new ThreadCache();
+    result->registry = registry_;
+    {
+        Lock l(registry_->mutex);
+        registry_->caches.insert(result);
+    }
+    caches.push_back(result);
+    return result;
+}
+
+/**
+ * Called when a thread exits, hands the thread's chunks to the shared
+ * pools of the pools that are still there.
+ */
+void CachingChunkPool::releaseThreadCaches(void* p)
+{
+    ThreadCaches* caches = static_cast<ThreadCaches*>(p);
+    for (ThreadCaches::const_iterator it = caches->begin();
+        it != caches->end(); ++it) {
+        ThreadCache* tc = *it;
+        {
+            // The pool cannot finish going away while this is held.
+            Lock l(tc->registry->mutex);
+            if (CachingChunkPool* pool = tc->registry->pool) {
+                tc->registry->caches.erase(tc);
+                for (size_t c = 0; c < classCount; ++c) {
+                    pool->giveShared(c, tc->lists[c], tc->lists[c].size());
+                }
+            }
+        }
+        delete tc;
+    }
+    delete caches;
+}
+
+#endif
+
+class NewDeleteChunkPool : public ChunkPool {
+    boost::detail::atomic_count live_;
+    boost::detail::atomic_count allocated_;
+
+public:
+    NewDeleteChunkPool() : live_(0), allocated_(0) { }
+
+    uint8_t* allocate(size_t size) {
+        ++live_;
+        ++allocated_;
+        return new uint8_t[size];
+    }
+
+    void release(uint8_t* chunk, size_t size) {
+        --live_;
+        delete[] chunk;
+    }
+
+    ChunkPoolStats stats() const {
+        ChunkPoolStats result;
+        result.live = live_;
+        result.pooled = 0;
+        result.allocated = allocated_;
+        return result;
+    }
+};
+
+/**
+ * The pool chunks are allocated from. setChunkPool() may replace it while
+ * other threads read it; each replacement bumps the generation.
+ */
+struct CurrentPool {
+    // Guards pool.
+    Mutex mutex;
+    ChunkPoolPtr pool;
+    boost::detail::atomic_count generation;
+#ifndef _WIN32
+    pthread_key_t key;
+#endif
+
+    CurrentPool() : pool(cachingChunkPool()), generation(0) {
+#ifndef _WIN32
+        if (::pthread_key_create(&key, &releaseThreadPool) != 0) {
+            throw Exception("Cannot create thread key for chunk pool");
+        }
+#endif
+    }
+
+#ifndef _WIN32
+    /**
+     * The current pool as a thread last saw it.
+     */
+    struct ThreadPool {
+        long generation;
+        ChunkPoolPtr pool;
+    };
+
+    static void releaseThreadPool(void* p) {
+        delete static_cast<ThreadPool*>(p);
+    }
+#endif
+};
+
+CurrentPool& currentPool()
+{
+    static CurrentPool current;
+    return current;
+}
+
+// C++98 does not make the initialization of function-local statics
+// thread-safe, so do it during static initialization, before there are
+// threads to race.
+CurrentPool& currentPoolInit = currentPool();
+
+}   // namespace
+
+ChunkPoolPtr cachingChunkPool(size_t maxPooledBytes, size_t threadCacheSize)
+{
+    return ChunkPoolPtr(new CachingChunkPool(maxPooledBytes, threadCacheSize));
+}
+
+ChunkPoolPtr newDeleteChunkPool()
+{
+    return ChunkPoolPtr(new NewDeleteChunkPool());
+}
+
+#ifdef _WIN32
+
+ChunkPoolPtr chunkPool()
+{
+    CurrentPool& current = currentPool();
+    Lock l(current.mutex);
+    return current.pool;
+}
+
+#else
+
+const ChunkPoolPtr& threadChunkPool()
+{
+    CurrentPool& current = currentPool();
+    CurrentPool::ThreadPool* tp = static_cast<CurrentPool::ThreadPool*>(
+        ::pthread_getspecific(current.key));
+    if (tp == 0) {
+        tp = new CurrentPool::ThreadPool();
+        tp->generation = -1;
+        ::pthread_setspecific(current.key, tp);
+    }
+    // Only a thread that has not seen the latest pool yet takes the lock.
+    if (tp->generation != current.generation) {
+        Lock l(current.mutex);
+        tp->pool = current.pool;
+        tp->generation = current.generation;
+    }
+    return tp->pool;
+}
+
+ChunkPoolPtr chunkPool()
+{
+    return threadChunkPool();
+}
+
+#endif
+
+void setChunkPool(const ChunkPoolPtr& pool)
+{
+    CurrentPool& current = currentPool();
+    // Should this drop the last reference to the old pool, the pool goes
+    // away once the lock is released.
+    ChunkPoolPtr old;
+    {
+        Lock l(current.mutex);
+        old = current.pool;
+        current.pool = pool;
+        ++current.generation;
+    }
+}
+
+}   // namespace avro
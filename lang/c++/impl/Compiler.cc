@@ -15,6 +15,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <limits.h>
+#include <string.h>
+#include <list>
+#include <map>
 #include <sstream>
 
 #include "Compiler.hh"
@@ -22,8 +26,11 @@
 #include "Schema.hh"
 #include "ValidSchema.hh"
 #include "Stream.hh"
+#include "Hash.hh"
+#include "Mutex.hh"
 
 #include "json/JsonDom.hh"
+#include "json/JsonIO.hh"
 
 extern void yyparse(void *ctx);
 
@@ -127,15 +134,33 @@ const T& getField(const Entity& e, const map<string, Entity>& m,
 struct Field {
     const string& name;
     const NodePtr value;
-    Field(const string& n, const NodePtr& v) : name(n), value(v) { }
+    const SortOrder order;
+    Field(const string& n, const NodePtr& v, SortOrder o) :
+        name(n), value(v), order(o) { }
 };
 
+static SortOrder getSortOrder(const Entity& e, const map<string, Entity>& m)
+{
+    if (m.find("order") == m.end()) {
+        return AVRO_ASCENDING;
+    }
+    const string& o = getField<string>(e, m, "order");
+    if (o == "ascending") {
+        return AVRO_ASCENDING;
+    } else if (o == "descending") {
+        return AVRO_DESCENDING;
+    } else if (o == "ignore") {
+        return AVRO_IGNORE;
+    }
+    throw Exception(boost::format("Invalid field order: %1%") % o);
+}
+
 static Field makeField(const Entity& e, SymbolTable& st, const string& ns)
 {
     const map<string, Entity>& m = e.value<map<string, Entity> >();
     const string& n = getField<string>(e, m, "name");
     map<string, Entity>::const_iterator it = findField(e, m, "type");
-    return Field(n, makeNode(it->second, st, ns));
+    return Field(n, makeNode(it->second, st, ns), getSortOrder(e, m));
 }
 
 static NodePtr makeRecordNode(const Entity& e,
@@ -144,14 +169,16 @@ static NodePtr makeRecordNode(const Entity& e,
     const vector<Entity>& v = getField<vector<Entity> >(e, m, "fields");
     concepts::MultiAttribute<string> fieldNames;
     concepts::MultiAttribute<NodePtr> fieldValues;
+    vector<SortOrder> sortOrders;
     
     for (vector<Entity>::const_iterator it = v.begin(); it != v.end(); ++it) {
         Field f = makeField(*it, st, ns);
         fieldNames.add(f.name);
         fieldValues.add(f.value);
+        sortOrders.push_back(f.order);
     }
     return NodePtr(new NodeRecord(asSingleAttribute(name),
-        fieldValues, fieldNames));
+        fieldValues, fieldNames, sortOrders));
 }
 
 static NodePtr makeEnumNode(const Entity& e,
@@ -281,17 +308,375 @@ static NodePtr makeNode(const json::Entity& e, SymbolTable& st, const string& ns
     }
 }
 
-AVRO_DECL ValidSchema compileJsonSchemaFromStream(InputStream& is)
+namespace {
+
+/**
+ * Compiles a schema straight from the token stream, without building a
+ * DOM. Object members can come in any order in JSON, but nearly every
+ * schema has "type" before the rest, and "name" and "namespace" before
+ * "fields"; this handles those. On anything else, valid or not, it
+ * throws Unsupported and leaves the schema to the DOM-based compiler,
+ * which then either compiles it or reports the error. Malformed JSON and
+ * errors it can tell for certain, such as an unknown type name, it
+ * reports itself.
+ */
+class StreamingCompiler {
+    json::JsonParser p_;
+    SymbolTable st_;
+
+    static void fail() {
+        throw Unsupported();
+    }
+
+    void expect(json::JsonParser::Token tk) {
+        if (p_.advance() != tk) {
+            fail();
+        }
+    }
+
+    void skipValue();
+    NodePtr makeNode(const string& ns);
+    NodePtr makeObject(const string& ns);
+    Field makeField(const string& ns, string& name);
+    NodePtr makeRecord(const Name& nm);
+    NodePtr makeEnum(const Name& nm);
+
+public:
+    /**
+     * Thrown when the schema is not in the order expected.
+     */
+    struct Unsupported { };
+
+    explicit StreamingCompiler(InputStream& in) {
+        p_.init(in);
+    }
+
+    NodePtr compile() {
+        NodePtr result = makeNode("");
+        p_.drain();
+        return result;
+    }
+};
+
+void StreamingCompiler::skipValue()
 {
-    json::Entity e = json::loadEntity(is);
+    size_t level = 0;
+    do {
+        switch (p_.advance()) {
+        case json::JsonParser::tkArrayStart:
+        case json::JsonParser::tkObjectStart:
+            ++level;
+            break;
+        case json::JsonParser::tkArrayEnd:
+        case json::JsonParser::tkObjectEnd:
+            --level;
+            break;
+        default:
+            break;
+        }
+    } while (level > 0);
+}
+
+NodePtr StreamingCompiler::makeNode(const string& ns)
+{
+    switch (p_.advance()) {
+    case json::JsonParser::tkString:
+        return avro::makeNode(p_.stringValue(), st_, ns);
+    case json::JsonParser::tkObjectStart:
+        return makeObject(ns);
+    case json::JsonParser::tkArrayStart:
+        {
+            concepts::MultiAttribute<NodePtr> mm;
+            while (p_.peek() != json::JsonParser::tkArrayEnd) {
+                mm.add(makeNode(ns));
+            }
+            p_.advance();
+            return NodePtr(new NodeUnion(mm));
+        }
+    default:
+        fail();
+        return NodePtr();
+    }
+}
+
+/**
+ * Compiles the members of an object whose "{" has been read.
+ */
+NodePtr StreamingCompiler::makeObject(const string& ns)
+{
+    string type;
+    string name;
+    string space;
+    bool hasName = false;
+    bool hasSpace = false;
+    bool nameUsed = false;
+    size_t members = 0;
+    NodePtr result;
+    int size = 0;
+
+    while (p_.advance() != json::JsonParser::tkObjectEnd) {
+        const string& key = p_.stringValue();
+        ++members;
+        if (key == "type") {
+            if (! type.empty()) {
+                fail();
+            }
+            expect(json::JsonParser::tkString);
+            type = p_.stringValue();
+        } else if (key == "name") {
+            if (hasName) {
+                fail();
+            }
+            expect(json::JsonParser::tkString);
+            name = p_.stringValue();
+            hasName = true;
+        } else if (key == "namespace") {
+            // Too late if the name has been used already.
+            if (hasSpace || (nameUsed && ! isFullName(name))) {
+                fail();
+            }
+            expect(json::JsonParser::tkString);
+            space = p_.stringValue();
+            hasSpace = true;
+        } else if (key == "fields") {
+            if ((type != "record" && type != "error") || ! hasName ||
+                result) {
+                fail();
+            }
+            result = makeRecord(getName(name, hasSpace ? space : ns));
+            nameUsed = true;
+        } else if (key == "symbols") {
+            if (type != "enum" || ! hasName || result) {
+                fail();
+            }
+            result = makeEnum(getName(name, hasSpace ? space : ns));
+            nameUsed = true;
+        } else if (key == "size") {
+            if (type != "fixed" || size != 0) {
+                fail();
+            }
+            expect(json::JsonParser::tkLong);
+            int64_t n = p_.longValue();
+            if (n <= 0 || n > INT_MAX) {
+                fail();
+            }
+            size = static_cast<int>(n);
+        } else if (key == "items" || key == "values") {
+            if (type != (key == "items" ? "array" : "map") || result) {
+                fail();
+            }
+            NodePtr n = makeNode(ns);
+            result = (type == "array") ?
+                NodePtr(new NodeArray(asSingleAttribute(n))) :
+                NodePtr(new NodeMap(asSingleAttribute(n)));
+        } else {
+            skipValue();
+        }
+    }
+
+    if (type == "fixed") {
+        if (size == 0 || ! hasName) {
+            fail();
+        }
+        Name nm = getName(name, hasSpace ? space : ns);
+        result = NodePtr(new NodeFixed(asSingleAttribute(nm),
+            asSingleAttribute(size)));
+        st_[nm] = result;
+    } else if (! result) {
+        result = makePrimitive(type);
+        if (! result || members > 1) {
+            fail();
+        }
+    }
+    return result;
+}
+
+/**
+ * Compiles the fields of a record. The record is entered into the symbol
+ * table before its fields, which may refer to it.
+ */
+NodePtr StreamingCompiler::makeRecord(const Name& nm)
+{
+    NodePtr result(new NodeRecord());
+    st_[nm] = result;
+
+    concepts::MultiAttribute<string> fieldNames;
+    concepts::MultiAttribute<NodePtr> fieldValues;
+    vector<SortOrder> sortOrders;
+    string fieldName;
+    expect(json::JsonParser::tkArrayStart);
+    while (p_.peek() != json::JsonParser::tkArrayEnd) {
+        Field f = makeField(nm.ns(), fieldName);
+        fieldNames.add(f.name);
+        fieldValues.add(f.value);
+        sortOrders.push_back(f.order);
+    }
+    p_.advance();
+
+    NodeRecord r(asSingleAttribute(nm), fieldValues, fieldNames, sortOrders);
+    r.swap(*boost::static_pointer_cast<NodeRecord>(result));
+    return result;
+}
+
+Field StreamingCompiler::makeField(const string& ns, string& name)
+{
+    bool hasName = false;
+    NodePtr type;
+    SortOrder order = AVRO_ASCENDING;
+    bool hasOrder = false;
+    expect(json::JsonParser::tkObjectStart);
+    while (p_.advance() != json::JsonParser::tkObjectEnd) {
+        const string& key = p_.stringValue();
+        if (key == "name") {
+            if (hasName) {
+                fail();
+            }
+            expect(json::JsonParser::tkString);
+            name = p_.stringValue();
+            hasName = true;
+        } else if (key == "type") {
+            if (type) {
+                fail();
+            }
+            type = makeNode(ns);
+        } else if (key == "order") {
+            if (hasOrder) {
+                fail();
+            }
+            expect(json::JsonParser::tkString);
+            const string& o = p_.stringValue();
+            if (o == "ascending") {
+                order = AVRO_ASCENDING;
+            } else if (o == "descending") {
+                order = AVRO_DESCENDING;
+            } else if (o == "ignore") {
+                order = AVRO_IGNORE;
+            } else {
+                fail();
+            }
+            hasOrder = true;
+        } else {
+            skipValue();
+        }
+    }
+    if (! hasName || ! type) {
+        fail();
+    }
+    return Field(name, type, order);
+}
+
+NodePtr StreamingCompiler::makeEnum(const Name& nm)
+{
+    concepts::MultiAttribute<string> symbols;
+    expect(json::JsonParser::tkArrayStart);
+    while (p_.peek() != json::JsonParser::tkArrayEnd) {
+        expect(json::JsonParser::tkString);
+        symbols.add(p_.stringValue());
+    }
+    p_.advance();
+    NodePtr result(new NodeEnum(asSingleAttribute(nm), symbols));
+    st_[nm] = result;
+    return result;
+}
+
+/**
+ * Hands out what it reads from another stream, keeping a copy so that it
+ * can be read again after a rewind(). On destruction, returns to the other
+ * stream whatever has not been read.
+ */
+class ReplayInputStream : public InputStream {
+    InputStream& in_;
+    vector<uint8_t> data_;
+    size_t pos_;
+
+public:
+    explicit ReplayInputStream(InputStream& in) : in_(in), pos_(0) { }
+
+    ~ReplayInputStream() {
+        // What is left unread is at most the end of the last chunk
+        // obtained from in_: both compilers stop where the schema does,
+        // and the DOM one, after a rewind, gets no further back than
+        // where the other gave up.
+        if (pos_ != data_.size()) {
+            in_.backup(data_.size() - pos_);
+        }
+    }
+
+    bool next(const uint8_t** data, size_t* len) {
+        if (pos_ == data_.size()) {
+            const uint8_t* d;
+            size_t n;
+            if (! in_.next(&d, &n)) {
+                return false;
+            }
+            data_.insert(data_.end(), d, d + n);
+        }
+        *data = &data_[pos_];
+        *len = data_.size() - pos_;
+        pos_ = data_.size();
+        return true;
+    }
+
+    void backup(size_t len) {
+        pos_ -= len;
+    }
+
+    void skip(size_t len) {
+        const uint8_t* data;
+        size_t n;
+        while (len > 0 && next(&data, &n)) {
+            if (n > len) {
+                backup(n - len);
+                n = len;
+            }
+            len -= n;
+        }
+    }
+
+    size_t byteCount() const {
+        return pos_;
+    }
+
+    void rewind() {
+        pos_ = 0;
+    }
+};
+
+ValidSchema compileDom(InputStream& in)
+{
+    json::JsonParser p;
+    p.init(in);
+    Entity e = json::readEntity(p);
+    p.drain();
     SymbolTable st;
     NodePtr n = makeNode(e, st, "");
     return ValidSchema(n);
 }
 
+}   // namespace
+
+AVRO_DECL ValidSchema compileJsonSchemaFromStream(InputStream& is)
+{
+    // Reads just the schema, leaving whatever follows it in the stream.
+    ReplayInputStream in(is);
+    try {
+        return ValidSchema(StreamingCompiler(in).compile());
+    } catch (StreamingCompiler::Unsupported&) {
+    }
+    in.rewind();
+    return compileDom(in);
+}
+
 AVRO_DECL ValidSchema compileJsonSchemaFromMemory(const uint8_t* input, size_t len)
 {
-    return compileJsonSchemaFromStream(*memoryInputStream(input, len));
+    try {
+        std::auto_ptr<InputStream> in = memoryInputStream(input, len);
+        return ValidSchema(StreamingCompiler(*in).compile());
+    } catch (StreamingCompiler::Unsupported&) {
+    }
+
+    std::auto_ptr<InputStream> in = memoryInputStream(input, len);
+    return compileDom(*in);
 }
 
 AVRO_DECL ValidSchema compileJsonSchemaFromString(const char* input)
@@ -300,12 +685,174 @@ AVRO_DECL ValidSchema compileJsonSchemaFromString(const char* input)
         ::strlen(input));
 }
 
+AVRO_DECL ValidSchema compileJsonSchemaFromString(const std::string& input)
+{
+    return compileJsonSchemaFromMemory(
+        reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+namespace {
+
+/**
+ * The schemas compiledSchema() has compiled, by fingerprint.
+ */
+struct CompiledSchemas {
+    // Guards schemas.
+    Mutex mutex;
+    map<uint64_t, ValidSchema> schemas;
+};
+
+CompiledSchemas& compiledSchemas()
+{
+    static CompiledSchemas result;
+    return result;
+}
+
+// C++98 does not make the initialization of function-local statics
+// thread-safe, so do it during static initialization, before there are
+// threads to race.
+CompiledSchemas& compiledSchemasInit = compiledSchemas();
+
+}   // namespace
+
+AVRO_DECL const ValidSchema& compiledSchema(uint64_t fingerprint,
+    const char* json)
+{
+    CompiledSchemas& cs = compiledSchemas();
+    Lock l(cs.mutex);
+    map<uint64_t, ValidSchema>::iterator it = cs.schemas.find(fingerprint);
+    if (it == cs.schemas.end()) {
+        it = cs.schemas.insert(std::make_pair(fingerprint,
+            compileJsonSchemaFromString(json))).first;
+    }
+    return it->second;
+}
+
 static ValidSchema compile(std::istream& is)
 {
     std::auto_ptr<InputStream> in = istreamInputStream(is);
     return compileJsonSchemaFromStream(*in);
 }
 
+class SchemaCache::Impl {
+    struct Entry {
+        size_t hash;
+        std::string text;
+        ValidSchema schema;
+    };
+    typedef std::list<Entry> Entries;
+    typedef std::multimap<size_t, Entries::iterator> Index;
+
+    const size_t capacity_;
+    mutable Mutex mutex_;
+    // Most recently used first.
+    Entries entries_;
+    Index index_;
+
+    Index::iterator find(size_t h, const uint8_t* input, size_t len) {
+        std::pair<Index::iterator, Index::iterator> r = index_.equal_range(h);
+        for (Index::iterator it = r.first; it != r.second; ++it) {
+            const std::string& t = it->second->text;
+            if (t.size() == len && ::memcmp(t.data(), input, len) == 0) {
+                return it;
+            }
+        }
+        return index_.end();
+    }
+
+    void erase(Entries::iterator e) {
+        std::pair<Index::iterator, Index::iterator> r =
+            index_.equal_range(e->hash);
+        for (Index::iterator it = r.first; it != r.second; ++it) {
+            if (it->second == e) {
+                index_.erase(it);
+                break;
+            }
+        }
+        entries_.erase(e);
+    }
+
+public:
+    Impl(size_t capacity) : capacity_(capacity) { }
+
+    ValidSchema compile(const uint8_t* input, size_t len) {
+        const size_t h = hashing::hashBytes(input, len);
+        {
+            Lock l(mutex_);
+            Index::iterator it = find(h, input, len);
+            if (it != index_.end()) {
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return it->second->schema;
+            }
+        }
+
+        // Compile without the lock, so that other threads can use the
+        // cache meanwhile. Should two threads compile the same text, the
+        // first to finish wins.
+        ValidSchema schema = compileJsonSchemaFromMemory(input, len);
+        if (capacity_ == 0) {
+            return schema;
+        }
+
+        Lock l(mutex_);
+        Index::iterator it = find(h, input, len);
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->schema;
+        }
+        entries_.push_front(Entry());
+        Entry& e = entries_.front();
+        e.hash = h;
+        e.text.assign(reinterpret_cast<const char*>(input), len);
+        e.schema = schema;
+        index_.insert(std::make_pair(h, entries_.begin()));
+        if (entries_.size() > capacity_) {
+            erase(--entries_.end());
+        }
+        return schema;
+    }
+
+    size_t size() const {
+        Lock l(mutex_);
+        return entries_.size();
+    }
+
+    void clear() {
+        Lock l(mutex_);
+        index_.clear();
+        entries_.clear();
+    }
+};
+
+SchemaCache::SchemaCache(size_t capacity) : impl_(new Impl(capacity))
+{
+}
+
+SchemaCache::~SchemaCache()
+{
+}
+
+ValidSchema SchemaCache::compile(const uint8_t* input, size_t len)
+{
+    return impl_->compile(input, len);
+}
+
+ValidSchema SchemaCache::compile(const std::string& input)
+{
+    return impl_->compile(
+        reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+size_t SchemaCache::size() const
+{
+    return impl_->size();
+}
+
+void SchemaCache::clear()
+{
+    impl_->clear();
+}
+
 AVRO_DECL void compileJsonSchema(std::istream &is, ValidSchema &schema)
 {
     if (!is.good()) {
@@ -21,6 +21,7 @@
 #include "Exception.hh"
 
 #include <sstream>
+#include <algorithm>
 
 #include <boost/random/mersenne_twister.hpp>
 
@@ -41,6 +42,7 @@ const string AVRO_NULL_CODEC("null");
 const size_t minSyncInterval = 32;
 const size_t maxSyncInterval = 1u << 30;
 const size_t defaultSyncInterval = 16 * 1024;
+const size_t SyncSize = DataFileSync::static_size;
 
 static string toString(const ValidSchema& schema)
 {
@@ -50,8 +52,10 @@ static string toString(const ValidSchema& schema)
 }
 
 DataFileWriterBase::DataFileWriterBase(const char* filename,
-    const ValidSchema& schema, size_t syncInterval) :
+    const ValidSchema& schema, size_t syncInterval,
+    const EncoderPtr& encoder) :
     filename_(filename), schema_(schema), encoderPtr_(binaryEncoder()),
+    dataEncoderPtr_(encoder ? encoder : binaryEncoder()),
     syncInterval_(syncInterval),
     stream_(fileOutputStream(filename)),
     buffer_(memoryOutputStream()),
@@ -67,7 +71,7 @@ DataFileWriterBase::DataFileWriterBase(const char* filename,
     setMetadata(AVRO_SCHEMA_KEY, toString(schema));
 
     writeHeader();
-    encoderPtr_->init(*buffer_);
+    dataEncoderPtr_->init(*buffer_);
 }
 
 DataFileWriterBase::~DataFileWriterBase()
@@ -85,7 +89,7 @@ void DataFileWriterBase::close()
 
 void DataFileWriterBase::sync()
 {
-    encoderPtr_->flush();
+    dataEncoderPtr_->flush();
 
     encoderPtr_->init(*stream_);
     avro::encode(*encoderPtr_, objectCount_);
@@ -102,13 +106,13 @@ void DataFileWriterBase::sync()
 
 
     buffer_ = memoryOutputStream();
-    encoderPtr_->init(*buffer_);
+    dataEncoderPtr_->init(*buffer_);
     objectCount_ = 0;
 }
 
 void DataFileWriterBase::syncIfNeeded()
 {
-    encoderPtr_->flush();
+    dataEncoderPtr_->flush();
     if (buffer_->byteCount() >= syncInterval_) {
         sync();
     }
@@ -150,8 +154,9 @@ void DataFileWriterBase::setMetadata(const string& key, const string& value)
 }
 
 DataFileReaderBase::DataFileReaderBase(const char* filename) :
-    filename_(filename), stream_(fileInputStream(filename)),
-    decoder_(binaryDecoder()), objectCount_(0)
+    filename_(filename), stream_(fileSeekableInputStream(filename)),
+    decoder_(binaryDecoder()), objectCount_(0), eof_(false), blockStart_(-1),
+    blockEnd_(-1)
 {
     readHeader();
 }
@@ -172,13 +177,6 @@ void DataFileReaderBase::init(const ValidSchema& readerSchema)
     readDataBlock();
 }
 
-static void drain(InputStream& in)
-{
-    const uint8_t *p = 0;
-    size_t n = 0;
-    while (in.next(&p, &n));
-}
-
 char hex(unsigned int x)
 {
     return x + (x < 10 ? '0' :  ('a' - 10));
@@ -196,11 +194,14 @@ std::ostream& operator << (std::ostream& os, const DataFileSync& s)
 
 bool DataFileReaderBase::hasMore()
 {
-    if (objectCount_ != 0) {
+    if (eof_) {
+        return false;
+    } else if (objectCount_ != 0) {
         return true;
     }
+    // Skip whatever is left of the current block without reading it.
     dataDecoder_->init(*dataStream_);
-    drain(*dataStream_);
+    dataStream_->skip(static_cast<size_t>(blockEnd_ - stream_->byteCount()));
     DataFileSync s;
     decoder_->init(*stream_);
     avro::decode(*decoder_, s);
@@ -243,6 +244,10 @@ class BoundedInputStream : public InputStream {
         return in_.byteCount();
     }
 
+    bool stable() const {
+        return in_.stable();
+    }
+
 public:
     BoundedInputStream(InputStream& in, size_t limit) :
         in_(in), limit_(limit) { }
@@ -256,9 +261,11 @@ auto_ptr<InputStream> boundedInputStream(InputStream& in, size_t limit)
 bool DataFileReaderBase::readDataBlock()
 {
     decoder_->init(*stream_);
+    blockStart_ = stream_->byteCount();
     const uint8_t* p = 0;
     size_t n = 0;
     if (! stream_->next(&p, &n)) {
+        eof_ = true;
         return false;
     }
     stream_->backup(n);
@@ -266,6 +273,7 @@ bool DataFileReaderBase::readDataBlock()
     int64_t byteCount;
     avro::decode(*decoder_, byteCount);
     decoder_->init(*stream_);
+    blockEnd_ = stream_->byteCount() + byteCount;
 
     auto_ptr<InputStream> st = boundedInputStream(*stream_, static_cast<size_t>(byteCount));
     dataDecoder_->init(*st);
@@ -277,6 +285,116 @@ void DataFileReaderBase::close()
 {
 }
 
+void DataFileReaderBase::skipBlock()
+{
+    objectCount_ = 0;
+}
+
+int64_t DataFileReaderBase::countRecords()
+{
+    int64_t result = 0;
+    while (hasMore()) {
+        result += objectCount_;
+        objectCount_ = 0;
+    }
+    return result;
+}
+
+void DataFileReaderBase::doSeek(int64_t position)
+{
+    // Make the decoders return whatever they have buffered so that
+    // nothing is backed up into the stream after the seek.
+    if (dataStream_.get()) {
+        dataDecoder_->init(*dataStream_);
+    }
+    decoder_->init(*stream_);
+    stream_->seek(position);
+    objectCount_ = 0;
+    eof_ = false;
+}
+
+void DataFileReaderBase::seek(int64_t position)
+{
+    doSeek(position);
+    readDataBlock();
+}
+
+/**
+ * Returns the offset of the first occurrence of \p sync in the \p n bytes
+ * at \p p, or \p n if there is none.
+ */
+static size_t findSync(const uint8_t* p, size_t n, const DataFileSync& sync)
+{
+    if (n < SyncSize) {
+        return n;
+    }
+    const uint8_t* const last = p + (n - SyncSize);
+    for (const uint8_t* q = p; q <= last; ++q) {
+        q = static_cast<const uint8_t*>(::memchr(q, sync[0], last - q + 1));
+        if (q == 0) {
+            break;
+        } else if (::memcmp(q, sync.data(), SyncSize) == 0) {
+            return q - p;
+        }
+    }
+    return n;
+}
+
+void DataFileReaderBase::sync(int64_t position)
+{
+    doSeek(position);
+
+    // The last SyncSize - 1 bytes of the data seen so far, followed by
+    // up to SyncSize - 1 bytes from the current chunk. This catches the
+    // markers that straddle chunk boundaries.
+    uint8_t window[2 * (SyncSize - 1)];
+    size_t tail = 0;
+
+    const uint8_t* p = 0;
+    size_t n = 0;
+    while (stream_->next(&p, &n)) {
+        size_t m = std::min(n, SyncSize - 1);
+        ::memcpy(&window[tail], p, m);
+        size_t k = findSync(window, tail + m, sync_);
+        if (k != tail + m) {
+            stream_->backup(n - (k + SyncSize - tail));
+            readDataBlock();
+            return;
+        }
+
+        k = findSync(p, n, sync_);
+        if (k != n) {
+            stream_->backup(n - (k + SyncSize));
+            readDataBlock();
+            return;
+        }
+
+        if (n >= SyncSize - 1) {
+            tail = SyncSize - 1;
+            ::memcpy(window, p + (n - tail), tail);
+        } else if (tail + m > SyncSize - 1) {
+            size_t d = tail + m - (SyncSize - 1);
+            ::memmove(window, &window[d], SyncSize - 1);
+            tail = SyncSize - 1;
+        } else {
+            tail += m;
+        }
+    }
+    blockStart_ = stream_->byteCount();
+    eof_ = true;
+}
+
+bool DataFileReaderBase::pastSync(int64_t position)
+{
+    return ! hasMore() ||
+        blockStart_ >= position + static_cast<int64_t>(SyncSize);
+}
+
+int64_t DataFileReaderBase::previousSync()
+{
+    return blockStart_;
+}
+
 static string toString(const vector<uint8_t>& v)
 {
     string result;
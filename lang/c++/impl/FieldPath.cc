@@ -0,0 +1,169 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "FieldPath.hh"
+#include "NodeImpl.hh"
+
+namespace avro {
+
+using std::string;
+
+namespace {
+
+NodePtr actual(const NodePtr& n)
+{
+    return n->type() == AVRO_SYMBOLIC ? resolveSymbol(n) : n;
+}
+
+string branchName(const NodePtr& n)
+{
+    return n->hasName() ? n->name().fullname() : toString(n->type());
+}
+
+/**
+ * Returns the branch of union \p n given in brackets in a path, by type
+ * name or position.
+ */
+size_t namedBranch(const NodePtr& n, const string& branch)
+{
+    const size_t c = n->leaves();
+    if (! branch.empty() && isdigit(static_cast<unsigned char>(branch[0]))) {
+        char* end;
+        const unsigned long b = ::strtoul(branch.c_str(), &end, 10);
+        if (*end == 0 && b < c) {
+            return b;
+        }
+    } else {
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr leaf = actual(n->leafAt(i));
+            if (branchName(leaf) == branch ||
+                (leaf->hasName() && leaf->name().simpleName() == branch)) {
+                return i;
+            }
+        }
+    }
+    throw Exception(boost::format("No branch %1% in union") % branch);
+}
+
+/**
+ * Returns the one branch of union \p n that is a record with a field
+ * called \p field.
+ */
+size_t recordBranch(const NodePtr& n, const string& field)
+{
+    const size_t c = n->leaves();
+    size_t result = c;
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr leaf = actual(n->leafAt(i));
+        size_t index;
+        if (leaf->type() == AVRO_RECORD && leaf->nameIndex(field, index)) {
+            if (result != c) {
+                throw Exception(boost::format("More than one branch of "
+                    "the union has field %1%") % field);
+            }
+            result = i;
+        }
+    }
+    if (result == c) {
+        throw Exception(boost::format("No branch of the union has field %1%")
+            % field);
+    }
+    return result;
+}
+
+}   // namespace
+
+FieldPath::FieldPath(const ValidSchema& schema, const string& path) :
+    path_(path)
+{
+    NodePtr n = actual(schema.root());
+    size_t pos = 0;
+    for (; ; ) {
+        const size_t end = path.find_first_of(".[", pos);
+        const string field = path.substr(pos, end - pos);
+        if (field.empty()) {
+            throw Exception(boost::format("Malformed field path: %1%") % path);
+        }
+        pos = (end == string::npos) ? path.size() : end;
+
+        if (n->type() == AVRO_UNION) {
+            Step s = { BRANCH, recordBranch(n, field) };
+            steps_.push_back(s);
+            n = actual(n->leafAt(s.index));
+        }
+        if (n->type() != AVRO_RECORD) {
+            throw Exception(boost::format("Cannot find field %1% in %2%") %
+                field % toString(n->type()));
+        }
+        Step s = { FIELD, 0 };
+        if (! n->nameIndex(field, s.index)) {
+            throw Exception(boost::format("No field %1% in record %2%") %
+                field % n->name());
+        }
+        steps_.push_back(s);
+        n = actual(n->leafAt(s.index));
+
+        if (pos < path.size() && path[pos] == '[') {
+            const size_t close = path.find(']', pos);
+            if (close == string::npos) {
+                throw Exception(boost::format("Malformed field path: %1%") %
+                    path);
+            }
+            if (n->type() != AVRO_UNION) {
+                throw Exception(boost::format("Field %1% is not a union") %
+                    field);
+            }
+            Step b = { BRANCH,
+                namedBranch(n, path.substr(pos + 1, close - pos - 1)) };
+            steps_.push_back(b);
+            n = actual(n->leafAt(b.index));
+            pos = close + 1;
+        }
+
+        if (pos == path.size()) {
+            break;
+        }
+        if (path[pos] != '.') {
+            throw Exception(boost::format("Malformed field path: %1%") % path);
+        }
+        ++pos;
+    }
+}
+
+const GenericDatum& FieldPath::get(const GenericDatum& d) const
+{
+    const GenericDatum* result = find(d);
+    if (result == 0) {
+        throw Exception(boost::format("No value at %1%") % path_);
+    }
+    return *result;
+}
+
+GenericDatum& FieldPath::get(GenericDatum& d) const
+{
+    GenericDatum* result = find(d);
+    if (result == 0) {
+        throw Exception(boost::format("No value at %1%") % path_);
+    }
+    return *result;
+}
+
+}   // namespace avro
@@ -41,7 +41,7 @@ namespace avro {
 namespace {
 struct BufferCopyIn {
     virtual ~BufferCopyIn() { }
-    virtual void seek(size_t len) = 0;
+    virtual void seek(int64_t len) = 0;
     virtual bool read(uint8_t* b, size_t toRead, size_t& actual) = 0;
 
 };
@@ -60,7 +60,7 @@ struct FileBufferCopyIn : public BufferCopyIn {
         ::CloseHandle(h_);
     }
 
-    void seek(size_t len) {
+    void seek(int64_t len) {
         if (::SetFilePointer(h_, len, NULL, FILE_CURRENT) != INVALID_SET_FILE_POINTER) {
             throw Exception(boost::format("Cannot skip file: %1%") % ::GetLastError());
         }
@@ -89,7 +89,7 @@ struct FileBufferCopyIn : public BufferCopyIn {
         ::close(fd_);
     }
 
-    void seek(size_t len) {
+    void seek(int64_t len) {
         off_t r = ::lseek(fd_, len, SEEK_CUR);
         if (r == static_cast<off_t>(-1)) {
             throw Exception(boost::format("Cannot skip file: %1%") %
@@ -115,7 +115,7 @@ struct IStreamBufferCopyIn : public BufferCopyIn {
     IStreamBufferCopyIn(istream& is) : is_(is) {
     }
 
-    void seek(size_t len) {
+    void seek(int64_t len) {
         if (! is_.seekg(len, std::ios_base::cur)) {
             throw Exception("Cannot skip stream");
         }
@@ -134,7 +134,7 @@ struct IStreamBufferCopyIn : public BufferCopyIn {
 
 }
 
-class BufferCopyInInputStream : public InputStream {
+class BufferCopyInInputStream : public SeekableInputStream {
     const size_t bufferSize_;
     uint8_t* const buffer_;
     auto_ptr<BufferCopyIn> in_;
@@ -177,6 +177,14 @@ class BufferCopyInInputStream : public InputStream {
 
     size_t byteCount() const { return byteCount_; }
 
+    void seek(int64_t position) {
+        // BufferCopyIn::seek() is relative to the end of the data already
+        // read into the buffer.
+        in_->seek(position - static_cast<int64_t>(byteCount_ + available_));
+        byteCount_ = position;
+        available_ = 0;
+    }
+
     bool fill() {
         size_t n = 0;
         if (in_->read(buffer_, bufferSize_, n)) {
@@ -329,6 +337,14 @@ auto_ptr<InputStream> fileInputStream(const char* filename,
     return auto_ptr<InputStream>( new BufferCopyInInputStream(in, bufferSize));
 }
 
+auto_ptr<SeekableInputStream> fileSeekableInputStream(const char* filename,
+    size_t bufferSize)
+{
+    auto_ptr<BufferCopyIn> in(new FileBufferCopyIn(filename));
+    return auto_ptr<SeekableInputStream>(
+        new BufferCopyInInputStream(in, bufferSize));
+}
+
 auto_ptr<InputStream> istreamInputStream(istream& is,
     size_t bufferSize)
 {
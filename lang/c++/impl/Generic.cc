@@ -18,6 +18,7 @@
 
 #include "Generic.hh"
 #include "NodeImpl.hh"
+#include "BinaryCodec.hh"
 #include <sstream>
 
 namespace avro {
@@ -111,22 +112,147 @@ GenericRecord::GenericRecord(const NodePtr& schema) :
 
 GenericReader::GenericReader(const ValidSchema& s, const DecoderPtr& decoder) :
     schema_(s), isResolving_(dynamic_cast<ResolvingDecoder*>(&(*decoder)) != 0),
-    decoder_(decoder)
+    decoder_(decoder), table_(s)
 {
+    init();
 }
 
 GenericReader::GenericReader(const ValidSchema& writerSchema,
     const ValidSchema& readerSchema, const DecoderPtr& decoder) :
     schema_(readerSchema),
     isResolving_(true),
-    decoder_(resolvingDecoder(writerSchema, readerSchema, decoder))
+    decoder_(resolvingDecoder(writerSchema, readerSchema, decoder)),
+    table_(readerSchema)
 {
+    init();
+}
+
+void GenericReader::init()
+{
+    const size_t c = table_.size();
+    prototypes_.resize(c);
+    branches_.resize(c);
+    for (size_t i = 0; i < c; ++i) {
+        switch (table_.type(i)) {
+        case AVRO_SYMBOLIC:
+            break;
+        case AVRO_UNION:
+            prototypes_[i] = GenericDatum(table_.node(i));
+            for (size_t j = 0; j < table_.leaves(i); ++j) {
+                branches_[i].push_back(prototypes_[i]);
+                branches_[i].back().selectBranch(j);
+            }
+            break;
+        default:
+            prototypes_[i] = GenericDatum(table_.node(i));
+            break;
+        }
+    }
 }
 
 void GenericReader::read(GenericDatum& datum) const
 {
-    datum = GenericDatum(schema_.root());
-    read(datum, *decoder_, isResolving_);
+    datum = prototypes_[table_.root()];
+    read(table_.root(), datum, *decoder_);
+}
+
+void GenericReader::read(size_t n, GenericDatum& datum, Decoder& d) const
+{
+    n = table_.resolve(n);
+    if (table_.type(n) == AVRO_UNION) {
+        size_t b = d.decodeUnionIndex();
+        if (b >= table_.leaves(n)) {
+            throw Exception(boost::format("Union branch %1% out of range")
+                % b);
+        }
+        if (datum.unionBranch() != b) {
+            datum = branches_[n][b];
+        }
+        n = table_.resolve(table_.leafAt(n, b));
+    }
+    switch (table_.type(n)) {
+    case AVRO_NULL:
+        d.decodeNull();
+        break;
+    case AVRO_BOOL:
+        datum.value<bool>() = d.decodeBool();
+        break;
+    case AVRO_INT:
+        datum.value<int32_t>() = d.decodeInt();
+        break;
+    case AVRO_LONG:
+        datum.value<int64_t>() = d.decodeLong();
+        break;
+    case AVRO_FLOAT:
+        datum.value<float>() = d.decodeFloat();
+        break;
+    case AVRO_DOUBLE:
+        datum.value<double>() = d.decodeDouble();
+        break;
+    case AVRO_STRING:
+        d.decodeString(datum.value<string>());
+        break;
+    case AVRO_BYTES:
+        d.decodeBytes(datum.value<bytes>());
+        break;
+    case AVRO_FIXED:
+        d.decodeFixed(table_.fixedSize(n), datum.value<GenericFixed>().value());
+        break;
+    case AVRO_RECORD:
+        {
+            GenericRecord& r = datum.value<GenericRecord>();
+            size_t c = table_.leaves(n);
+            if (isResolving_) {
+                const std::vector<size_t>& fo =
+                    static_cast<ResolvingDecoder&>(d).fieldOrder();
+                for (size_t i = 0; i < c; ++i) {
+                    read(table_.leafAt(n, fo[i]), r.fieldAt(fo[i]), d);
+                }
+            } else {
+                for (size_t i = 0; i < c; ++i) {
+                    read(table_.leafAt(n, i), r.fieldAt(i), d);
+                }
+            }
+        }
+        break;
+    case AVRO_ENUM:
+        datum.value<GenericEnum>().set(d.decodeEnum());
+        break;
+    case AVRO_ARRAY:
+        {
+            vector<GenericDatum>& r = datum.value<GenericArray>().value();
+            const size_t nn = table_.resolve(table_.leafAt(n, 0));
+            r.resize(0);
+            size_t start = 0;
+            for (size_t m = d.arrayStart(); m != 0; m = d.arrayNext()) {
+                r.resize(r.size() + m);
+                for (; start < r.size(); ++start) {
+                    r[start] = prototypes_[nn];
+                    read(nn, r[start], d);
+                }
+            }
+        }
+        break;
+    case AVRO_MAP:
+        {
+            GenericMap::Value& r = datum.value<GenericMap>().value();
+            const size_t nn = table_.resolve(table_.leafAt(n, 1));
+            r.resize(0);
+            size_t start = 0;
+            for (size_t m = d.mapStart(); m != 0; m = d.mapNext()) {
+                r.resize(r.size() + m);
+                for (; start < r.size(); ++start) {
+                    d.decodeString(r[start].first);
+                    r[start].second = prototypes_[nn];
+                    read(nn, r[start].second, d);
+                }
+            }
+        }
+        break;
+    default:
+        throw Exception(boost::format("Unknown schema type %1%") %
+            toString(table_.type(n)));
+    }
 }
 
 void GenericReader::read(GenericDatum& datum, Decoder& d, bool isResolving)
@@ -170,7 +296,7 @@ void GenericReader::read(GenericDatum& datum, Decoder& d, bool isResolving)
             GenericRecord& r = datum.value<GenericRecord>();
             size_t c = r.schema()->leaves();
             if (isResolving) {
-                std::vector<size_t> fo =
+                const std::vector<size_t>& fo =
                     static_cast<ResolvingDecoder&>(d).fieldOrder();
                 for (size_t i = 0; i < c; ++i) {
                     read(r.fieldAt(fo[i]), d, isResolving);
@@ -236,13 +362,114 @@ void GenericReader::read(Decoder& d, GenericDatum& g)
 }
 
 GenericWriter::GenericWriter(const ValidSchema& s, const EncoderPtr& encoder) :
-    schema_(s), encoder_(encoder)
+    schema_(s), encoder_(encoder), table_(s)
 {
 }
 
 void GenericWriter::write(const GenericDatum& datum) const
 {
-    write(datum, *encoder_);
+    write(table_.root(), datum, *encoder_);
+}
+
+void GenericWriter::write(size_t n, const GenericDatum& datum,
+    Encoder& e) const
+{
+    n = table_.resolve(n);
+    if (table_.type(n) == AVRO_UNION) {
+        if (! datum.isUnion()) {
+            throw Exception("Datum is not a union");
+        }
+        size_t b = datum.unionBranch();
+        if (b >= table_.leaves(n)) {
+            throw Exception("Union datum has no branch selected");
+        }
+        e.encodeUnionIndex(b);
+        n = table_.resolve(table_.leafAt(n, b));
+    }
+    if (datum.type() != table_.type(n)) {
+        throw Exception(boost::format("Datum of type %1% for schema %2%") %
+            toString(datum.type()) % toString(table_.type(n)));
+    }
+    switch (table_.type(n)) {
+    case AVRO_NULL:
+        e.encodeNull();
+        break;
+    case AVRO_BOOL:
+        e.encodeBool(datum.value<bool>());
+        break;
+    case AVRO_INT:
+        e.encodeInt(datum.value<int32_t>());
+        break;
+    case AVRO_LONG:
+        e.encodeLong(datum.value<int64_t>());
+        break;
+    case AVRO_FLOAT:
+        e.encodeFloat(datum.value<float>());
+        break;
+    case AVRO_DOUBLE:
+        e.encodeDouble(datum.value<double>());
+        break;
+    case AVRO_STRING:
+        e.encodeString(datum.value<string>());
+        break;
+    case AVRO_BYTES:
+        e.encodeBytes(datum.value<bytes>());
+        break;
+    case AVRO_FIXED:
+        e.encodeFixed(datum.value<GenericFixed>().value());
+        break;
+    case AVRO_RECORD:
+        {
+            const GenericRecord& r = datum.value<GenericRecord>();
+            size_t c = table_.leaves(n);
+            if (r.fieldCount() != c) {
+                throw Exception("Record datum does not match its schema");
+            }
+            for (size_t i = 0; i < c; ++i) {
+                write(table_.leafAt(n, i), r.fieldAt(i), e);
+            }
+        }
+        break;
+    case AVRO_ENUM:
+        e.encodeEnum(datum.value<GenericEnum>().value());
+        break;
+    case AVRO_ARRAY:
+        {
+            const GenericArray::Value& r = datum.value<GenericArray>().value();
+            const size_t nn = table_.leafAt(n, 0);
+            e.arrayStart();
+            if (! r.empty()) {
+                e.setItemCount(r.size());
+                for (GenericArray::Value::const_iterator it = r.begin();
+                    it != r.end(); ++it) {
+                    e.startItem();
+                    write(nn, *it, e);
+                }
+            }
+            e.arrayEnd();
+        }
+        break;
+    case AVRO_MAP:
+        {
+            const GenericMap::Value& r = datum.value<GenericMap>().value();
+            const size_t nn = table_.leafAt(n, 1);
+            e.mapStart();
+            if (! r.empty()) {
+                e.setItemCount(r.size());
+                for (GenericMap::Value::const_iterator it = r.begin();
+                    it != r.end(); ++it) {
+                    e.startItem();
+                    e.encodeString(it->first);
+                    write(nn, it->second, e);
+                }
+            }
+            e.mapEnd();
+        }
+        break;
+    default:
+        throw Exception(boost::format("Unknown schema type %1%") %
+            toString(table_.type(n)));
+    }
 }
 
 void GenericWriter::write(const GenericDatum& datum, Encoder& e)
@@ -332,4 +559,81 @@ void GenericWriter::write(Encoder& e, const GenericDatum& g)
     write(g, e);
 }
 
+size_t encodedSize(const GenericDatum& datum)
+{
+    size_t result = datum.isUnion() ?
+        binary::longSize(datum.unionBranch()) : 0;
+    switch (datum.type()) {
+    case AVRO_NULL:
+        break;
+    case AVRO_BOOL:
+        result += 1;
+        break;
+    case AVRO_INT:
+        result += binary::longSize(datum.value<int32_t>());
+        break;
+    case AVRO_LONG:
+        result += binary::longSize(datum.value<int64_t>());
+        break;
+    case AVRO_FLOAT:
+        result += sizeof(float);
+        break;
+    case AVRO_DOUBLE:
+        result += sizeof(double);
+        break;
+    case AVRO_STRING:
+        result += binary::size(datum.value<string>());
+        break;
+    case AVRO_BYTES:
+        result += binary::size(datum.value<bytes>());
+        break;
+    case AVRO_FIXED:
+        result += datum.value<GenericFixed>().value().size();
+        break;
+    case AVRO_RECORD:
+        {
+            const GenericRecord& r = datum.value<GenericRecord>();
+            size_t c = r.fieldCount();
+            for (size_t i = 0; i < c; ++i) {
+                result += encodedSize(r.fieldAt(i));
+            }
+        }
+        break;
+    case AVRO_ENUM:
+        result += binary::longSize(datum.value<GenericEnum>().value());
+        break;
+    case AVRO_ARRAY:
+        {
+            const GenericArray::Value& r = datum.value<GenericArray>().value();
+            if (! r.empty()) {
+                result += binary::longSize(r.size());
+                for (GenericArray::Value::const_iterator it = r.begin();
+                    it != r.end(); ++it) {
+                    result += encodedSize(*it);
+                }
+            }
+            result += 1;
+        }
+        break;
+    case AVRO_MAP:
+        {
+            const GenericMap::Value& r = datum.value<GenericMap>().value();
+            if (! r.empty()) {
+                result += binary::longSize(r.size());
+                for (GenericMap::Value::const_iterator it = r.begin();
+                    it != r.end(); ++it) {
+                    result += binary::size(it->first) +
+                        encodedSize(it->second);
+                }
+            }
+            result += 1;
+        }
+        break;
+    default:
+        throw Exception(boost::format("Unknown schema type %1%") %
+            toString(datum.type()));
+    }
+    return result;
+}
+
 }   // namespace avro
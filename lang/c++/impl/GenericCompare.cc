@@ -0,0 +1,484 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "Generic.hh"
+#include "Exception.hh"
+#include "Ordering.hh"
+
+namespace avro {
+
+using std::string;
+using std::vector;
+
+/**
+ * Reaches into generic data without checking their types, for walkers
+ * that know the types from the schema.
+ */
+struct GenericAccess {
+    template <typename T>
+    static const T& value(const GenericDatum& d) {
+        return *boost::unsafe_any_cast<T>(&d.value_);
+    }
+
+    static const GenericDatum& datum(const GenericDatum& d) {
+        return value<GenericUnion>(d).datum_;
+    }
+};
+
+namespace {
+
+using ordering::compareScalar;
+using ordering::compareReal;
+using ordering::compareBytes;
+
+typedef vector<uint8_t> bytes;
+typedef GenericMap::Value::value_type MapEntry;
+
+/*
+ * The walkers below are written once and take the types of the data from
+ * a schema policy: either a SchemaTable, when the schema is known up
+ * front, or the data themselves.
+ */
+
+/**
+ * Takes the types of the data from a flattened schema. Positions are
+ * entries of the table.
+ */
+class TableSchema {
+    const SchemaTable& table_;
+
+public:
+    typedef size_t Pos;
+
+    explicit TableSchema(const SchemaTable& table) : table_(table) { }
+
+    Pos resolve(Pos p) const {
+        return table_.resolve(p);
+    }
+
+    Type type(const GenericDatum&, Pos p) const {
+        return table_.type(p);
+    }
+
+    bool isUnion(const GenericDatum&, Pos p) const {
+        return table_.type(p) == AVRO_UNION;
+    }
+
+    size_t branch(const GenericDatum& d) const {
+        return GenericAccess::value<GenericUnion>(d).currentBranch();
+    }
+
+    const GenericDatum& inner(const GenericDatum& d) const {
+        return GenericAccess::datum(d);
+    }
+
+    // A union that has not had a branch selected reports one past the
+    // last.
+    bool hasBranch(Pos p, size_t b) const {
+        return b < table_.leaves(p);
+    }
+
+    Pos branchAt(Pos p, size_t b) const {
+        return table_.resolve(table_.leafAt(p, b));
+    }
+
+    template <typename T>
+    const T& get(const GenericDatum& d) const {
+        return GenericAccess::value<T>(d);
+    }
+
+    SortOrder orderAt(const GenericRecord&, Pos p, size_t i) const {
+        return table_.sortOrderAt(p, i);
+    }
+
+    Pos leafAt(Pos p, size_t i) const {
+        return table_.leafAt(p, i);
+    }
+};
+
+/**
+ * Takes the types of the data from the data. Positions carry nothing;
+ * GenericDatum::value() sees through unions on its own.
+ */
+struct DatumSchema {
+    typedef int Pos;
+
+    Pos resolve(Pos p) const {
+        return p;
+    }
+
+    Type type(const GenericDatum& d, Pos) const {
+        return d.type();
+    }
+
+    bool isUnion(const GenericDatum& d, Pos) const {
+        return d.isUnion();
+    }
+
+    size_t branch(const GenericDatum& d) const {
+        return d.unionBranch();
+    }
+
+    const GenericDatum& inner(const GenericDatum& d) const {
+        return d;
+    }
+
+    // Without a branch, a union holds a null datum.
+    bool hasBranch(Pos, size_t) const {
+        return true;
+    }
+
+    Pos branchAt(Pos, size_t) const {
+        return 0;
+    }
+
+    template <typename T>
+    const T& get(const GenericDatum& d) const {
+        return d.value<T>();
+    }
+
+    SortOrder orderAt(const GenericRecord& r, Pos, size_t i) const {
+        return r.schema()->sortOrderAt(i);
+    }
+
+    Pos leafAt(Pos, size_t) const {
+        return 0;
+    }
+};
+
+int compareBytes(const bytes& a, const bytes& b)
+{
+    return compareBytes(a.empty() ? 0 : &a[0], a.size(),
+        b.empty() ? 0 : &b[0], b.size());
+}
+
+bool keyLess(const MapEntry* a, const MapEntry* b)
+{
+    return a->first < b->first;
+}
+
+void sortedEntries(const GenericMap::Value& m, vector<const MapEntry*>& v)
+{
+    v.reserve(m.size());
+    for (GenericMap::Value::const_iterator it = m.begin();
+        it != m.end(); ++it) {
+        v.push_back(&*it);
+    }
+    std::sort(v.begin(), v.end(), keyLess);
+}
+
+template <typename S>
+int compareDatum(const S& s, typename S::Pos p,
+    const GenericDatum& a, const GenericDatum& b, bool equality);
+
+/**
+ * Returns 0 if the maps have the same keys with equal values, 1 otherwise.
+ */
+template <typename S>
+int compareMaps(const S& s, typename S::Pos p,
+    const GenericMap::Value& a, const GenericMap::Value& b)
+{
+    if (a.size() != b.size()) {
+        return 1;
+    }
+    vector<const MapEntry*> sa;
+    vector<const MapEntry*> sb;
+    sortedEntries(a, sa);
+    sortedEntries(b, sb);
+    const typename S::Pos vp = s.leafAt(p, 1);
+    for (size_t i = 0; i < sa.size(); ++i) {
+        if (sa[i]->first != sb[i]->first ||
+            compareDatum(s, vp, sa[i]->second, sb[i]->second, true) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Compares two values of resolved position p that are not unions, or
+ * whose union branches have been found equal.
+ */
+template <typename S>
+int compareValue(const S& s, typename S::Pos p,
+    const GenericDatum& a, const GenericDatum& b, bool equality)
+{
+    const Type t = s.type(a, p);
+    const Type tb = s.type(b, p);
+    if (t != tb) {
+        return t < tb ? -1 : 1;
+    }
+    switch (t) {
+    case AVRO_NULL:
+        return 0;
+    case AVRO_BOOL:
+        return compareScalar(s.template get<bool>(a),
+            s.template get<bool>(b));
+    case AVRO_INT:
+        return compareScalar(s.template get<int32_t>(a),
+            s.template get<int32_t>(b));
+    case AVRO_LONG:
+        return compareScalar(s.template get<int64_t>(a),
+            s.template get<int64_t>(b));
+    case AVRO_FLOAT:
+        return compareReal(s.template get<float>(a),
+            s.template get<float>(b));
+    case AVRO_DOUBLE:
+        return compareReal(s.template get<double>(a),
+            s.template get<double>(b));
+    case AVRO_STRING:
+        {
+            const string& sa = s.template get<string>(a);
+            const string& sb = s.template get<string>(b);
+            return compareBytes(
+                reinterpret_cast<const uint8_t*>(sa.data()), sa.size(),
+                reinterpret_cast<const uint8_t*>(sb.data()), sb.size());
+        }
+    case AVRO_BYTES:
+        return compareBytes(s.template get<bytes>(a),
+            s.template get<bytes>(b));
+    case AVRO_FIXED:
+        return compareBytes(s.template get<GenericFixed>(a).value(),
+            s.template get<GenericFixed>(b).value());
+    case AVRO_ENUM:
+        return compareScalar(s.template get<GenericEnum>(a).value(),
+            s.template get<GenericEnum>(b).value());
+    case AVRO_RECORD:
+        {
+            const GenericRecord& ra = s.template get<GenericRecord>(a);
+            const GenericRecord& rb = s.template get<GenericRecord>(b);
+            const size_t n = ra.fieldCount();
+            if (n != rb.fieldCount()) {
+                return compareScalar(n, rb.fieldCount());
+            }
+            for (size_t i = 0; i < n; ++i) {
+                const SortOrder o = s.orderAt(ra, p, i);
+                if (o == AVRO_IGNORE) {
+                    continue;
+                }
+                const int c = compareDatum(s, s.leafAt(p, i),
+                    ra.fieldAt(i), rb.fieldAt(i), equality);
+                if (c != 0) {
+                    return o == AVRO_DESCENDING ? -c : c;
+                }
+            }
+            return 0;
+        }
+    case AVRO_ARRAY:
+        {
+            const GenericArray::Value& va =
+                s.template get<GenericArray>(a).value();
+            const GenericArray::Value& vb =
+                s.template get<GenericArray>(b).value();
+            const typename S::Pos ip = s.leafAt(p, 0);
+            const size_t n = std::min(va.size(), vb.size());
+            for (size_t i = 0; i < n; ++i) {
+                const int c = compareDatum(s, ip, va[i], vb[i], equality);
+                if (c != 0) {
+                    return c;
+                }
+            }
+            return compareScalar(va.size(), vb.size());
+        }
+    case AVRO_MAP:
+        if (! equality) {
+            throw Exception("Avro maps cannot be ordered");
+        }
+        return compareMaps(s, p, s.template get<GenericMap>(a).value(),
+            s.template get<GenericMap>(b).value());
+    default:
+        throw Exception(boost::format("Cannot compare data of type %1%") %
+            toString(t));
+    }
+}
+
+/**
+ * Compares two values at position p. With equality set, the result need
+ * only be zero or not, and maps are compared for equality rather than
+ * rejected.
+ */
+template <typename S>
+int compareDatum(const S& s, typename S::Pos p,
+    const GenericDatum& a, const GenericDatum& b, bool equality)
+{
+    p = s.resolve(p);
+    if (s.isUnion(a, p) && s.isUnion(b, p)) {
+        const size_t ba = s.branch(a);
+        const size_t bb = s.branch(b);
+        if (ba != bb) {
+            return compareScalar(ba, bb);
+        } else if (! s.hasBranch(p, ba)) {
+            return 0;
+        }
+        return compareValue(s, s.branchAt(p, ba), s.inner(a), s.inner(b),
+            equality);
+    }
+    return compareValue(s, p, a, b, equality);
+}
+
+template <typename T>
+size_t hashReal(T v)
+{
+    // All NaNs are equal, so they hash as the canonical one.
+    return avro::hash(v != v ? std::numeric_limits<T>::quiet_NaN() : v);
+}
+
+template <typename S>
+size_t hashDatum(const S& s, typename S::Pos p, const GenericDatum& d);
+
+/**
+ * Hashes a value of resolved position p that is not a union, the way
+ * hash_traits hashes the type avrogencpp generates for it.
+ */
+template <typename S>
+size_t hashValue(const S& s, typename S::Pos p, const GenericDatum& d)
+{
+    switch (s.type(d, p)) {
+    case AVRO_NULL:
+        return 0;
+    case AVRO_BOOL:
+        return avro::hash(s.template get<bool>(d));
+    case AVRO_INT:
+        return avro::hash(s.template get<int32_t>(d));
+    case AVRO_LONG:
+        return avro::hash(s.template get<int64_t>(d));
+    case AVRO_FLOAT:
+        return hashReal(s.template get<float>(d));
+    case AVRO_DOUBLE:
+        return hashReal(s.template get<double>(d));
+    case AVRO_STRING:
+        return avro::hash(s.template get<string>(d));
+    case AVRO_BYTES:
+        return avro::hash(s.template get<bytes>(d));
+    case AVRO_FIXED:
+        return avro::hash(s.template get<GenericFixed>(d).value());
+    case AVRO_ENUM:
+        return avro::hash(static_cast<int32_t>(
+            s.template get<GenericEnum>(d).value()));
+    case AVRO_RECORD:
+        {
+            const GenericRecord& r = s.template get<GenericRecord>(d);
+            const size_t n = r.fieldCount();
+            size_t h = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (s.orderAt(r, p, i) != AVRO_IGNORE) {
+                    ++h;
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (s.orderAt(r, p, i) != AVRO_IGNORE) {
+                    h = hashing::combine(h,
+                        hashDatum(s, s.leafAt(p, i), r.fieldAt(i)));
+                }
+            }
+            return h;
+        }
+    case AVRO_ARRAY:
+        {
+            const GenericArray::Value& v =
+                s.template get<GenericArray>(d).value();
+            const typename S::Pos ip = s.leafAt(p, 0);
+            size_t h = v.size();
+            for (GenericArray::Value::const_iterator it = v.begin();
+                it != v.end(); ++it) {
+                h = hashing::combine(h, hashDatum(s, ip, *it));
+            }
+            return h;
+        }
+    case AVRO_MAP:
+        {
+            vector<const MapEntry*> v;
+            sortedEntries(s.template get<GenericMap>(d).value(), v);
+            const typename S::Pos vp = s.leafAt(p, 1);
+            size_t h = v.size();
+            for (vector<const MapEntry*>::const_iterator it = v.begin();
+                it != v.end(); ++it) {
+                h = hashing::combine(h, avro::hash((*it)->first));
+                h = hashing::combine(h, hashDatum(s, vp, (*it)->second));
+            }
+            return h;
+        }
+    default:
+        throw Exception(boost::format("Cannot hash data of type %1%") %
+            toString(s.type(d, p)));
+    }
+}
+
+template <typename S>
+size_t hashDatum(const S& s, typename S::Pos p, const GenericDatum& d)
+{
+    p = s.resolve(p);
+    if (s.isUnion(d, p)) {
+        const size_t b = s.branch(d);
+        if (! s.hasBranch(p, b)) {
+            return b;
+        }
+        const typename S::Pos bp = s.branchAt(p, b);
+        const GenericDatum& v = s.inner(d);
+        return s.type(v, bp) == AVRO_NULL ? b :
+            hashing::combine(b, hashValue(s, bp, v));
+    }
+    return hashValue(s, p, d);
+}
+
+}   // namespace
+
+GenericComparator::GenericComparator(const ValidSchema& schema) :
+    table_(schema)
+{
+}
+
+int GenericComparator::compare(const GenericDatum& a,
+    const GenericDatum& b) const
+{
+    return compareDatum(TableSchema(table_),
+        table_.root(), a, b, false);
+}
+
+bool GenericComparator::equals(const GenericDatum& a,
+    const GenericDatum& b) const
+{
+    return compareDatum(TableSchema(table_),
+        table_.root(), a, b, true) == 0;
+}
+
+size_t GenericComparator::hash(const GenericDatum& d) const
+{
+    return hashDatum(TableSchema(table_),
+        table_.root(), d);
+}
+
+int compare(const GenericDatum& a, const GenericDatum& b)
+{
+    return compareDatum(DatumSchema(), 0, a, b, false);
+}
+
+bool equals(const GenericDatum& a, const GenericDatum& b)
+{
+    return compareDatum(DatumSchema(), 0, a, b, true) == 0;
+}
+
+size_t hash_traits<GenericDatum>::hash(const GenericDatum& d)
+{
+    return hashDatum(DatumSchema(), 0, d);
+}
+
+}   // namespace avro
@@ -0,0 +1,66 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Mutex_hh__
+#define avro_Mutex_hh__
+
+#include "boost/utility.hpp"
+
+#ifdef _WIN32
+#include "Windows.h"
+#else
+#include "pthread.h"
+#endif
+
+namespace avro {
+
+/**
+ * A plain mutex, for the few places in the library that share state
+ * between threads.
+ */
+class Mutex : boost::noncopyable {
+#ifdef _WIN32
+    CRITICAL_SECTION cs_;
+public:
+    Mutex() { ::InitializeCriticalSection(&cs_); }
+    ~Mutex() { ::DeleteCriticalSection(&cs_); }
+    void lock() { ::EnterCriticalSection(&cs_); }
+    void unlock() { ::LeaveCriticalSection(&cs_); }
+#else
+    pthread_mutex_t m_;
+public:
+    Mutex() { ::pthread_mutex_init(&m_, 0); }
+    ~Mutex() { ::pthread_mutex_destroy(&m_); }
+    void lock() { ::pthread_mutex_lock(&m_); }
+    void unlock() { ::pthread_mutex_unlock(&m_); }
+#endif
+};
+
+/**
+ * Holds a Mutex locked for its lifetime.
+ */
+class Lock : boost::noncopyable {
+    Mutex& m_;
+public:
+    Lock(Mutex& m) : m_(m) { m_.lock(); }
+    ~Lock() { m_.unlock(); }
+};
+
+}   // namespace avro
+
+#endif
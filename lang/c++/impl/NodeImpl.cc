@@ -199,6 +199,11 @@ NodeRecord::printJson(std::ostream &os, int depth) const
         }
         os << indent(depth) << "{\n";
         os << indent(++depth) << "\"name\": \"" << leafNameAttributes_.get(i) << "\",\n";
+        if (sortOrderAt(i) != AVRO_ASCENDING) {
+            os << indent(depth) << "\"order\": \""
+                << (sortOrderAt(i) == AVRO_DESCENDING ? "descending" : "ignore")
+                << "\",\n";
+        }
         os << indent(depth) << "\"type\": ";
         leafAttributes_.get(i)->printJson(os, depth);
         os << '\n';
@@ -0,0 +1,71 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef avro_Ordering_hh__
+#define avro_Ordering_hh__
+
+#include <string.h>
+#include <algorithm>
+
+#include "Config.hh"
+
+namespace avro {
+
+/// The Avro sort order of scalars and byte strings, shared by the
+/// comparators of generic data and of binary-encoded data so that the two
+/// agree.
+namespace ordering {
+
+template <typename T>
+int compareScalar(T a, T b)
+{
+    return a < b ? -1 : b < a ? 1 : 0;
+}
+
+/**
+ * Compares two numbers, taking -0 as 0 and NaN as equal to itself and
+ * greater than anything else.
+ */
+template <typename T>
+int compareReal(T a, T b)
+{
+    if (a < b) {
+        return -1;
+    } else if (b < a) {
+        return 1;
+    }
+    const bool nanA = a != a;
+    const bool nanB = b != b;
+    return nanA == nanB ? 0 : nanA ? 1 : -1;
+}
+
+/**
+ * Compares two byte strings as unsigned bytes, a prefix first.
+ */
+inline int compareBytes(const uint8_t* a, size_t na,
+    const uint8_t* b, size_t nb)
+{
+    const size_t n = std::min(na, nb);
+    const int c = n == 0 ? 0 : ::memcmp(a, b, n);
+    return c != 0 ? c : compareScalar(na, nb);
+}
+
+}   // namespace ordering
+}   // namespace avro
+
+#endif
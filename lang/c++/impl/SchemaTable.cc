@@ -0,0 +1,137 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <utility>
+
+#include "SchemaTable.hh"
+#include "NodeImpl.hh"
+
+namespace avro {
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+const size_t SchemaTable::npos;
+
+class SchemaTable::Builder {
+    SchemaTable& t_;
+    map<const Node*, size_t> defined_;
+    map<const Node*, size_t> references_;
+    map<string, size_t> interned_;
+    vector<pair<size_t, const Node*> > unresolved_;
+
+    size_t intern(const string& s);
+    size_t add(const NodePtr& n);
+
+public:
+    Builder(SchemaTable& t) : t_(t) { }
+    void build(const NodePtr& root);
+};
+
+size_t SchemaTable::Builder::intern(const string& s)
+{
+    map<string, size_t>::const_iterator it = interned_.find(s);
+    if (it != interned_.end()) {
+        return it->second;
+    }
+    const size_t result = t_.names_.size();
+    t_.names_.push_back(s);
+    interned_[s] = result;
+    return result;
+}
+
+size_t SchemaTable::Builder::add(const NodePtr& n)
+{
+    const size_t result = t_.entries_.size();
+    Entry e;
+    e.type = n->type();
+    e.fixedSize = (e.type == AVRO_FIXED) ? n->fixedSize() : 0;
+    e.name = n->hasName() ? intern(n->name().fullname()) : npos;
+    e.target = result;
+    e.firstLeaf = 0;
+    e.leafCount = 0;
+    e.firstLabel = t_.labels_.size();
+    e.labelCount = 0;
+
+    if (e.type == AVRO_SYMBOLIC) {
+        const Node* target = resolveSymbol(n).get();
+        map<const Node*, size_t>::const_iterator it =
+            references_.find(target);
+        if (it != references_.end()) {
+            return it->second;
+        }
+        references_[target] = result;
+        unresolved_.push_back(std::make_pair(result, target));
+        t_.entries_.push_back(e);
+        t_.nodes_.push_back(n);
+        return result;
+    }
+
+    if (e.name != npos) {
+        defined_[n.get()] = result;
+    }
+    t_.entries_.push_back(e);
+    t_.nodes_.push_back(n);
+
+    e.labelCount = n->names();
+    for (size_t i = 0; i < e.labelCount; ++i) {
+        t_.labels_.push_back(intern(n->nameAt(i)));
+    }
+
+    // The leaves' own entries come first, so collect their indices before
+    // laying them out.
+    const size_t c = n->leaves();
+    vector<size_t> leaves;
+    leaves.reserve(c);
+    for (size_t i = 0; i < c; ++i) {
+        leaves.push_back(add(n->leafAt(i)));
+    }
+    e.firstLeaf = t_.leaves_.size();
+    e.leafCount = c;
+    t_.leaves_.insert(t_.leaves_.end(), leaves.begin(), leaves.end());
+    for (size_t i = 0; i < c; ++i) {
+        t_.orders_.push_back(e.type == AVRO_RECORD ?
+            n->sortOrderAt(i) : AVRO_ASCENDING);
+    }
+    t_.entries_[result] = e;
+    return result;
+}
+
+void SchemaTable::Builder::build(const NodePtr& root)
+{
+    add(root);
+    for (vector<pair<size_t, const Node*> >::const_iterator it =
+        unresolved_.begin(); it != unresolved_.end(); ++it) {
+        map<const Node*, size_t>::const_iterator d = defined_.find(it->second);
+        if (d == defined_.end()) {
+            throw Exception(boost::format("Symbolic name %1% is not defined "
+                "in the schema") % t_.name(it->first));
+        }
+        t_.entries_[it->first].target = d->second;
+    }
+}
+
+SchemaTable::SchemaTable(const ValidSchema& schema)
+{
+    Builder(*this).build(schema.root());
+}
+
+} // namespace avro
@@ -17,6 +17,8 @@
  */
 
 #include "Stream.hh"
+#include "ChunkPool.hh"
+#include "buffer/Buffer.hh"
 #include <vector>
 
 namespace avro {
@@ -79,6 +81,10 @@ public:
     size_t byteCount() const {
         return cur_ * chunkSize_ + curLen_;
     }
+
+    bool stable() const {
+        return true;
+    }
 };
 
 class MemoryInputStream2 : public InputStream {
@@ -113,27 +119,32 @@ public:
     size_t byteCount() const {
         return curLen_;
     }
+
+    bool stable() const {
+        return true;
+    }
 };
 
 class MemoryOutputStream : public OutputStream {
 public:
+    const ChunkPoolPtr pool_;
     const size_t chunkSize_;
     std::vector<uint8_t*> data_;
     size_t available_;
     size_t byteCount_;
 
-    MemoryOutputStream(size_t chunkSize) : chunkSize_(chunkSize),
-        available_(0), byteCount_(0) { }
+    MemoryOutputStream(size_t chunkSize) : pool_(chunkPool()),
+        chunkSize_(chunkSize), available_(0), byteCount_(0) { }
     ~MemoryOutputStream() {
         for (std::vector<uint8_t*>::const_iterator it = data_.begin();
             it != data_.end(); ++it) {
-            delete[] *it;
+            pool_->release(*it, chunkSize_);
         }
     }
 
     bool next(uint8_t** data, size_t* len) {
         if (available_ == 0) {
-            data_.push_back(new uint8_t[chunkSize_]);
+            data_.push_back(pool_->allocate(chunkSize_));
             available_ = chunkSize_;
         }
         *data = &data_.back()[chunkSize_ - available_];
@@ -155,6 +166,104 @@ public:
     void flush() { }
 };
 
+class BufferOutputStream : public OutputStream {
+    OutputBuffer buffer_;
+    size_t pending_;
+    uint64_t byteCount_;
+
+    // The bytes handed out by the last call to next() are recorded as
+    // written into the buffer lazily, so that they can still be backed up.
+    void commit() {
+        if (pending_ != 0) {
+            buffer_.wroteTo(pending_);
+            pending_ = 0;
+        }
+    }
+
+public:
+    BufferOutputStream(const OutputBuffer& buffer) : buffer_(buffer),
+        pending_(0), byteCount_(0) { }
+    ~BufferOutputStream() {
+        commit();
+    }
+
+    bool next(uint8_t** data, size_t* len) {
+        commit();
+        if (buffer_.freeSpace() == 0) {
+            buffer_.reserve(detail::kDefaultBlockSize);
+        }
+        OutputBuffer::const_iterator it = buffer_.begin();
+        *data = reinterpret_cast<uint8_t*>(it->data());
+        *len = pending_ = it->size();
+        byteCount_ += pending_;
+        return true;
+    }
+
+    void backup(size_t len) {
+        pending_ -= len;
+        byteCount_ -= len;
+    }
+
+    uint64_t byteCount() const {
+        return byteCount_;
+    }
+
+    void flush() {
+        commit();
+    }
+};
+
+class BufferInputStream : public InputStream {
+    const InputBuffer buffer_;
+    InputBuffer::const_iterator iter_;
+    size_t chunkPos_;
+    size_t byteCount_;
+
+public:
+    BufferInputStream(const InputBuffer& buffer) : buffer_(buffer),
+        iter_(buffer_.begin()), chunkPos_(0), byteCount_(0) { }
+
+    bool next(const uint8_t** data, size_t* len) {
+        for (; iter_ != buffer_.end(); ++iter_, chunkPos_ = 0) {
+            if (size_t n = iter_->size() - chunkPos_) {
+                *data = reinterpret_cast<const uint8_t*>(iter_->data()) +
+                    chunkPos_;
+                *len = n;
+                chunkPos_ += n;
+                byteCount_ += n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void backup(size_t len) {
+        chunkPos_ -= len;
+        byteCount_ -= len;
+    }
+
+    void skip(size_t len) {
+        while (len > 0 && iter_ != buffer_.end()) {
+            size_t n = std::min(iter_->size() - chunkPos_, len);
+            chunkPos_ += n;
+            byteCount_ += n;
+            len -= n;
+            if (chunkPos_ == iter_->size()) {
+                ++iter_;
+                chunkPos_ = 0;
+            }
+        }
+    }
+
+    size_t byteCount() const {
+        return byteCount_;
+    }
+
+    bool stable() const {
+        return true;
+    }
+};
+
 std::auto_ptr<OutputStream> memoryOutputStream(size_t chunkSize)
 {
     return std::auto_ptr<OutputStream>(new MemoryOutputStream(chunkSize));
@@ -176,5 +285,15 @@ std::auto_ptr<InputStream> memoryInputStream(const OutputStream& source)
             (mos.chunkSize_ - mos.available_)));
 }
 
+std::auto_ptr<OutputStream> bufferOutputStream(OutputBuffer& buffer)
+{
+    return std::auto_ptr<OutputStream>(new BufferOutputStream(buffer));
+}
+
+std::auto_ptr<InputStream> bufferInputStream(const InputBuffer& buffer)
+{
+    return std::auto_ptr<InputStream>(new BufferInputStream(buffer));
+}
+
 }   // namespace avro
 
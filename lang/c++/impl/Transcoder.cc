@@ -0,0 +1,580 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define __STDC_LIMIT_MACROS
+
+#include "Transcoder.hh"
+#include "Encoder.hh"
+#include "Decoder.hh"
+#include "NodeImpl.hh"
+#include "json/JsonIO.hh"
+#include "parsing/Symbol.hh"
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+namespace avro {
+
+using std::map;
+using std::string;
+using std::vector;
+using boost::make_shared;
+using boost::shared_ptr;
+
+namespace {
+
+/**
+ * An output stream over a vector that can be emptied and reused, so that
+ * the memory for a block is allocated only once.
+ */
+class VectorOutputStream : public OutputStream {
+    vector<uint8_t> data_;
+    size_t size_;
+
+public:
+    VectorOutputStream() : size_(0) { }
+
+    bool next(uint8_t** data, size_t* len) {
+        if (size_ == data_.size()) {
+            data_.resize(std::max(data_.size() * 2, size_t(1024)));
+        }
+        *data = &data_[size_];
+        *len = data_.size() - size_;
+        size_ = data_.size();
+        return true;
+    }
+
+    void backup(size_t len) {
+        size_ -= len;
+    }
+
+    uint64_t byteCount() const {
+        return size_;
+    }
+
+    void flush() { }
+
+    const uint8_t* data() const {
+        return data_.empty() ? 0 : &data_[0];
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+};
+
+/**
+ * The items of a binary array or map that have been read, but not written
+ * yet because their count is not known.
+ */
+struct Block {
+    VectorOutputStream out;
+    EncoderPtr encoder;
+    size_t count;
+
+    Block() : encoder(binaryEncoder()), count(0) {
+        encoder->init(out);
+    }
+
+    /**
+     * Drops the items gathered so far, along with any item that was being
+     * written when a value failed.
+     */
+    void clear() {
+        encoder->init(out);
+        out.clear();
+        count = 0;
+    }
+};
+
+/**
+ * One node of the schema. Symbolic nodes are resolved when the schema is
+ * compiled, so children are indices of other instructions, which can be
+ * those of an enclosing record for recursive schemas. Names are those of
+ * the fields of a record, the symbols of an enum or the branches of a
+ * union, as they appear in JSON. Enums and unions also have them in a
+ * list that can be searched quickly.
+ */
+struct Instruction {
+    Type type;
+    size_t size;
+    vector<size_t> children;
+    vector<string> names;
+    parsing::NameListPtr lookup;
+};
+
+const size_t maxBlockSize = 64 * 1024;
+
+const size_t noBranch = static_cast<size_t>(-1);
+
+string nameOf(const NodePtr& n)
+{
+    if (n->hasName()) {
+        return n->name();
+    }
+    std::ostringstream oss;
+    oss << n->type();
+    return oss.str();
+}
+
+size_t indexOf(const Instruction& in, const string& name)
+{
+    size_t result = in.lookup->indexOf(name);
+    if (result == in.lookup->size()) {
+        throw Exception(boost::format("No such name: %1%") % name);
+    }
+    return result;
+}
+
+/**
+ * The schema compiled into instructions, of which the first is for the
+ * root.
+ */
+class Program {
+    vector<Instruction> instructions_;
+
+    size_t compile(const NodePtr& n, map<const Node*, size_t>& done);
+public:
+    explicit Program(const ValidSchema& schema) {
+        map<const Node*, size_t> done;
+        compile(schema.root(), done);
+    }
+
+    const Instruction& operator[](size_t pc) const {
+        return instructions_[pc];
+    }
+};
+
+size_t Program::compile(const NodePtr& n, map<const Node*, size_t>& done)
+{
+    if (n->type() == AVRO_SYMBOLIC) {
+        return compile(resolveSymbol(n), done);
+    }
+    map<const Node*, size_t>::const_iterator it = done.find(n.get());
+    if (it != done.end()) {
+        return it->second;
+    }
+
+    const size_t pc = instructions_.size();
+    done[n.get()] = pc;
+    instructions_.push_back(Instruction());
+
+    Instruction in;
+    in.type = n->type();
+    in.size = 0;
+    switch (n->type()) {
+    case AVRO_FIXED:
+        in.size = n->fixedSize();
+        break;
+    case AVRO_ENUM:
+        for (size_t i = 0; i < n->names(); ++i) {
+            in.names.push_back(n->nameAt(i));
+        }
+        break;
+    case AVRO_RECORD:
+        for (size_t i = 0; i < n->leaves(); ++i) {
+            in.children.push_back(compile(n->leafAt(i), done));
+            in.names.push_back(n->nameAt(i));
+        }
+        break;
+    case AVRO_UNION:
+        // The size of a union is the index of its null branch.
+        in.size = noBranch;
+        for (size_t i = 0; i < n->leaves(); ++i) {
+            const NodePtr& leaf = n->leafAt(i);
+            in.children.push_back(compile(leaf, done));
+            in.names.push_back(nameOf(leaf));
+            if (leaf->type() == AVRO_NULL) {
+                in.size = i;
+            }
+        }
+        break;
+    case AVRO_ARRAY:
+        in.children.push_back(compile(n->leafAt(0), done));
+        break;
+    case AVRO_MAP:
+        in.children.push_back(compile(n->leafAt(1), done));
+        break;
+    default:
+        break;
+    }
+    if (in.type == AVRO_ENUM || in.type == AVRO_UNION) {
+        in.lookup = boost::make_shared<parsing::NameList>(in.names);
+    }
+    // Compiling the children may have moved the instruction.
+    instructions_[pc] = in;
+    return pc;
+}
+
+/**
+ * Reads JSON with a JsonParser and writes binary. Arrays and maps are
+ * written a block at a time, so their items are gathered in the block
+ * for their depth until it is full or they run out.
+ */
+class JsonToBinary : public Transcoder {
+    const Program program_;
+    json::JsonParser in_;
+    const EncoderPtr encoder_;
+    vector<shared_ptr<Block> > blocks_;
+
+    void init(InputStream& is, OutputStream& os) {
+        in_.init(is);
+        encoder_->init(os);
+        for (vector<shared_ptr<Block> >::iterator it = blocks_.begin();
+            it != blocks_.end(); ++it) {
+            (*it)->clear();
+        }
+    }
+
+    void transcode() {
+        transcode(0, *encoder_, 0);
+    }
+
+    void flush() {
+        encoder_->flush();
+    }
+
+    void expect(json::JsonParser::Token tk);
+    double expectDecimal();
+    void transcode(size_t pc, Encoder& e, size_t depth);
+    void transcodeItems(size_t pc, Encoder& e, size_t depth, bool isArray);
+    void writeBlock(Encoder& e, Block& b);
+
+public:
+    explicit JsonToBinary(const ValidSchema& schema) :
+        program_(schema), encoder_(binaryEncoder()) { }
+};
+
+void JsonToBinary::expect(json::JsonParser::Token tk)
+{
+    if (in_.advance() != tk) {
+        std::ostringstream oss;
+        oss << "Incorrect token in the stream. Expected: "
+            << json::JsonParser::toString(tk) << ", found "
+            << json::JsonParser::toString(in_.cur());
+        throw Exception(oss.str());
+    }
+}
+
+double JsonToBinary::expectDecimal()
+{
+    switch (in_.advance()) {
+    case json::JsonParser::tkDouble:
+        return in_.doubleValue();
+    case json::JsonParser::tkLong:
+        return static_cast<double>(in_.longValue());
+    default:
+        throw Exception(boost::format(
+            "Incorrect token in the stream. Expected a number, found %1%") %
+            json::JsonParser::toString(in_.cur()));
+    }
+}
+
+void JsonToBinary::transcode(size_t pc, Encoder& e, size_t depth)
+{
+    const Instruction& in = program_[pc];
+    switch (in.type) {
+    case AVRO_NULL:
+        expect(json::JsonParser::tkNull);
+        e.encodeNull();
+        break;
+    case AVRO_BOOL:
+        expect(json::JsonParser::tkBool);
+        e.encodeBool(in_.boolValue());
+        break;
+    case AVRO_INT:
+        {
+            expect(json::JsonParser::tkLong);
+            int64_t n = in_.longValue();
+            if (n < INT32_MIN || n > INT32_MAX) {
+                throw Exception(boost::format(
+                    "Value out of range for Avro int: %1%") % n);
+            }
+            e.encodeInt(static_cast<int32_t>(n));
+        }
+        break;
+    case AVRO_LONG:
+        expect(json::JsonParser::tkLong);
+        e.encodeLong(in_.longValue());
+        break;
+    case AVRO_FLOAT:
+        e.encodeFloat(static_cast<float>(expectDecimal()));
+        break;
+    case AVRO_DOUBLE:
+        e.encodeDouble(expectDecimal());
+        break;
+    case AVRO_STRING:
+        expect(json::JsonParser::tkString);
+        e.encodeString(in_.stringValue());
+        break;
+    case AVRO_BYTES:
+    case AVRO_FIXED:
+        {
+            expect(json::JsonParser::tkString);
+            const string& s = in_.stringValue();
+            const uint8_t* b = reinterpret_cast<const uint8_t*>(s.data());
+            if (in.type == AVRO_BYTES) {
+                e.encodeBytes(b, s.size());
+            } else if (s.size() != in.size) {
+                throw Exception("Incorrect value for fixed");
+            } else {
+                e.encodeFixed(b, s.size());
+            }
+        }
+        break;
+    case AVRO_ENUM:
+        expect(json::JsonParser::tkString);
+        e.encodeEnum(indexOf(in, in_.stringValue()));
+        break;
+    case AVRO_RECORD:
+        expect(json::JsonParser::tkObjectStart);
+        for (size_t i = 0; i < in.children.size(); ++i) {
+            expect(json::JsonParser::tkString);
+            if (in_.stringValue() != in.names[i]) {
+                throw Exception("Incorrect field");
+            }
+            transcode(in.children[i], e, depth);
+        }
+        expect(json::JsonParser::tkObjectEnd);
+        break;
+    case AVRO_UNION:
+        if (in_.peek() == json::JsonParser::tkNull) {
+            if (in.size == noBranch) {
+                throw Exception("No such name: null");
+            }
+            e.encodeUnionIndex(in.size);
+            transcode(in.children[in.size], e, depth);
+        } else {
+            expect(json::JsonParser::tkObjectStart);
+            expect(json::JsonParser::tkString);
+            size_t n = indexOf(in, in_.stringValue());
+            e.encodeUnionIndex(n);
+            transcode(in.children[n], e, depth);
+            expect(json::JsonParser::tkObjectEnd);
+        }
+        break;
+    case AVRO_ARRAY:
+        expect(json::JsonParser::tkArrayStart);
+        e.arrayStart();
+        transcodeItems(in.children[0], e, depth, true);
+        e.arrayEnd();
+        break;
+    case AVRO_MAP:
+        expect(json::JsonParser::tkObjectStart);
+        e.mapStart();
+        transcodeItems(in.children[0], e, depth, false);
+        e.mapEnd();
+        break;
+    default:
+        throw Exception(boost::format("Unknown schema type %1%") %
+            toString(in.type));
+    }
+}
+
+void JsonToBinary::transcodeItems(size_t pc, Encoder& e, size_t depth,
+    bool isArray)
+{
+    const json::JsonParser::Token end = isArray ?
+        json::JsonParser::tkArrayEnd : json::JsonParser::tkObjectEnd;
+    while (blocks_.size() <= depth) {
+        blocks_.push_back(make_shared<Block>());
+    }
+    Block& b = *blocks_[depth];
+    while (in_.peek() != end) {
+        if (! isArray) {
+            expect(json::JsonParser::tkString);
+            b.encoder->encodeString(in_.stringValue());
+        }
+        transcode(pc, *b.encoder, depth + 1);
+        ++b.count;
+        b.encoder->flush();
+        if (b.out.byteCount() >= maxBlockSize) {
+            writeBlock(e, b);
+        }
+    }
+    in_.advance();
+    writeBlock(e, b);
+}
+
+/**
+ * Writes the items gathered in b as one block onto e, which is a binary
+ * encoder, and empties b.
+ */
+void JsonToBinary::writeBlock(Encoder& e, Block& b)
+{
+    if (b.count != 0) {
+        e.setItemCount(b.count);
+        e.encodeFixed(b.out.data(), b.out.byteCount());
+        b.out.clear();
+        b.count = 0;
+    }
+}
+
+/**
+ * Reads binary with a binary decoder and writes JSON with a JsonGenerator.
+ */
+class BinaryToJson : public Transcoder {
+    const Program program_;
+    const DecoderPtr decoder_;
+    json::JsonGenerator out_;
+    string string_;
+    vector<uint8_t> bytes_;
+
+    void init(InputStream& is, OutputStream& os) {
+        decoder_->init(is);
+        out_.init(os);
+    }
+
+    void transcode() {
+        transcode(0);
+    }
+
+    void flush() {
+        out_.flush();
+    }
+
+    void transcode(size_t pc);
+    void encodeBinary();
+
+public:
+    explicit BinaryToJson(const ValidSchema& schema) :
+        program_(schema), decoder_(binaryDecoder()) { }
+};
+
+void BinaryToJson::encodeBinary()
+{
+    uint8_t b = 0;
+    out_.encodeBinary(bytes_.empty() ? &b : &bytes_[0], bytes_.size());
+}
+
+void BinaryToJson::transcode(size_t pc)
+{
+    const Instruction& in = program_[pc];
+    Decoder& d = *decoder_;
+    switch (in.type) {
+    case AVRO_NULL:
+        d.decodeNull();
+        out_.encodeNull();
+        break;
+    case AVRO_BOOL:
+        out_.encodeBool(d.decodeBool());
+        break;
+    case AVRO_INT:
+        out_.encodeNumber(d.decodeInt());
+        break;
+    case AVRO_LONG:
+        out_.encodeNumber(d.decodeLong());
+        break;
+    case AVRO_FLOAT:
+        out_.encodeNumber(d.decodeFloat());
+        break;
+    case AVRO_DOUBLE:
+        out_.encodeNumber(d.decodeDouble());
+        break;
+    case AVRO_STRING:
+        d.decodeString(string_);
+        out_.encodeString(string_);
+        break;
+    case AVRO_BYTES:
+        d.decodeBytes(bytes_);
+        encodeBinary();
+        break;
+    case AVRO_FIXED:
+        d.decodeFixed(in.size, bytes_);
+        encodeBinary();
+        break;
+    case AVRO_ENUM:
+        {
+            size_t n = d.decodeEnum();
+            if (n >= in.names.size()) {
+                throw Exception(boost::format(
+                    "Enum index %1% out of range") % n);
+            }
+            out_.encodeString(in.names[n]);
+        }
+        break;
+    case AVRO_RECORD:
+        out_.objectStart();
+        for (size_t i = 0; i < in.children.size(); ++i) {
+            out_.encodeString(in.names[i]);
+            transcode(in.children[i]);
+        }
+        out_.objectEnd();
+        break;
+    case AVRO_UNION:
+        {
+            size_t n = d.decodeUnionIndex();
+            if (n >= in.children.size()) {
+                throw Exception(boost::format(
+                    "Union index %1% out of range") % n);
+            }
+            if (n == in.size) {
+                transcode(in.children[n]);
+            } else {
+                out_.objectStart();
+                out_.encodeString(in.names[n]);
+                transcode(in.children[n]);
+                out_.objectEnd();
+            }
+        }
+        break;
+    case AVRO_ARRAY:
+        out_.arrayStart();
+        for (size_t n = d.arrayStart(); n != 0; n = d.arrayNext()) {
+            for (size_t i = 0; i < n; ++i) {
+                transcode(in.children[0]);
+            }
+        }
+        out_.arrayEnd();
+        break;
+    case AVRO_MAP:
+        out_.objectStart();
+        for (size_t n = d.mapStart(); n != 0; n = d.mapNext()) {
+            for (size_t i = 0; i < n; ++i) {
+                d.decodeString(string_);
+                out_.encodeString(string_);
+                transcode(in.children[0]);
+            }
+        }
+        out_.objectEnd();
+        break;
+    default:
+        throw Exception(boost::format("Unknown schema type %1%") %
+            toString(in.type));
+    }
+}
+
+}   // namespace
+
+TranscoderPtr jsonToBinaryTranscoder(const ValidSchema& schema)
+{
+    return make_shared<JsonToBinary>(schema);
+}
+
+TranscoderPtr binaryToJsonTranscoder(const ValidSchema& schema)
+{
+    return make_shared<BinaryToJson>(schema);
+}
+
+}   // namespace avro
@@ -18,6 +18,7 @@
 
 #include <boost/format.hpp>
 #include <sstream>
+#include <set>
 
 #include "ValidSchema.hh"
 #include "Schema.hh"
@@ -120,6 +121,120 @@ ValidSchema::toJson(std::ostream &os) const
     os << '\n';
 }
 
+static void printCanonical(std::ostream &os, const NodePtr &node,
+    std::set<Name> &seen)
+{
+    if (node->hasName()) {
+        const Name &nm = node->name();
+        if (node->type() == AVRO_SYMBOLIC || ! seen.insert(nm).second) {
+            os << "\"" << nm.fullname() << '"';
+            return;
+        }
+    }
+
+    switch (node->type()) {
+    case AVRO_RECORD:
+        os << "{\"name\":\"" << node->name().fullname()
+            << "\",\"type\":\"record\",\"fields\":[";
+        for (size_t i = 0; i < node->leaves(); ++i) {
+            if (i > 0) {
+                os << ',';
+            }
+            os << "{\"name\":\"" << node->nameAt(i) << "\",\"type\":";
+            printCanonical(os, node->leafAt(i), seen);
+            os << '}';
+        }
+        os << "]}";
+        break;
+    case AVRO_ENUM:
+        os << "{\"name\":\"" << node->name().fullname()
+            << "\",\"type\":\"enum\",\"symbols\":[";
+        for (size_t i = 0; i < node->names(); ++i) {
+            if (i > 0) {
+                os << ',';
+            }
+            os << '"' << node->nameAt(i) << '"';
+        }
+        os << "]}";
+        break;
+    case AVRO_FIXED:
+        os << "{\"name\":\"" << node->name().fullname()
+            << "\",\"type\":\"fixed\",\"size\":" << node->fixedSize() << '}';
+        break;
+    case AVRO_ARRAY:
+        os << "{\"type\":\"array\",\"items\":";
+        printCanonical(os, node->leafAt(0), seen);
+        os << '}';
+        break;
+    case AVRO_MAP:
+        os << "{\"type\":\"map\",\"values\":";
+        printCanonical(os, node->leafAt(1), seen);
+        os << '}';
+        break;
+    case AVRO_UNION:
+        os << '[';
+        for (size_t i = 0; i < node->leaves(); ++i) {
+            if (i > 0) {
+                os << ',';
+            }
+            printCanonical(os, node->leafAt(i), seen);
+        }
+        os << ']';
+        break;
+    default:
+        os << '"' << node->type() << '"';
+        break;
+    }
+}
+
+void
+ValidSchema::toCanonicalJson(std::ostream &os) const
+{
+    std::set<Name> seen;
+    printCanonical(os, root_, seen);
+}
+
+uint64_t
+ValidSchema::fingerprint() const
+{
+    std::ostringstream oss;
+    toCanonicalJson(oss);
+    const string s = oss.str();
+    return fingerprint64(reinterpret_cast<const uint8_t*>(s.data()),
+        s.size());
+}
+
+static const uint64_t fingerprintEmpty = 0xc15d213aa4d7a795ULL;
+
+namespace {
+
+struct FingerprintTable {
+    uint64_t entries[256];
+
+    FingerprintTable() {
+        for (int i = 0; i < 256; ++i) {
+            uint64_t fp = i;
+            for (int j = 0; j < 8; ++j) {
+                fp = (fp >> 1) ^ (fingerprintEmpty & -(fp & 1));
+            }
+            entries[i] = fp;
+        }
+    }
+};
+
+}   // namespace
+
+uint64_t fingerprint64(const uint8_t *data, size_t len)
+{
+    static const FingerprintTable t;
+    const uint64_t *table = t.entries;
+    uint64_t fp = fingerprintEmpty;
+    for (size_t i = 0; i < len; ++i) {
+        fp = (fp >> 8) ^ table[(fp ^ data[i]) & 0xff];
+    }
+    return fp;
+}
+
 void 
 ValidSchema::toFlatList(std::ostream &os) const
 { 
@@ -0,0 +1,74 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "View.hh"
+
+namespace avro {
+
+Arena::Arena(size_t blockSize) : blockSize_(blockSize), current_(0),
+    next_(0), end_(0)
+{
+}
+
+Arena::~Arena()
+{
+    clear();
+    for (std::vector<uint8_t*>::iterator it = blocks_.begin();
+        it != blocks_.end(); ++it) {
+        delete[] *it;
+    }
+}
+
+uint8_t* Arena::allocateSlow(size_t n)
+{
+    // Requests too big for a standard block get a block of their own, so
+    // that standard blocks stay interchangeable.
+    if (n > blockSize_ / 4) {
+        uint8_t* result = new uint8_t[n];
+        large_.push_back(result);
+        return result;
+    }
+
+    if (! blocks_.empty() && current_ + 1 < blocks_.size()) {
+        ++current_;
+    } else {
+        blocks_.push_back(new uint8_t[blockSize_]);
+        current_ = blocks_.size() - 1;
+    }
+    next_ = blocks_[current_] + n;
+    end_ = blocks_[current_] + blockSize_;
+    return blocks_[current_];
+}
+
+void Arena::clear()
+{
+    for (std::vector<uint8_t*>::iterator it = large_.begin();
+        it != large_.end(); ++it) {
+        delete[] *it;
+    }
+    large_.clear();
+    if (blocks_.empty()) {
+        next_ = end_ = 0;
+    } else {
+        current_ = 0;
+        next_ = blocks_[0];
+        end_ = blocks_[0] + blockSize_;
+    }
+}
+
+}   // namespace avro
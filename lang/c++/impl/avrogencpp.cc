@@ -22,8 +22,10 @@
 #endif
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <map>
 #include <set>
+#include <algorithm>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -36,6 +38,7 @@
 #include "Compiler.hh"
 #include "ValidSchema.hh"
 #include "NodeImpl.hh"
+#include "Exception.hh"
 
 using std::ostream;
 using std::ifstream;
@@ -50,25 +53,29 @@ using avro::resolveSymbol;
 using boost::lexical_cast;
 
 using avro::ValidSchema;
-using avro::compileJsonSchema;
 
-struct PendingSetterGetter {
-    string structName;
+/**
+ * A branch of a generated union. Branches whose type may still be
+ * incomplete where the union is defined are "boxed": the union stores a
+ * pointer to a heap allocated value instead of the value itself.
+ */
+struct UnionBranch {
     string type;
     string name;
-    size_t idx;
+    bool isNull;
+    bool boxed;
+    bool recursive;
 
-    PendingSetterGetter(const string& sn, const string& t,
-        const string& n, size_t i) :
-        structName(sn), type(t), name(n), idx(i) { }
+    UnionBranch(const string& t, const string& n, bool in, bool b, bool r) :
+        type(t), name(n), isNull(in), boxed(b), recursive(r) { }
 };
 
-struct PendingConstructor {
+struct PendingUnion {
     string structName;
-    string memberName;
-    bool initMember;
-    PendingConstructor(const string& sn, const string& n, bool im) :
-        structName(sn), memberName(n), initMember(im) { }
+    vector<UnionBranch> branches;
+
+    PendingUnion(const string& sn, const vector<UnionBranch>& b) :
+        structName(sn), branches(b) { }
 };
 
 class CodeGen {
@@ -80,11 +87,15 @@ class CodeGen {
     const std::string headerFile_;
     const std::string includePrefix_;
     const bool noUnion_;
+    const bool binaryCodec_;
+    const bool compare_;
+    const bool views_;
+    const vector<string> decodeOnly_;
     const std::string guardString_;
     boost::mt19937 random_;
 
-    vector<PendingSetterGetter> pendingGettersAndSetters;
-    vector<PendingConstructor> pendingConstructors;
+    vector<PendingUnion> pendingUnions;
+    vector<string> comparable_;
 
     map<NodePtr, string> done;
     set<NodePtr> doing;
@@ -101,20 +112,46 @@ class CodeGen {
     std::string doGenerateType(const NodePtr& n);
     void generateEnumTraits(const NodePtr& n);
     void generateTraits(const NodePtr& n);
+    void generateEnumBinaryTraits(const NodePtr& n);
+    void generateRecordBinaryTraits(const NodePtr& n);
+    void generateUnionBinaryTraits(const NodePtr& n);
+    void generateBinaryTraits(const NodePtr& n);
+    void generateHoldsViews(const NodePtr& n, const string& fn);
     void generateRecordTraits(const NodePtr& n);
     void generateUnionTraits(const NodePtr& n);
+    void generateSchemaTraits(const ValidSchema& schema, const string& json);
+    void generateRecordComparison(const NodePtr& n, ostream& decls,
+        ostream& defs);
+    void generateUnionComparison(const NodePtr& n, ostream& decls,
+        ostream& defs);
+    void generateComparison(const NodePtr& n, ostream& decls, ostream& defs);
+    void generateComparisons(const NodePtr& root);
+    void generateEnumHashTraits(const NodePtr& n);
+    void generateRecordHashTraits(const NodePtr& n);
+    void generateUnionHashTraits(const NodePtr& n);
+    void generateHashTraits(const NodePtr& n);
+    void generateHashValues();
+    void generateSkip(ostream& os, const NodePtr& n, size_t depth,
+        vector<NodePtr>& records);
+    void generateDecodeOnlyFields(ostream& os, const NodePtr& n,
+        const string& prefix, const set<string>& paths,
+        vector<NodePtr>& records);
+    void generateDecodeOnly(const NodePtr& root);
     void emitCopyright();
 public:
     CodeGen(std::ostream& os, const std::string& ns,
         const std::string& schemaFile, const std::string& headerFile,
         const std::string& guardString,
-        const std::string& includePrefix, bool noUnion) :
+        const std::string& includePrefix, bool noUnion, bool binaryCodec,
+        bool compare, bool views, const vector<string>& decodeOnly) :
         unionNumber_(0), os_(os), inNamespace_(false), ns_(ns),
         schemaFile_(schemaFile), headerFile_(headerFile),
         includePrefix_(includePrefix), noUnion_(noUnion),
+        binaryCodec_(binaryCodec), compare_(compare), views_(views),
+        decodeOnly_(decodeOnly),
         guardString_(guardString),
         random_(static_cast<uint32_t>(::time(0))) { }
-    void generate(const ValidSchema& schema);
+    void generate(const ValidSchema& schema, const string& json);
 };
 
 static string decorate(const avro::Name& name)
@@ -143,9 +180,9 @@ string CodeGen::cppTypeOf(const NodePtr& n)
 {
     switch (n->type()) {
     case avro::AVRO_STRING:
-        return "std::string";
+        return views_ ? "avro::StringView" : "std::string";
     case avro::AVRO_BYTES:
-        return "std::vector<uint8_t>";
+        return views_ ? "avro::BytesView" : "std::vector<uint8_t>";
     case avro::AVRO_INT:
         return "int32_t";
     case avro::AVRO_LONG:
@@ -269,51 +306,258 @@ string CodeGen::unionName()
     return s + "_Union__" + boost::lexical_cast<string>(unionNumber_++) + "__";
 }
 
-static void generateGetterAndSetter(ostream& os,
-    const string& structName, const string& type, const string& name,
-    size_t idx)
+/**
+ * Returns an expression for the maximum of the given expressions,
+ * usable as a template argument.
+ */
+static string staticMax(const vector<string>& v, size_t i = 0)
+{
+    if (i + 1 == v.size()) {
+        return v[i];
+    }
+    return "boost::static_unsigned_max<" + v[i] + ", " +
+        staticMax(v, i + 1) + ">::value";
+}
+
+/**
+ * Returns an expression for the storage slot of a union branch, of type
+ * T& for inline branches and T*& for boxed ones.
+ */
+static string slotOf(const UnionBranch& b, const string& value = "value_",
+    bool isConst = false)
 {
-    string sn = " " + structName + "::";
+    string c = isConst ? "const " : "";
+    string p = b.boxed ? b.type + "*" : b.type;
+    return "*static_cast<" + c + p + (isConst && b.boxed ? " const" : "") +
+        "*>(" + value + ".address())";
+}
 
-    os << "inline\n";
+static void generateUnionMembers(ostream& os, const PendingUnion& u)
+{
+    const string& st = u.structName;
+    const string sn = " " + st + "::";
+    const vector<UnionBranch>& bs = u.branches;
 
-    os << type << sn << "get_" << name << "() const {\n"
-        << "    if (idx_ != " << idx << ") {\n"
-        << "        throw avro::Exception(\"Invalid type for "
-            << "union\");\n"
-        << "    }\n"
-        << "    return boost::any_cast<" << type << " >(value_);\n"
+    os << "inline\n"
+        << "void" << sn << "destroy_() {\n"
+        << "    switch (idx_) {\n";
+    for (size_t i = 0; i < bs.size(); ++i) {
+        const UnionBranch& b = bs[i];
+        if (b.isNull) {
+            continue;
+        }
+        os << "    case " << i << ":\n";
+        if (b.boxed) {
+            os << "        delete " << slotOf(b) << ";\n";
+        } else {
+            os << "        {\n"
+                << "            typedef " << b.type << " T;\n"
+                << "            static_cast<T*>(value_.address())->~T();\n"
+                << "        }\n";
+        }
+        os << "        break;\n";
+    }
+    os << "    }\n"
+        << "    idx_ = size_t(-1);\n"
         << "}\n\n";
 
     os << "inline\n"
-        << "void" << sn << "set_" << name
-        << "(const " << type << "& v) {\n"
-        << "    idx_ = " << idx << ";\n"
-        << "    value_ = v;\n"
+        << "void" << sn << "copy_(const " << st << "& other) {\n"
+        << "    switch (other.idx_) {\n";
+    for (size_t i = 0; i < bs.size(); ++i) {
+        const UnionBranch& b = bs[i];
+        if (b.isNull) {
+            continue;
+        }
+        os << "    case " << i << ":\n";
+        if (b.boxed) {
+            os << "        {\n"
+                << "            const " << b.type << "* p = "
+                << slotOf(b, "other.value_", true) << ";\n"
+                << "            " << slotOf(b) << " = p == 0 ? 0 : new "
+                << b.type << "(*p);\n"
+                << "        }\n";
+        } else {
+            os << "        new (value_.address()) " << b.type << "("
+                << slotOf(b, "other.value_", true) << ");\n";
+        }
+        os << "        break;\n";
+    }
+    os << "    }\n"
+        << "    idx_ = other.idx_;\n"
         << "}\n\n";
-}
 
-static void generateConstructor(ostream& os,
-    const string& structName, bool initMember,
-    const string& type) {
-    os << "inline " << structName  << "::" << structName << "() : idx_(0)";
-    if (initMember) {
-        os << ", value_(" << type << "())";
+    for (size_t i = 0; i < bs.size(); ++i) {
+        const UnionBranch& b = bs[i];
+        if (b.isNull) {
+            continue;
+        }
+        const string& type = b.type;
+        const string& name = b.name;
+
+        os << "inline\n"
+            << "const " << type << "&" << sn << "get_" << name
+            << "() const {\n";
+        os << "    if (idx_ != " << i << ") {\n"
+            << "        throw avro::Exception(\"Invalid type for "
+                << "union\");\n"
+            << "    }\n";
+        if (b.boxed) {
+            // A boxed branch is allocated on first use, which a const
+            // union cannot do; until then it reads as a shared default.
+            os << "    const " << type << "* p = "
+                << slotOf(b, "value_", true) << ";\n"
+                << "    if (p == 0) {\n"
+                << "        static const " << type << " empty = "
+                << type << "();\n"
+                << "        return empty;\n"
+                << "    }\n"
+                << "    return *p;\n";
+        } else {
+            os << "    return " << slotOf(b, "value_", true) << ";\n";
+        }
+        os << "}\n\n";
+
+        os << "inline\n"
+            << type << "&" << sn << "get_" << name << "() {\n"
+            << "    if (idx_ != " << i << ") {\n"
+            << "        throw avro::Exception(\"Invalid type for "
+                << "union\");\n"
+            << "    }\n";
+        if (b.boxed) {
+            os << "    " << type << "*& p = " << slotOf(b) << ";\n"
+                << "    if (p == 0) {\n"
+                << "        p = new " << type << "();\n"
+                << "    }\n"
+                << "    return *p;\n";
+        } else {
+            os << "    return " << slotOf(b) << ";\n";
+        }
+        os << "}\n\n";
+
+        os << "inline\n"
+            << "void" << sn << "set_" << name
+            << "(const " << type << "& v) {\n"
+            << "    if (idx_ == " << i << ") {\n"
+            << "        get_" << name << "() = v;\n"
+            << "    } else {\n";
+        if (b.boxed) {
+            os << "        " << type << "* p = new " << type << "(v);\n"
+                << "        destroy_();\n"
+                << "        " << slotOf(b) << " = p;\n";
+        } else {
+            os << "        destroy_();\n"
+                << "        new (value_.address()) " << type << "(v);\n";
+        }
+        os << "        idx_ = " << i << ";\n"
+            << "    }\n"
+            << "}\n\n";
+
+        os << "inline\n"
+            << type << "&" << sn << "emplace_" << name << "() {\n";
+        if (b.boxed) {
+            os << "    " << type << "* p = new " << type << "();\n"
+                << "    destroy_();\n"
+                << "    " << slotOf(b) << " = p;\n"
+                << "    idx_ = " << i << ";\n"
+                << "    return *p;\n";
+        } else {
+            os << "    destroy_();\n"
+                << "    new (value_.address()) " << type << "();\n"
+                << "    idx_ = " << i << ";\n"
+                << "    return " << slotOf(b) << ";\n";
+        }
+        os << "}\n\n";
+    }
+
+    // A record boxed in its own union contains the union again, so a
+    // default value that chose it would never end; start from the first
+    // branch that does not.
+    size_t d = 0;
+    while (d < bs.size() && bs[d].recursive) {
+        ++d;
+    }
+    if (d == bs.size()) {
+        d = 0;
+    }
+    const UnionBranch& b0 = bs[d];
+    os << "inline" << sn << st << "() : idx_(" << d << ") {\n";
+    if (b0.boxed) {
+        os << "    " << slotOf(b0) << " = 0;\n";
+    } else if (! b0.isNull) {
+        os << "    new (value_.address()) " << b0.type << "();\n";
+    }
+    os << "}\n\n";
+
+    // Should copying the value throw, the destructor finds no value.
+    os << "inline" << sn << st << "(const " << st
+        << "& other) : idx_(size_t(-1)) {\n"
+        << "    copy_(other);\n"
+        << "}\n\n";
+
+    os << "inline\n"
+        << st << "&" << sn << "operator=(const " << st << "& other) {\n"
+        << "    if (this != &other) {\n"
+        << "        if (idx_ == other.idx_) {\n"
+        << "            switch (idx_) {\n";
+    for (size_t i = 0; i < bs.size(); ++i) {
+        const UnionBranch& b = bs[i];
+        if (b.isNull) {
+            continue;
+        }
+        os << "            case " << i << ":\n";
+        if (b.boxed) {
+            // Copy the box as copy_() does, so that a branch not yet
+            // allocated stays so.
+            os << "                {\n"
+                << "                    const " << b.type << "* p = "
+                << slotOf(b, "other.value_", true) << ";\n"
+                << "                    " << b.type << "*& q = "
+                << slotOf(b) << ";\n"
+                << "                    if (p == 0) {\n"
+                << "                        delete q;\n"
+                << "                        q = 0;\n"
+                << "                    } else if (q == 0) {\n"
+                << "                        q = new " << b.type << "(*p);\n"
+                << "                    } else {\n"
+                << "                        *q = *p;\n"
+                << "                    }\n"
+                << "                }\n";
+        } else {
+            os << "                get_" << b.name << "() = other.get_"
+                << b.name << "();\n";
+        }
+        os << "                break;\n";
     }
-    os << " { }\n";
+    os << "            }\n"
+        << "        } else {\n"
+        << "            " << st << " tmp(other);\n"
+        << "            destroy_();\n"
+        << "            copy_(tmp);\n"
+        << "        }\n"
+        << "    }\n"
+        << "    return *this;\n"
+        << "}\n\n";
+
+    os << "inline" << sn << "~" << st << "() {\n"
+        << "    destroy_();\n"
+        << "}\n\n";
 }
 
 /**
  * Generates a type for union and emits the code.
  * Since unions can encounter names that are not fully defined yet,
  * such names must be declared and the inline functions deferred until all
- * types are fully defined.
+ * types are fully defined. Records, arrays and maps seen only as
+ * declarations are boxed, everything else is stored inline.
  */
 string CodeGen::generateUnionType(const NodePtr& n)
 {
     size_t c = n->leaves();
     vector<string> types;
     vector<string> names;
+    vector<bool> boxed;
+    vector<bool> recursive;
 
     set<NodePtr>::const_iterator it = doing.find(n);
     if (it != doing.end()) {
@@ -321,6 +565,11 @@ string CodeGen::generateUnionType(const NodePtr& n)
             const NodePtr& nn = n->leafAt(i);
             types.push_back(generateDeclaration(nn));
             names.push_back(cppNameOf(nn));
+            avro::Type t = (nn->type() == avro::AVRO_SYMBOLIC) ?
+                resolveSymbol(nn)->type() : nn->type();
+            boxed.push_back(t == avro::AVRO_RECORD ||
+                t == avro::AVRO_ARRAY || t == avro::AVRO_MAP);
+            recursive.push_back(t == avro::AVRO_RECORD);
         }
     } else {
         doing.insert(n);
@@ -328,6 +577,8 @@ string CodeGen::generateUnionType(const NodePtr& n)
             const NodePtr& nn = n->leafAt(i);
             types.push_back(generateType(nn));
             names.push_back(cppNameOf(nn));
+            boxed.push_back(false);
+            recursive.push_back(false);
         }
         doing.erase(n);
     }
@@ -337,38 +588,60 @@ string CodeGen::generateUnionType(const NodePtr& n)
 
     const string result = unionName();
 
+    vector<UnionBranch> branches;
+    vector<string> sizes;
+    vector<string> aligns;
+    for (size_t i = 0; i < c; ++i) {
+        bool isNull = n->leafAt(i)->type() == avro::AVRO_NULL;
+        branches.push_back(UnionBranch(types[i], names[i], isNull, boxed[i],
+            recursive[i]));
+        if (! isNull) {
+            string t = boxed[i] ? types[i] + "*" : types[i];
+            sizes.push_back("sizeof(" + t + ")");
+            aligns.push_back("boost::alignment_of<" + t + " >::value");
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back("1");
+        aligns.push_back("1");
+    }
+
     os_ << "struct " << result << " {\n"
         << "private:\n"
         << "    size_t idx_;\n"
-        << "    boost::any value_;\n"
+        << "    boost::aligned_storage<" << staticMax(sizes) << ",\n"
+        << "        " << staticMax(aligns) << "> value_;\n"
+        << "    void destroy_();\n"
+        << "    void copy_(const " << result << "& other);\n"
         << "public:\n"
         << "    size_t idx() const { return idx_; }\n";
 
     for (size_t i = 0; i < c; ++i) {
-        const NodePtr& nn = n->leafAt(i);
-        if (nn->type() == avro::AVRO_NULL) {
+        if (branches[i].isNull) {
             os_ << "    bool is_null() const {\n"
                 << "        return (idx_ == " << i << ");\n"
                 << "    }\n"
                 << "    void set_null() {\n"
+                << "        destroy_();\n"
                 << "        idx_ = " << i << ";\n"
-                << "        value_ = boost::any();\n"
                 << "    }\n";
         } else {
             const string& type = types[i];
             const string& name = names[i];
-            os_ << "    " << type << " get_" << name << "() const;\n"
-                   "    void set_" << name << "(const " << type << "& v);\n";
-            pendingGettersAndSetters.push_back(
-                PendingSetterGetter(result, type, name, i));
+            os_ << "    const " << type << "& get_" << name << "() const;\n"
+                << "    " << type << "& get_" << name << "();\n"
+                << "    void set_" << name << "(const " << type << "& v);\n"
+                << "    " << type << "& emplace_" << name << "();\n";
         }
     }
 
-    os_ << "    " << result << "();\n";
-    pendingConstructors.push_back(PendingConstructor(result, types[0],
-        n->leafAt(0)->type() != avro::AVRO_NULL));
-    os_ << "};\n\n";
-    
+    os_ << "    " << result << "();\n"
+        << "    " << result << "(const " << result << "& other);\n"
+        << "    " << result << "& operator=(const " << result << "& other);\n"
+        << "    ~" << result << "();\n"
+        << "};\n\n";
+
+    pendingUnions.push_back(PendingUnion(result, branches));
     return result;
 }
 
@@ -481,8 +754,35 @@ void CodeGen::generateRecordTraits(const NodePtr& n)
     os_ << "    }\n"
         << "    static void decode(Decoder& d, " << fn << "& v) {\n";
 
-    for (size_t i = 0; i < c; ++i) {
-        os_ << "        avro::decode(d, v." << n->nameAt(i) << ");\n";
+    // A resolving decoder hands out the fields in the writer's order, which
+    // need not be the order they are declared in here.
+    if (c > 1) {
+        os_ << "        if (const std::vector<size_t>* fo = "
+                "d.recordFieldOrder()) {\n"
+            << "            for (std::vector<size_t>::const_iterator it = "
+                "fo->begin();\n"
+            << "                it != fo->end(); ++it) {\n"
+            << "                switch (*it) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            os_ << "                case " << i << ":\n"
+                << "                    avro::decode(d, v." << n->nameAt(i)
+                << ");\n"
+                << "                    break;\n";
+        }
+        os_ << "                default:\n"
+            << "                    throw avro::Exception(\"Invalid field "
+                "index in the field order\");\n"
+            << "                }\n"
+            << "            }\n"
+            << "        } else {\n";
+        for (size_t i = 0; i < c; ++i) {
+            os_ << "            avro::decode(d, v." << n->nameAt(i) << ");\n";
+        }
+        os_ << "        }\n";
+    } else {
+        for (size_t i = 0; i < c; ++i) {
+            os_ << "        avro::decode(d, v." << n->nameAt(i) << ");\n";
+        }
     }
 
     os_ << "    }\n"
@@ -502,7 +802,7 @@ void CodeGen::generateUnionTraits(const NodePtr& n)
     string fn = fullname(name);
 
     os_ << "template<> struct codec_traits<" << fn << "> {\n"
-        << "    static void encode(Encoder& e, " << fn << " v) {\n"
+        << "    static void encode(Encoder& e, const " << fn << "& v) {\n"
         << "        e.encodeUnionIndex(v.idx());\n"
         << "        switch (v.idx()) {\n";
 
@@ -533,11 +833,10 @@ void CodeGen::generateUnionTraits(const NodePtr& n)
             os_ << "            d.decodeNull();\n"
                 << "            v.set_null();\n";
         } else {
-            os_ << "            {\n"
-                << "                " << cppTypeOf(nn) << " vv;\n"
-                << "                avro::decode(d, vv);\n"
-                << "                v.set_" << cppNameOf(nn) << "(vv);\n"
-                << "            }\n";
+            const string name = cppNameOf(nn);
+            os_ << "            avro::decode(d, v.idx() == " << i
+                << " ? v.get_" << name << "() : v.emplace_" << name
+                << "());\n";
         }
         os_ << "            break;\n";
     }
@@ -578,6 +877,484 @@ void CodeGen::generateTraits(const NodePtr& n)
     }
 }
 
+/**
+ * Returns the number of bytes in the varint encoding of \p v, an
+ * already zig-zagged value.
+ */
+static size_t varintSize(uint64_t v)
+{
+    size_t result = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        ++result;
+    }
+    return result;
+}
+
+/**
+ * Computes in \p size the largest binary encoding of any value of the
+ * given schema. Returns false if there is no such bound.
+ */
+static bool maxEncodedSize(const NodePtr& n, size_t& size,
+    set<NodePtr>& seen)
+{
+    NodePtr nn = (n->type() == avro::AVRO_SYMBOLIC) ? resolveSymbol(n) : n;
+    switch (nn->type()) {
+    case avro::AVRO_NULL:
+        size = 0;
+        return true;
+    case avro::AVRO_BOOL:
+        size = 1;
+        return true;
+    case avro::AVRO_INT:
+        size = 5;
+        return true;
+    case avro::AVRO_LONG:
+        size = 10;
+        return true;
+    case avro::AVRO_FLOAT:
+        size = 4;
+        return true;
+    case avro::AVRO_DOUBLE:
+        size = 8;
+        return true;
+    case avro::AVRO_FIXED:
+        size = nn->fixedSize();
+        return true;
+    case avro::AVRO_ENUM:
+        size = varintSize(2 * (nn->names() - 1));
+        return true;
+    case avro::AVRO_RECORD:
+    case avro::AVRO_UNION:
+        {
+            if (seen.find(nn) != seen.end()) {
+                return false;
+            }
+            seen.insert(nn);
+            size_t total = 0;
+            size_t largest = 0;
+            bool bounded = true;
+            for (size_t i = 0; bounded && i < nn->leaves(); ++i) {
+                size_t s;
+                bounded = maxEncodedSize(nn->leafAt(i), s, seen);
+                total += s;
+                largest = std::max(largest, s);
+            }
+            seen.erase(nn);
+            if (! bounded) {
+                return false;
+            }
+            size = (nn->type() == avro::AVRO_RECORD) ? total :
+                varintSize(2 * (nn->leaves() - 1)) + largest;
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+static bool maxEncodedSize(const NodePtr& n, size_t& size)
+{
+    set<NodePtr> seen;
+    return maxEncodedSize(n, size, seen);
+}
+
+/**
+ * Returns true if values of the given schema can hold strings or bytes.
+ */
+static bool holdsStringsOrBytes(const NodePtr& n, set<NodePtr>& seen)
+{
+    NodePtr nn = (n->type() == avro::AVRO_SYMBOLIC) ? resolveSymbol(n) : n;
+    switch (nn->type()) {
+    case avro::AVRO_STRING:
+    case avro::AVRO_BYTES:
+        return true;
+    case avro::AVRO_RECORD:
+    case avro::AVRO_UNION:
+    case avro::AVRO_ARRAY:
+    case avro::AVRO_MAP:
+        if (! seen.insert(nn).second) {
+            return false;
+        }
+        // Map keys stay std::string, so only a map's values count.
+        for (size_t i = nn->type() == avro::AVRO_MAP ? 1 : 0;
+            i < nn->leaves(); ++i) {
+            if (holdsStringsOrBytes(nn->leafAt(i), seen)) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Computes in \p size the length of the binary encoding shared by all
+ * values of the given schema. Returns false if the length depends on the
+ * value.
+ */
+static bool constantEncodedSize(const NodePtr& n, size_t& size,
+    set<NodePtr>& seen)
+{
+    NodePtr nn = (n->type() == avro::AVRO_SYMBOLIC) ? resolveSymbol(n) : n;
+    switch (nn->type()) {
+    case avro::AVRO_NULL:
+    case avro::AVRO_BOOL:
+    case avro::AVRO_FLOAT:
+    case avro::AVRO_DOUBLE:
+    case avro::AVRO_FIXED:
+        return maxEncodedSize(nn, size, seen);
+    case avro::AVRO_ENUM:
+        // Ordinals below 64 take a single byte.
+        size = 1;
+        return nn->names() <= 64;
+    case avro::AVRO_RECORD:
+    case avro::AVRO_UNION:
+        {
+            if (seen.find(nn) != seen.end() ||
+                (nn->type() == avro::AVRO_UNION && nn->leaves() > 64)) {
+                return false;
+            }
+            seen.insert(nn);
+            size_t total = 0;
+            size_t branch = 0;
+            bool constant = true;
+            for (size_t i = 0; constant && i < nn->leaves(); ++i) {
+                size_t s;
+                constant = constantEncodedSize(nn->leafAt(i), s, seen) &&
+                    (nn->type() == avro::AVRO_RECORD || i == 0 || s == branch);
+                total += s;
+                branch = s;
+            }
+            seen.erase(nn);
+            if (! constant) {
+                return false;
+            }
+            size = (nn->type() == avro::AVRO_RECORD) ? total : 1 + branch;
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+static bool constantEncodedSize(const NodePtr& n, size_t& size)
+{
+    set<NodePtr> seen;
+    return constantEncodedSize(n, size, seen);
+}
+
+void CodeGen::generateEnumBinaryTraits(const NodePtr& n)
+{
+    string fn = fullname(decorate(n->name()));
+    size_t maxSize;
+    maxEncodedSize(n, maxSize);
+    os_ << "template<> struct binary_codec_traits<" << fn << ">";
+    if (binaryCodec_) {
+        os_ << " :\n"
+            << "    public binary::bounded_codec<" << fn << "> {\n"
+            << "    static const size_t maxSize = " << maxSize << ";\n";
+    } else {
+        os_ << " {\n";
+    }
+    if (n->names() <= 64) {
+        os_ << "    static size_t size(" << fn << ") {\n"
+            << "        return 1;\n"
+            << "    }\n";
+    } else {
+        os_ << "    static size_t size(" << fn << " v) {\n"
+            << "        return binary::longSize(v);\n"
+            << "    }\n";
+    }
+    if (! binaryCodec_) {
+        os_ << "};\n\n";
+        return;
+    }
+    os_ << "    static void put(uint8_t*& p, " << fn << " v) {\n"
+        << "        binary::putLong(p, v);\n"
+        << "    }\n"
+        << "    static bool decode(const uint8_t*& p, const uint8_t* end, "
+            << fn << "& v) {\n"
+        << "        int64_t n;\n"
+        << "        if (! binary::decodeLong(p, end, n)) {\n"
+        << "            return false;\n"
+        << "        }\n"
+        << "        if (n < 0 || n >= " << n->names() << ") {\n"
+        << "            throw avro::Exception(\"Enum value out of range\");\n"
+        << "        }\n"
+        << "        v = static_cast<" << fn << ">(n);\n"
+        << "        return true;\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+/**
+ * With --views, marks the type for a record or union that holds strings
+ * or bytes as holding views.
+ */
+void CodeGen::generateHoldsViews(const NodePtr& n, const string& fn)
+{
+    set<NodePtr> seen;
+    if (views_ && holdsStringsOrBytes(n, seen)) {
+        os_ << "template<> struct holds_views<" << fn << "> {\n"
+            << "    static const bool value = true;\n"
+            << "};\n\n";
+    }
+}
+
+void CodeGen::generateRecordBinaryTraits(const NodePtr& n)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateBinaryTraits(n->leafAt(i));
+    }
+    generateHoldsViews(n, fullname(decorate(n->name())));
+
+    vector<size_t> sizes;
+    vector<bool> bounded;
+    for (size_t i = 0; i < c; ++i) {
+        size_t s = 0;
+        bounded.push_back(maxEncodedSize(n->leafAt(i), s));
+        sizes.push_back(s);
+    }
+    size_t maxSize;
+    bool isBounded = maxEncodedSize(n, maxSize);
+
+    string fn = fullname(decorate(n->name()));
+    os_ << "template<> struct binary_codec_traits<" << fn << "> {\n";
+
+    // Fields of constant width are folded into a single constant.
+    size_t constant = 0;
+    vector<string> terms;
+    for (size_t i = 0; i < c; ++i) {
+        size_t s;
+        if (constantEncodedSize(n->leafAt(i), s)) {
+            constant += s;
+        } else {
+            terms.push_back("binary::size(v." + n->nameAt(i) + ")");
+        }
+    }
+    if (terms.empty()) {
+        os_ << "    static size_t size(const " << fn << "&) {\n"
+            << "        return " << constant << ";\n";
+    } else {
+        os_ << "    static size_t size(const " << fn << "& v) {\n"
+            << "        return ";
+        if (constant != 0) {
+            os_ << constant << " +\n            ";
+        }
+        for (size_t i = 0; i < terms.size(); ++i) {
+            os_ << (i == 0 ? "" : " +\n            ") << terms[i];
+        }
+        os_ << ";\n";
+    }
+    os_ << "    }\n";
+
+    if (! binaryCodec_) {
+        os_ << "};\n\n";
+        return;
+    }
+
+    if (isBounded) {
+        os_ << "    static const size_t maxSize = " << maxSize << ";\n"
+            << "    static void put(uint8_t*& p, const " << fn << "& v) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            if (sizes[i] != 0) {
+                os_ << "        binary::put(p, v." << n->nameAt(i) << ");\n";
+            }
+        }
+        os_ << "    }\n"
+            << "    static bool encode(uint8_t*& p, uint8_t* end, const "
+                << fn << "& v) {\n"
+            << "        if (static_cast<size_t>(end - p) < maxSize) {\n"
+            << "            return false;\n"
+            << "        }\n"
+            << "        put(p, v);\n"
+            << "        return true;\n"
+            << "    }\n";
+    } else {
+        os_ << "    static bool encode(uint8_t*& p, uint8_t* end, const "
+            << fn << "& v) {\n";
+        for (size_t i = 0; i < c; ) {
+            if (bounded[i]) {
+                // A run of fields with bounded size needs just one check.
+                size_t j = i;
+                size_t run = 0;
+                for (; j < c && bounded[j]; ++j) {
+                    run += sizes[j];
+                }
+                if (run != 0) {
+                    os_ << "        if (static_cast<size_t>(end - p) < "
+                        << run << ") {\n"
+                        << "            return false;\n"
+                        << "        }\n";
+                }
+                for (; i < j; ++i) {
+                    if (sizes[i] != 0) {
+                        os_ << "        binary::put(p, v." << n->nameAt(i)
+                            << ");\n";
+                    }
+                }
+            } else {
+                os_ << "        if (! binary::encode(p, end, v."
+                    << n->nameAt(i) << ")) {\n"
+                    << "            return false;\n"
+                    << "        }\n";
+                ++i;
+            }
+        }
+        os_ << "        return true;\n"
+            << "    }\n";
+    }
+
+    os_ << "    static bool decode(const uint8_t*& p, const uint8_t* end, "
+        << fn << "& v) {\n"
+        << "        return ";
+    const char* sep = "";
+    for (size_t i = 0; i < c; ++i) {
+        if (! bounded[i] || sizes[i] != 0) {
+            os_ << sep << "binary::decode(p, end, v." << n->nameAt(i) << ")";
+            sep = " &&\n            ";
+        }
+    }
+    if (*sep == '\0') {
+        os_ << "true";
+    }
+    os_ << ";\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void CodeGen::generateUnionBinaryTraits(const NodePtr& n)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateBinaryTraits(n->leafAt(i));
+    }
+
+    string fn = fullname(done[n]);
+    size_t maxSize;
+    bool isBounded = maxEncodedSize(n, maxSize);
+    generateHoldsViews(n, fn);
+
+    os_ << "template<> struct binary_codec_traits<" << fn << ">";
+    if (binaryCodec_ && isBounded) {
+        os_ << " :\n"
+            << "    public binary::bounded_codec<" << fn << ">";
+    }
+    os_ << " {\n";
+
+    size_t constant;
+    if (constantEncodedSize(n, constant)) {
+        os_ << "    static size_t size(const " << fn << "&) {\n"
+            << "        return " << constant << ";\n"
+            << "    }\n";
+    } else {
+        os_ << "    static size_t size(const " << fn << "& v) {\n"
+            << "        size_t n = binary::longSize(v.idx());\n"
+            << "        switch (v.idx()) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr& nn = n->leafAt(i);
+            if (nn->type() != avro::AVRO_NULL) {
+                os_ << "        case " << i << ":\n"
+                    << "            return n + binary::size(v.get_"
+                    << cppNameOf(nn) << "());\n";
+            }
+        }
+        os_ << "        }\n"
+            << "        return n;\n"
+            << "    }\n";
+    }
+
+    if (! binaryCodec_) {
+        os_ << "};\n\n";
+        return;
+    }
+
+    if (isBounded) {
+        os_ << "    static const size_t maxSize = " << maxSize << ";\n"
+            << "    static void put(uint8_t*& p, const " << fn << "& v) {\n"
+            << "        binary::putLong(p, v.idx());\n"
+            << "        switch (v.idx()) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr& nn = n->leafAt(i);
+            if (nn->type() != avro::AVRO_NULL) {
+                os_ << "        case " << i << ":\n"
+                    << "            binary::put(p, v.get_" << cppNameOf(nn)
+                    << "());\n"
+                    << "            break;\n";
+            }
+        }
+        os_ << "        }\n"
+            << "    }\n";
+    } else {
+        os_ << "    static bool encode(uint8_t*& p, uint8_t* end, const "
+                << fn << "& v) {\n"
+            << "        if (! binary::encodeLong(p, end, v.idx())) {\n"
+            << "            return false;\n"
+            << "        }\n"
+            << "        switch (v.idx()) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr& nn = n->leafAt(i);
+            if (nn->type() != avro::AVRO_NULL) {
+                os_ << "        case " << i << ":\n"
+                    << "            return binary::encode(p, end, v.get_"
+                    << cppNameOf(nn) << "());\n";
+            }
+        }
+        os_ << "        }\n"
+            << "        return true;\n"
+            << "    }\n";
+    }
+
+    os_ << "    static bool decode(const uint8_t*& p, const uint8_t* end, "
+            << fn << "& v) {\n"
+        << "        int64_t n;\n"
+        << "        if (! binary::decodeLong(p, end, n)) {\n"
+        << "            return false;\n"
+        << "        }\n"
+        << "        switch (n) {\n";
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr& nn = n->leafAt(i);
+        os_ << "        case " << i << ":\n";
+        if (nn->type() == avro::AVRO_NULL) {
+            os_ << "            v.set_null();\n"
+                << "            return true;\n";
+        } else {
+            const string name = cppNameOf(nn);
+            os_ << "            return binary::decode(p, end, v.idx() == "
+                << i << " ? v.get_" << name << "() : v.emplace_" << name
+                << "());\n";
+        }
+    }
+    os_ << "        }\n"
+        << "        throw avro::Exception(\"Union index too big\");\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void CodeGen::generateBinaryTraits(const NodePtr& n)
+{
+    switch (n->type()) {
+    case avro::AVRO_RECORD:
+        generateRecordBinaryTraits(n);
+        break;
+    case avro::AVRO_ENUM:
+        generateEnumBinaryTraits(n);
+        break;
+    case avro::AVRO_ARRAY:
+    case avro::AVRO_MAP:
+        generateBinaryTraits(n->leafAt(n->type() == avro::AVRO_ARRAY ? 0 : 1));
+        break;
+    case avro::AVRO_UNION:
+        generateUnionBinaryTraits(n);
+        break;
+    default:
+        break;
+    }
+}
+
 void CodeGen::emitCopyright()
 {
     os_ << 
@@ -611,7 +1388,566 @@ string CodeGen::guard()
     return h + "_" + lexical_cast<string>(random_()) + "__H_";
 }
 
-void CodeGen::generate(const ValidSchema& schema)
+/**
+ * Writes the given text as a C++ string literal, one source line per line
+ * of text.
+ */
+static void generateStringLiteral(ostream& os, const string& text)
+{
+    const char oct[] = "01234567";
+    bool open = false;
+    for (string::const_iterator it = text.begin(); it != text.end(); ++it) {
+        if (! open) {
+            os << (it == text.begin() ? "" : "\n") << "            \"";
+            open = true;
+        }
+        const unsigned char c = *it;
+        switch (c) {
+        case '"':
+            os << "\\\"";
+            break;
+        case '\\':
+            os << "\\\\";
+            break;
+        case '\n':
+            os << "\\n\"";
+            open = false;
+            break;
+        default:
+            if (c < 0x20 || c >= 0x7f) {
+                // Octal escapes, unlike hex ones, never run into the next
+                // character.
+                os << '\\' << oct[(c >> 6) & 7] << oct[(c >> 3) & 7]
+                    << oct[c & 7];
+            } else {
+                os << c;
+            }
+            break;
+        }
+    }
+    if (open) {
+        os << '"';
+    } else if (text.empty()) {
+        os << "            \"\"";
+    }
+}
+
+void CodeGen::generateSchemaTraits(const ValidSchema& schema,
+    const string& json)
+{
+    const NodePtr& root = schema.root();
+    string fn;
+    switch (root->type()) {
+    case avro::AVRO_RECORD:
+    case avro::AVRO_ENUM:
+        fn = fullname(decorate(root->name()));
+        break;
+    case avro::AVRO_UNION:
+        fn = fullname(done[root]);
+        break;
+    default:
+        // Primitives, arrays and maps map onto standard types which
+        // several schemas may share.
+        return;
+    }
+
+    std::ostringstream fp;
+    fp << "0x" << std::hex << schema.fingerprint() << "ULL";
+
+    os_ << "template<> struct schema_traits<" << fn << "> :\n"
+        << "    public static_fingerprint<" << fp.str() << "> {\n"
+        << "    static const char* json() {\n"
+        << "        return\n";
+    generateStringLiteral(os_, json);
+    os_ << ";\n"
+        << "    }\n"
+        << "    static const ValidSchema& schema() {\n"
+        << "        return compiledSchema(fingerprint, json());\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+static void generateOperatorDecls(ostream& os, const string& type)
+{
+    os << "inline bool operator==(const " << type << "& a, const " << type
+        << "& b);\n"
+        << "inline bool operator!=(const " << type << "& a, const " << type
+        << "& b);\n"
+        << "inline bool operator<(const " << type << "& a, const " << type
+        << "& b);\n";
+}
+
+/**
+ * Generates equality and ordering for a record. Fields compare in the order
+ * they are declared; fields with order "descending" compare the other way
+ * round and fields with order "ignore" are left out altogether.
+ */
+void CodeGen::generateRecordComparison(const NodePtr& n, ostream& decls,
+    ostream& defs)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateComparison(n->leafAt(i), decls, defs);
+    }
+
+    const string type = decorate(n->name());
+    comparable_.push_back(type);
+    generateOperatorDecls(decls, type);
+
+    vector<string> fields;
+    vector<bool> descending;
+    for (size_t i = 0; i < c; ++i) {
+        const avro::SortOrder o = n->sortOrderAt(i);
+        if (o != avro::AVRO_IGNORE) {
+            fields.push_back(n->nameAt(i));
+            descending.push_back(o == avro::AVRO_DESCENDING);
+        }
+    }
+    const string params = fields.empty() ?
+        "(const " + type + "&, const " + type + "&)" :
+        "(const " + type + "& a, const " + type + "& b)";
+
+    defs << "inline bool operator==" << params << " {\n"
+        << "    return ";
+    if (fields.empty()) {
+        defs << "true";
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        defs << (i == 0 ? "" : " &&\n        ")
+            << "a." << fields[i] << " == b." << fields[i];
+    }
+    defs << ";\n"
+        << "}\n\n";
+
+    defs << "inline bool operator!=(const " << type << "& a, const " << type
+            << "& b) {\n"
+        << "    return ! (a == b);\n"
+        << "}\n\n";
+
+    defs << "inline bool operator<" << params << " {\n";
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const string& f = fields[i];
+        defs << "    if (a." << f << " != b." << f << ") {\n"
+            << "        return " << (descending[i] ? "b." : "a.") << f
+            << " < " << (descending[i] ? "a." : "b.") << f << ";\n"
+            << "    }\n";
+    }
+    defs << "    return false;\n"
+        << "}\n\n";
+}
+
+/**
+ * Generates equality and ordering for a union. Values in different
+ * branches order by branch index.
+ */
+void CodeGen::generateUnionComparison(const NodePtr& n, ostream& decls,
+    ostream& defs)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateComparison(n->leafAt(i), decls, defs);
+    }
+
+    const string type = done[n];
+    comparable_.push_back(type);
+    generateOperatorDecls(decls, type);
+
+    const char* ops[] = { "==", "<" };
+    for (size_t k = 0; k < 2; ++k) {
+        const bool eq = k == 0;
+        defs << "inline bool operator" << ops[k] << "(const " << type
+                << "& a, const " << type << "& b) {\n"
+            << "    if (a.idx() != b.idx()) {\n"
+            << "        return " << (eq ? "false" : "a.idx() < b.idx()")
+            << ";\n"
+            << "    }\n"
+            << "    switch (a.idx()) {\n";
+        for (size_t i = 0; i < c; ++i) {
+            const NodePtr& nn = n->leafAt(i);
+            if (nn->type() != avro::AVRO_NULL) {
+                const string name = cppNameOf(nn);
+                defs << "    case " << i << ":\n";
+                if (nn->type() == avro::AVRO_SYMBOLIC) {
+                    // Recursive branches never set read as one shared
+                    // default, which must not be walked into forever.
+                    defs << "        if (&a.get_" << name << "() == &b.get_"
+                        << name << "()) {\n"
+                        << "            return " << (eq ? "true" : "false")
+                        << ";\n"
+                        << "        }\n";
+                }
+                defs << "        return a.get_" << name << "() " << ops[k]
+                    << " b.get_" << name << "();\n";
+            }
+        }
+        defs << "    }\n"
+            << "    return " << (eq ? "true" : "false") << ";\n"
+            << "}\n\n";
+        if (eq) {
+            defs << "inline bool operator!=(const " << type << "& a, const "
+                    << type << "& b) {\n"
+                << "    return ! (a == b);\n"
+                << "}\n\n";
+        }
+    }
+}
+
+void CodeGen::generateComparison(const NodePtr& n, ostream& decls,
+    ostream& defs)
+{
+    switch (n->type()) {
+    case avro::AVRO_RECORD:
+        generateRecordComparison(n, decls, defs);
+        break;
+    case avro::AVRO_ARRAY:
+    case avro::AVRO_MAP:
+        generateComparison(n->leafAt(n->type() == avro::AVRO_ARRAY ? 0 : 1),
+            decls, defs);
+        break;
+    case avro::AVRO_UNION:
+        generateUnionComparison(n, decls, defs);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Generates operator==, operator!= and operator< for the records and unions
+ * in the schema. All are declared before any is defined, since recursive
+ * schemas make the definitions refer to each other.
+ */
+void CodeGen::generateComparisons(const NodePtr& root)
+{
+    std::ostringstream decls;
+    std::ostringstream defs;
+    generateComparison(root, decls, defs);
+    if (! comparable_.empty()) {
+        os_ << decls.str() << "\n" << defs.str();
+    }
+}
+
+void CodeGen::generateEnumHashTraits(const NodePtr& n)
+{
+    string fn = fullname(decorate(n->name()));
+    os_ << "template<> struct hash_traits<" << fn << "> {\n"
+        << "    static size_t hash(" << fn << " v) {\n"
+        << "        return avro::hash(static_cast<int32_t>(v));\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void CodeGen::generateRecordHashTraits(const NodePtr& n)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateHashTraits(n->leafAt(i));
+    }
+
+    string fn = fullname(decorate(n->name()));
+    vector<string> fields;
+    for (size_t i = 0; i < c; ++i) {
+        if (n->sortOrderAt(i) != avro::AVRO_IGNORE) {
+            fields.push_back(n->nameAt(i));
+        }
+    }
+
+    os_ << "template<> struct hash_traits<" << fn << "> {\n"
+        << "    static size_t hash(const " << fn
+        << (fields.empty() ? "&" : "& v") << ") {\n"
+        << "        size_t h = " << fields.size() << ";\n";
+    for (vector<string>::const_iterator it = fields.begin();
+        it != fields.end(); ++it) {
+        os_ << "        h = hashing::combine(h, avro::hash(v." << *it
+            << "));\n";
+    }
+    os_ << "        return h;\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void CodeGen::generateUnionHashTraits(const NodePtr& n)
+{
+    size_t c = n->leaves();
+    for (size_t i = 0; i < c; ++i) {
+        generateHashTraits(n->leafAt(i));
+    }
+
+    string fn = fullname(done[n]);
+    os_ << "template<> struct hash_traits<" << fn << "> {\n"
+        << "    static size_t hash(const " << fn << "& v) {\n"
+        << "        switch (v.idx()) {\n";
+    for (size_t i = 0; i < c; ++i) {
+        const NodePtr& nn = n->leafAt(i);
+        if (nn->type() != avro::AVRO_NULL) {
+            os_ << "        case " << i << ":\n"
+                << "            return hashing::combine(" << i
+                << ", avro::hash(v.get_" << cppNameOf(nn) << "()));\n";
+        }
+    }
+    os_ << "        }\n"
+        << "        return v.idx();\n"
+        << "    }\n"
+        << "};\n\n";
+}
+
+void CodeGen::generateHashTraits(const NodePtr& n)
+{
+    switch (n->type()) {
+    case avro::AVRO_RECORD:
+        generateRecordHashTraits(n);
+        break;
+    case avro::AVRO_ENUM:
+        generateEnumHashTraits(n);
+        break;
+    case avro::AVRO_ARRAY:
+    case avro::AVRO_MAP:
+        generateHashTraits(n->leafAt(n->type() == avro::AVRO_ARRAY ? 0 : 1));
+        break;
+    case avro::AVRO_UNION:
+        generateUnionHashTraits(n);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Generates hash_value() for the records and unions in the schema, so that
+ * boost::hash, and with it boost::unordered containers, pick up avro::hash.
+ */
+void CodeGen::generateHashValues()
+{
+    if (comparable_.empty()) {
+        return;
+    }
+    if (! ns_.empty()) {
+        os_ << "namespace " << ns_ << " {\n";
+    }
+    for (vector<string>::const_iterator it = comparable_.begin();
+        it != comparable_.end(); ++it) {
+        os_ << "inline size_t hash_value(const " << *it << "& v) {\n"
+            << "    return avro::hash(v);\n"
+            << "}\n\n";
+    }
+    if (! ns_.empty()) {
+        os_ << "}\n";
+    }
+}
+
+static string skipperName(const NodePtr& n)
+{
+    return "skip_" + decorate(n->name());
+}
+
+static string indent(size_t depth)
+{
+    return string(4 * (depth + 1), ' ');
+}
+
+/**
+ * Writes statements that skip a value of the given schema. Records are
+ * skipped by calling a function, which is how recursive schemas are
+ * handled; the records that need such a function are added to records.
+ */
+void CodeGen::generateSkip(ostream& os, const NodePtr& node, size_t depth,
+    vector<NodePtr>& records)
+{
+    const NodePtr& n = (node->type() == avro::AVRO_SYMBOLIC) ?
+        resolveSymbol(node) : node;
+    const string in = indent(depth);
+    const string k = lexical_cast<string>(depth);
+    switch (n->type()) {
+    case avro::AVRO_NULL:
+        os << in << "d.decodeNull();\n";
+        break;
+    case avro::AVRO_BOOL:
+        os << in << "d.decodeBool();\n";
+        break;
+    case avro::AVRO_INT:
+        os << in << "d.decodeInt();\n";
+        break;
+    case avro::AVRO_LONG:
+        os << in << "d.decodeLong();\n";
+        break;
+    case avro::AVRO_FLOAT:
+        os << in << "d.decodeFloat();\n";
+        break;
+    case avro::AVRO_DOUBLE:
+        os << in << "d.decodeDouble();\n";
+        break;
+    case avro::AVRO_STRING:
+        os << in << "d.skipString();\n";
+        break;
+    case avro::AVRO_BYTES:
+        os << in << "d.skipBytes();\n";
+        break;
+    case avro::AVRO_FIXED:
+        os << in << "d.skipFixed(" << n->fixedSize() << ");\n";
+        break;
+    case avro::AVRO_ENUM:
+        os << in << "d.decodeEnum();\n";
+        break;
+    case avro::AVRO_ARRAY:
+    case avro::AVRO_MAP:
+        {
+            const bool isArray = n->type() == avro::AVRO_ARRAY;
+            os << in << "for (size_t n" << k << " = d."
+                << (isArray ? "skipArray()" : "skipMap()") << "; n" << k
+                << " != 0; n" << k << " = d."
+                << (isArray ? "arrayNext()" : "mapNext()") << ") {\n"
+                << in << "    for (size_t i" << k << " = 0; i" << k
+                << " < n" << k << "; ++i" << k << ") {\n";
+            if (! isArray) {
+                os << indent(depth + 2) << "d.skipString();\n";
+            }
+            generateSkip(os, n->leafAt(isArray ? 0 : 1), depth + 2, records);
+            os << in << "    }\n"
+                << in << "}\n";
+        }
+        break;
+    case avro::AVRO_UNION:
+        os << in << "switch (d.decodeUnionIndex()) {\n";
+        for (size_t i = 0; i < n->leaves(); ++i) {
+            os << in << "case " << i << ":\n";
+            generateSkip(os, n->leafAt(i), depth + 1, records);
+            os << in << "    break;\n";
+        }
+        os << in << "}\n";
+        break;
+    case avro::AVRO_RECORD:
+        if (std::find(records.begin(), records.end(), n) == records.end()) {
+            records.push_back(n);
+        }
+        os << in << skipperName(n) << "(d);\n";
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Writes statements that decode the fields of record n whose paths, relative
+ * to the top-level record, are in paths. Fields that lead to a selected
+ * field are descended into; all other fields are skipped.
+ */
+void CodeGen::generateDecodeOnlyFields(ostream& os, const NodePtr& n,
+    const string& prefix, const set<string>& paths, vector<NodePtr>& records)
+{
+    for (size_t i = 0; i < n->leaves(); ++i) {
+        const string path = prefix + n->nameAt(i);
+        if (paths.find(path) != paths.end()) {
+            os << "    avro::decode(d, v." << path << ");\n";
+            continue;
+        }
+        const string sub = path + ".";
+        set<string>::const_iterator it = paths.lower_bound(sub);
+        if (it != paths.end() && it->compare(0, sub.size(), sub) == 0) {
+            NodePtr leaf = n->leafAt(i);
+            if (leaf->type() == avro::AVRO_SYMBOLIC) {
+                leaf = resolveSymbol(leaf);
+            }
+            generateDecodeOnlyFields(os, leaf, sub, paths, records);
+        } else {
+            generateSkip(os, n->leafAt(i), 0, records);
+        }
+    }
+}
+
+/**
+ * Checks that path names a field of record n, following records for
+ * dotted paths.
+ */
+static void checkFieldPath(const NodePtr& root, const string& path)
+{
+    NodePtr n = root;
+    vector<string> parts;
+    boost::algorithm::split(parts, path, boost::algorithm::is_any_of("."));
+    for (vector<string>::const_iterator it = parts.begin();
+        it != parts.end(); ++it) {
+        if (n->type() == avro::AVRO_SYMBOLIC) {
+            n = resolveSymbol(n);
+        }
+        size_t pos;
+        if (n->type() != avro::AVRO_RECORD || ! n->nameIndex(*it, pos)) {
+            throw avro::Exception(boost::format(
+                "No field %1% in the decode-only path %2%") % *it % path);
+        }
+        n = n->leafAt(pos);
+    }
+}
+
+/**
+ * Generates the decodeOnly_ functions requested on the command line. Each
+ * specification is of the form name=field[,field...], where each field is
+ * a dotted path through nested records from the top-level record.
+ */
+void CodeGen::generateDecodeOnly(const NodePtr& root)
+{
+    if (decodeOnly_.empty()) {
+        return;
+    }
+    if (root->type() != avro::AVRO_RECORD) {
+        throw avro::Exception(
+            "Partial decoders need a record as the top-level schema");
+    }
+
+    vector<NodePtr> records;
+    std::ostringstream functions;
+    const string fn = decorate(root->name());
+    for (vector<string>::const_iterator it = decodeOnly_.begin();
+        it != decodeOnly_.end(); ++it) {
+        const size_t eq = it->find('=');
+        if (eq == string::npos || eq == 0) {
+            throw avro::Exception(boost::format(
+                "Invalid decode-only specification: %1%") % *it);
+        }
+        vector<string> fields;
+        boost::algorithm::split(fields, it->substr(eq + 1),
+            boost::algorithm::is_any_of(","));
+        set<string> paths;
+        for (vector<string>::const_iterator f = fields.begin();
+            f != fields.end(); ++f) {
+            checkFieldPath(root, *f);
+            paths.insert(*f);
+        }
+
+        functions << "inline void decodeOnly_" << it->substr(0, eq)
+            << "(avro::Decoder& d, " << fn << "& v) {\n";
+        generateDecodeOnlyFields(functions, root, "", paths, records);
+        functions << "}\n\n";
+    }
+
+    // Skipping a record may need the skippers of other records, so the
+    // list grows as it is walked.
+    std::ostringstream skippers;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const NodePtr n = records[i];
+        skippers << "inline void " << skipperName(n)
+            << "(avro::Decoder& d) {\n";
+        for (size_t j = 0; j < n->leaves(); ++j) {
+            generateSkip(skippers, n->leafAt(j), 0, records);
+        }
+        skippers << "}\n\n";
+    }
+
+    if (! ns_.empty()) {
+        os_ << "namespace " << ns_ << " {\n";
+    }
+    for (vector<NodePtr>::const_iterator it = records.begin();
+        it != records.end(); ++it) {
+        os_ << "inline void " << skipperName(*it) << "(avro::Decoder& d);\n";
+    }
+    if (! records.empty()) {
+        os_ << "\n";
+    }
+    os_ << skippers.str() << functions.str();
+    if (! ns_.empty()) {
+        os_ << "}\n";
+    }
+}
+
+void CodeGen::generate(const ValidSchema& schema, const string& json)
 {
     emitCopyright();
 
@@ -620,11 +1956,19 @@ void CodeGen::generate(const ValidSchema& schema)
     os_ << "#ifndef " << h << "\n";
     os_ << "#define " << h << "\n\n\n";
 
-    os_ << "#include \"boost/any.hpp\"\n"
+    os_ << "#include <new>\n"
+        << "#include \"boost/integer/static_min_max.hpp\"\n"
+        << "#include \"boost/type_traits/aligned_storage.hpp\"\n"
+        << "#include \"boost/type_traits/alignment_of.hpp\"\n"
         << "#include \"" << includePrefix_ << "Specific.hh\"\n"
         << "#include \"" << includePrefix_ << "Encoder.hh\"\n"
         << "#include \"" << includePrefix_ << "Decoder.hh\"\n"
-        << "\n";
+        << "#include \"" << includePrefix_ << "Compiler.hh\"\n"
+        << "#include \"" << includePrefix_ << "BinaryCodec.hh\"\n";
+    if (compare_) {
+        os_ << "#include \"" << includePrefix_ << "Hash.hh\"\n";
+    }
+    os_ << "\n";
 
     if (! ns_.empty()) {
         os_ << "namespace " << ns_ << " {\n";
@@ -634,18 +1978,13 @@ void CodeGen::generate(const ValidSchema& schema)
     const NodePtr& root = schema.root();
     generateType(root);
 
-    for (vector<PendingSetterGetter>::const_iterator it =
-        pendingGettersAndSetters.begin();
-        it != pendingGettersAndSetters.end(); ++it) {
-        generateGetterAndSetter(os_, it->structName, it->type, it->name,
-            it->idx);
+    for (vector<PendingUnion>::const_iterator it = pendingUnions.begin();
+        it != pendingUnions.end(); ++it) {
+        generateUnionMembers(os_, *it);
     }
 
-    for (vector<PendingConstructor>::const_iterator it =
-        pendingConstructors.begin();
-        it != pendingConstructors.end(); ++it) {
-        generateConstructor(os_, it->structName,
-            it->initMember, it->memberName);
+    if (compare_) {
+        generateComparisons(root);
     }
 
     if (! ns_.empty()) {
@@ -658,9 +1997,17 @@ void CodeGen::generate(const ValidSchema& schema)
     unionNumber_ = 0;
 
     generateTraits(root);
+    generateBinaryTraits(root);
+    if (compare_) {
+        generateHashTraits(root);
+    }
+    generateSchemaTraits(schema, json);
 
     os_ << "}\n";
 
+    generateHashValues();
+    generateDecodeOnly(root);
+
     os_ << "#endif\n";
     os_.flush();
 
@@ -673,6 +2020,10 @@ static const string OUT("output");
 static const string IN("input");
 static const string INCLUDE_PREFIX("include-prefix");
 static const string NO_UNION_TYPEDEF("no-union-typedef");
+static const string BINARY_CODEC("binary-codec");
+static const string COMPARE("compare");
+static const string VIEWS("views");
+static const string DECODE_ONLY("decode-only");
 
 static string readGuard(const string& filename)
 {
@@ -704,6 +2055,17 @@ int main(int argc, char** argv)
         ("include-prefix,p", po::value<string>()->default_value("avro"),
             "prefix for include headers, - for none, default: avro")
         ("no-union-typedef,U", "do not generate typedefs for unions in records")
+        ("binary-codec,b", "also generate encoders and decoders that work "
+            "directly on memory in Avro binary format; encodedSize() is "
+            "generated either way")
+        ("compare,c", "also generate operator==, operator< and avro::hash "
+            "support that follow the Avro sort order")
+        ("views", "use avro::StringView and avro::BytesView for strings and "
+            "bytes, so that they can be decoded without copying")
+        ("decode-only,d", po::value<vector<string> >(),
+            "generate decodeOnly_<name> that decodes only the given fields "
+            "of the top-level record, as name=field[,field...]; "
+            "nested fields are written as a.b")
         ("namespace,n", po::value<string>(), "set namespace for generated code")
         ("input,i", po::value<string>(), "input file")
         ("output,o", po::value<string>(), "output file to generate");
@@ -723,6 +2085,11 @@ int main(int argc, char** argv)
     string inf = vm.count(IN) > 0 ? vm[IN].as<string>() : string();
     string incPrefix = vm[INCLUDE_PREFIX].as<string>();
     bool noUnion = vm.count(NO_UNION_TYPEDEF) != 0;
+    bool binaryCodec = vm.count(BINARY_CODEC) != 0;
+    bool compare = vm.count(COMPARE) != 0;
+    bool views = vm.count(VIEWS) != 0;
+    vector<string> decodeOnly = vm.count(DECODE_ONLY) > 0 ?
+        vm[DECODE_ONLY].as<vector<string> >() : vector<string>();
     if (incPrefix == "-") {
         incPrefix.clear();
     } else if (*incPrefix.rbegin() != '/') {
@@ -730,22 +2097,24 @@ int main(int argc, char** argv)
     }
 
     try {
-        ValidSchema schema;
-
+        std::ostringstream text;
         if (! inf.empty()) {
             ifstream in(inf.c_str());
-            compileJsonSchema(in, schema);
+            text << in.rdbuf();
         } else {
-            compileJsonSchema(std::cin, schema);
+            text << std::cin.rdbuf();
         }
+        const string json = text.str();
+        ValidSchema schema = avro::compileJsonSchemaFromString(json);
 
         if (! outf.empty()) {
             string g = readGuard(outf);
             ofstream out(outf.c_str());
-            CodeGen(out, ns, inf, outf, g, incPrefix, noUnion).generate(schema);
+            CodeGen(out, ns, inf, outf, g, incPrefix, noUnion,
+                binaryCodec, compare, views, decodeOnly).generate(schema, json);
         } else {
-            CodeGen(std::cout, ns, inf, outf, "", incPrefix, noUnion).
-                generate(schema);
+            CodeGen(std::cout, ns, inf, outf, "", incPrefix, noUnion,
+                binaryCodec, compare, views, decodeOnly).generate(schema, json);
         }
         return 0;
     } catch (std::exception &e) {
@@ -18,6 +18,17 @@
 
 #include "JsonIO.hh"
 
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define AVRO_JSON_SSE2 1
+#else
+#define AVRO_JSON_SSE2 0
+#endif
+
 namespace avro {
 namespace json {
 
@@ -34,31 +45,124 @@ JsonParser::tokenNames[] = {
     "Object end",
 };
 
+/*
+ * The scanners below look for the next byte of interest in [p, end) and
+ * return end if there is none. With SSE2 they look at 16 bytes at a time.
+ */
+
+static inline bool isWhite(uint8_t c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * Skips whitespace.
+ */
+static const uint8_t* skipWhitespace(const uint8_t* p, const uint8_t* end)
+{
+    // Most tokens are not preceded by whitespace at all, or by one space.
+    while (p != end && isWhite(*p)) {
+        ++p;
+#if AVRO_JSON_SSE2
+        // A longer run is likely indentation.
+        while (end - p >= 16) {
+            const __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i w = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                    _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+            const int mask = _mm_movemask_epi8(w) ^ 0xffff;
+            if (mask != 0) {
+                p += __builtin_ctz(mask);
+                break;
+            }
+            p += 16;
+        }
+#endif
+    }
+    return p;
+}
+
+/**
+ * Finds the closing quote or next backslash in the body of a string.
+ * Control characters are not special: like before, the parser accepts them
+ * raw.
+ */
+static const uint8_t* scanString(const uint8_t* p, const uint8_t* end)
+{
+#if AVRO_JSON_SSE2
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p != end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+static inline bool isNumberChar(uint8_t c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+        c == 'e' || c == 'E';
+}
+
+/**
+ * Finds the end of the characters that can make up a number.
+ */
+static const uint8_t* scanNumber(const uint8_t* p, const uint8_t* end)
+{
+    while (p != end && isNumberChar(*p)) {
+        ++p;
+    }
+    return p;
+}
+
 char JsonParser::next()
 {
-    char ch = hasNext ? nextChar : ' ';
-    while (isspace(ch)) {
-        ch = in_.read();
+    if (hasNext) {
+        hasNext = false;
+        if (! isWhite(nextChar)) {
+            return nextChar;
+        }
+    }
+    for (; ;) {
+        if (in_.next_ == in_.end_) {
+            in_.more();
+        }
+        const uint8_t* p = skipWhitespace(in_.next_, in_.end_);
+        if (p != in_.end_) {
+            in_.next_ = p + 1;
+            return *p;
+        }
+        in_.next_ = p;
     }
-    hasNext = false;
-    return ch;
 }
 
 JsonParser::Token JsonParser::doAdvance()
 {
     char ch = next();
     if (ch == ']') {
-        if (curState == stArray0 || stArrayN) {
-            curState = stateStack.top();
-            stateStack.pop();
+        if (! stateStack.empty() && (curState == stArray0 || curState == stArrayN)) {
+            curState = stateStack.back();
+            stateStack.pop_back();
             return tkArrayEnd;
         } else {
             throw unexpected(ch);
         }
     } else if (ch == '}') {
-        if (curState == stObject0 || stObjectN) {
-            curState = stateStack.top();
-            stateStack.pop();
+        if (! stateStack.empty() && (curState == stObject0 || curState == stObjectN)) {
+            curState = stateStack.back();
+            stateStack.pop_back();
             return tkObjectEnd;
         } else {
             throw unexpected(ch);
@@ -90,11 +194,11 @@ JsonParser::Token JsonParser::doAdvance()
 
     switch (ch) {
     case '[':
-        stateStack.push(curState);
+        stateStack.push_back(curState);
         curState = stArray0;
         return tkArrayStart;
     case '{':
-        stateStack.push(curState);
+        stateStack.push_back(curState);
         curState = stObject0;
         return tkObjectStart;
     case '"':
@@ -118,120 +222,145 @@ JsonParser::Token JsonParser::doAdvance()
 
 JsonParser::Token JsonParser::tryNumber(char ch)
 {
-    sv.clear();
-    sv.push_back(ch);
+    if (in_.next_ == in_.end_) {
+        in_.fill();
+    }
+    const uint8_t* b = in_.next_;
+    const uint8_t* p = scanNumber(b, in_.end_);
+    if (p != in_.end_) {
+        // The whole number is in this chunk: parse it where it is.
+        in_.next_ = p;
+        return parseNumber(ch, reinterpret_cast<const char*>(b),
+            reinterpret_cast<const char*>(p));
+    }
 
-    hasNext = false;
-    int state = (ch == '-') ? 0 : (ch == 0) ? 1 : 2;
+    // The number may continue in the next chunk.
+    sv.assign(1, ch);
     for (; ;) {
-        switch (state) {
-        case 0:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (isdigit(ch)) {
-                    state = (ch == 0) ? 1 : 2;
-                    sv.push_back(ch);
-                    continue;
-                }
-                hasNext = true;
-            }
-            break;
-        case 1:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (ch == '.') {
-                    state = 3;
-                    sv.push_back(ch);
-                    continue;
-                }
-                hasNext = true;
-            }
-            break;
-        case 2:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (isdigit(ch)) {
-                    sv.push_back(ch);
-                    continue;
-                } else if (ch == '.') {
-                    state = 3;
-                    sv.push_back(ch);
-                    continue;
-                }
-                hasNext = true;
-            }
+        sv.append(reinterpret_cast<const char*>(b), p - b);
+        in_.next_ = p;
+        if (! in_.fill()) {
             break;
-        case 3:
-        case 6:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (isdigit(ch)) {
-                    sv.push_back(ch);
-                    state++;
-                    continue;
-                }
-                hasNext = true;
-            }
-            break;
-        case 4:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (isdigit(ch)) {
-                    sv.push_back(ch);
-                    continue;
-                } else if (ch == 'e' || ch == 'E') {
-                    sv.push_back(ch);
-                    state = 5;
-                    continue;
-                }
-                hasNext = true;
-            }
-            break;
-        case 5:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (ch == '+' || ch == '-') {
-                    sv.push_back(ch);
-                    state = 6;
-                    continue;
-                } else if (isdigit(ch)) {
-                    sv.push_back(ch);
-                    state = 7;
-                    continue;
-                }
-                hasNext = true;
-            }
-            break;
-        case 7:
-            if (in_.hasMore()) {
-                ch = in_.read();
-                if (isdigit(ch)) {
-                    sv.push_back(ch);
-                    continue;
-                }
-                hasNext = true;
-            }
+        }
+        b = in_.next_;
+        p = scanNumber(b, in_.end_);
+        if (p != in_.end_) {
+            in_.next_ = p;
+            sv.append(reinterpret_cast<const char*>(b), p - b);
             break;
         }
-        if (state == 1 || state == 2 || state == 4 || state == 7) {
-            if (hasNext) {
-                nextChar = ch;
-            }
-            std::istringstream iss(sv);
-            if (state == 1 || state == 2) {
-                iss >> lv;
-                return tkLong;
-            } else {
-                iss >> dv;
-                return tkDouble;
+    }
+    return parseNumber(sv[0], sv.data() + 1, sv.data() + sv.size());
+}
+
+static const double powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Parses the number whose first character is ch and whose others are
+ * [b, e). Integers of up to 18 digits, and decimals with up to 15
+ * significant digits and a small enough exponent, are exactly
+ * representable on the way, so they are computed directly. Anything else
+ * is left to the standard library, to round correctly.
+ */
+JsonParser::Token JsonParser::parseNumber(char ch, const char* b,
+    const char* e)
+{
+    const bool negative = (ch == '-');
+    const char* p = b;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    if (! negative) {
+        mantissa = ch - '0';
+        digits = 1;
+    }
+    for (; p != e && isdigit(*p); ++p, ++digits) {
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    bool isDouble = false;
+    int exponent = 0;
+    if (digits > 0 && p != e && *p == '.') {
+        isDouble = true;
+        const char* f = ++p;
+        for (; p != e && isdigit(*p); ++p, ++digits) {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        exponent -= p - f;
+        if (p == f) {
+            digits = 0;
+        }
+    }
+    if (digits > 0 && p != e && (*p == 'e' || *p == 'E')) {
+        isDouble = true;
+        ++p;
+        const bool negativeExponent = (p != e && *p == '-');
+        if (p != e && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+        const char* f = p;
+        int x = 0;
+        for (; p != e && isdigit(*p); ++p) {
+            if (x < 100000) {
+                x = x * 10 + (*p - '0');
             }
+        }
+        if (p == f) {
+            digits = 0;
+        }
+        exponent += negativeExponent ? -x : x;
+    }
+
+    if (digits == 0 || p != e) {
+        // Point at the offending character, which may be the one after the
+        // number.
+        if (p != e) {
+            throw unexpected(*p);
+        } else if (in_.hasMore()) {
+            throw unexpected(*in_.next_);
         } else {
-            if (hasNext) {
-                throw unexpected(ch);
-            } else {
-                throw Exception("Unexpected EOF");
-            }
+            throw Exception("Unexpected EOF");
+        }
+    }
+
+    if (! isDouble) {
+        if (digits <= 18) {
+            lv = negative ? -static_cast<int64_t>(mantissa) :
+                static_cast<int64_t>(mantissa);
+            return tkLong;
+        }
+    } else if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+        dv = static_cast<double>(mantissa);
+        dv = exponent < 0 ? dv / powersOf10[-exponent] :
+            dv * powersOf10[exponent];
+        if (negative) {
+            dv = -dv;
         }
+        return tkDouble;
+    }
+
+    // strtod() is much faster than a stream, but it follows the C locale,
+    // so it is only used when that agrees with JSON on the decimal point.
+    char buf[64];
+    if (isDouble && static_cast<size_t>(e - b) < sizeof(buf) - 1 &&
+        *localeconv()->decimal_point == '.') {
+        buf[0] = ch;
+        ::memcpy(buf + 1, b, e - b);
+        buf[e - b + 1] = 0;
+        dv = ::strtod(buf, 0);
+        return tkDouble;
+    }
+
+    std::string text(1, ch);
+    text.append(b, e);
+    std::istringstream iss(text);
+    if (isDouble) {
+        iss >> dv;
+        return tkDouble;
+    } else {
+        iss >> lv;
+        return tkLong;
     }
 }
 
@@ -276,10 +405,21 @@ JsonParser::Token JsonParser::tryString()
 {
     sv.clear();
     for ( ; ;) {
+        // Copy everything up to the next quote or backslash in one go.
+        if (in_.next_ == in_.end_) {
+            in_.more();
+        }
+        const uint8_t* b = in_.next_;
+        const uint8_t* p = scanString(b, in_.end_);
+        sv.append(reinterpret_cast<const char*>(b), p - b);
+        in_.next_ = p;
+        if (p == in_.end_) {
+            continue;
+        }
         char ch = in_.read();
         if (ch == '"') {
             return tkString;
-        } else if (ch == '\\') {
+        } else {
             ch = in_.read();
             switch (ch) {
             case '"':
@@ -353,8 +493,6 @@ JsonParser::Token JsonParser::tryString()
             default:
                 throw unexpected(ch);
             }
-        } else {
-            sv.push_back(ch);
         }
     }
 }
@@ -385,6 +523,537 @@ JsonParser::Token JsonParser::tryLiteral(const char exp[], size_t n, Token tk)
     return tk;
 }
 
+
+/*
+ * Number formatting for JsonGenerator.
+ */
+
+namespace {
+
+const char digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int countDigits(uint64_t v)
+{
+    int n = 1;
+    for (; ;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+/**
+ * Writes the decimal digits of v at b and returns their number.
+ */
+int formatUnsigned(uint64_t v, char* b)
+{
+    const int n = countDigits(v);
+    char* p = b + n;
+    while (v >= 100) {
+        const unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        *--p = digitPairs[i + 1];
+        *--p = digitPairs[i];
+    }
+    if (v >= 10) {
+        const unsigned i = static_cast<unsigned>(v) * 2;
+        *--p = digitPairs[i + 1];
+        *--p = digitPairs[i];
+    } else {
+        *--p = static_cast<char>('0' + v);
+    }
+    return n;
 }
+
+int formatSigned(int64_t v, char* b)
+{
+    if (v < 0) {
+        *b = '-';
+        return 1 + formatUnsigned(0 - static_cast<uint64_t>(v), b + 1);
+    }
+    return formatUnsigned(static_cast<uint64_t>(v), b);
 }
 
+/*
+ * Shortest round-trip formatting of floating point numbers with the Grisu2
+ * algorithm of Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers" (PLDI 2010). The digits it produces always read
+ * back as the same number, and are the shortest such digits in all but a
+ * tiny fraction of cases.
+ */
+
+/**
+ * A floating point number f * 2^e with a 64-bit significand.
+ */
+struct DiyFp {
+    uint64_t f;
+    int e;
+
+    DiyFp() : f(0), e(0) { }
+    DiyFp(uint64_t f, int e) : f(f), e(e) { }
+
+    DiyFp operator-(const DiyFp& rhs) const {
+        return DiyFp(f - rhs.f, e);
+    }
+
+    /**
+     * The product, rounded to 64 bits.
+     */
+    DiyFp operator*(const DiyFp& rhs) const {
+        const uint64_t m32 = 0xffffffffULL;
+        const uint64_t a = f >> 32;
+        const uint64_t b = f & m32;
+        const uint64_t c = rhs.f >> 32;
+        const uint64_t d = rhs.f & m32;
+        const uint64_t ac = a * c;
+        const uint64_t bc = b * c;
+        const uint64_t ad = a * d;
+        const uint64_t bd = b * d;
+        uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+        tmp += 1U << 31;
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+            e + rhs.e + 64);
+    }
+
+    DiyFp normalize() const {
+        DiyFp r = *this;
+        while ((r.f & (1ULL << 63)) == 0) {
+            r.f <<= 1;
+            r.e--;
+        }
+        return r;
+    }
+};
+
+/**
+ * Normalized 64-bit approximations of 10^k for k = -348, -340, ..., 340,
+ * rounded to nearest. They are computed exactly, with a small big integer,
+ * the first time a number is formatted.
+ */
+struct CachedPowers {
+    enum { count = 87 };
+    DiyFp powers[count];
+
+    CachedPowers() {
+        for (int i = 0; i < count; ++i) {
+            const int k = -348 + 8 * i;
+            std::vector<uint32_t> n;
+            int shift = 0;
+            if (k >= 0) {
+                n.push_back(1);
+                for (int j = 0; j < k; ++j) {
+                    multiply(n, 10);
+                }
+            } else {
+                // floor(2^shift / 10^-k), with 64 bits to spare.
+                shift = -k * 10 / 3 + 1 + 128;
+                n.assign(shift / 32 + 1, 0);
+                n.back() = 1U << (shift % 32);
+                for (int j = 0; j < -k; ++j) {
+                    divide(n, 10);
+                }
+            }
+            powers[i] = top64(n, shift);
+        }
+    }
+
+    static void multiply(std::vector<uint32_t>& n, uint32_t m) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n.size(); ++i) {
+            carry += static_cast<uint64_t>(n[i]) * m;
+            n[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) {
+            n.push_back(static_cast<uint32_t>(carry));
+        }
+    }
+
+    static void divide(std::vector<uint32_t>& n, uint32_t d) {
+        uint64_t rem = 0;
+        for (size_t i = n.size(); i-- > 0; ) {
+            rem = (rem << 32) | n[i];
+            n[i] = static_cast<uint32_t>(rem / d);
+            rem %= d;
+        }
+        while (n.size() > 1 && n.back() == 0) {
+            n.pop_back();
+        }
+    }
+
+    static bool bit(const std::vector<uint32_t>& n, int i) {
+        return i >= 0 && ((n[i / 32] >> (i % 32)) & 1) != 0;
+    }
+
+    /**
+     * Returns n / 2^shift rounded to a normalized DiyFp.
+     */
+    static DiyFp top64(const std::vector<uint32_t>& n, int shift) {
+        int bits = static_cast<int>(n.size()) * 32;
+        while (! bit(n, bits - 1)) {
+            --bits;
+        }
+        uint64_t f = 0;
+        for (int i = bits - 1; i >= bits - 64; --i) {
+            f = (f << 1) | (bit(n, i) ? 1 : 0);
+        }
+        int e = bits - 64 - shift;
+        if (bit(n, bits - 65)) {
+            if (++f == 0) {
+                f = 1ULL << 63;
+                ++e;
+            }
+        }
+        return DiyFp(f, e);
+    }
+};
+
+/**
+ * Returns a cached power c = 10^-K such that multiplying by it brings a
+ * number with binary exponent e into the range Grisu works in.
+ */
+DiyFp cachedPower(int e, int& K)
+{
+    static const CachedPowers t;
+    const double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0) {
+        k++;
+    }
+    const unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    K = -(-348 + static_cast<int>(index << 3));
+    return t.powers[index];
+}
+
+const uint32_t powersOf10_32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+void grisuRound(char* buffer, int len, uint64_t delta, uint64_t rest,
+    uint64_t tenKappa, uint64_t wpw)
+{
+    while (rest < wpw && delta - rest >= tenKappa &&
+        (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+        buffer[len - 1]--;
+        rest += tenKappa;
+    }
+}
+
+void digitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta,
+    char* buffer, int& len, int& K)
+{
+    const DiyFp one(1ULL << -Mp.e, Mp.e);
+    const DiyFp wpw = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = countDigits(p1);
+    len = 0;
+    while (kappa > 0) {
+        const uint32_t div = powersOf10_32[kappa - 1];
+        const uint32_t d = p1 / div;
+        p1 %= div;
+        if (d != 0 || len != 0) {
+            buffer[len++] = static_cast<char>('0' + d);
+        }
+        kappa--;
+        const uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            K += kappa;
+            grisuRound(buffer, len, delta, rest,
+                static_cast<uint64_t>(powersOf10_32[kappa]) << -one.e,
+                wpw.f);
+            return;
+        }
+    }
+    for (; ;) {
+        p2 *= 10;
+        delta *= 10;
+        const char d = static_cast<char>(p2 >> -one.e);
+        if (d != 0 || len != 0) {
+            buffer[len++] = static_cast<char>('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            K += kappa;
+            grisuRound(buffer, len, delta, p2, one.f,
+                -kappa < 10 ? wpw.f * powersOf10_32[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+/**
+ * Produces the shortest digits for the positive number f * 2^e whose
+ * significand has the given number of bits, such that digits * 10^K
+ * reads back as the number.
+ */
+void grisu2(uint64_t f, int e, int significandBits, char* buffer, int& len,
+    int& K)
+{
+    const DiyFp v(f, e);
+    const DiyFp plus = DiyFp((f << 1) + 1, e - 1).normalize();
+    DiyFp minus = (f == (1ULL << (significandBits - 1))) ?
+        DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const DiyFp c = cachedPower(plus.e, K);
+    const DiyFp W = v.normalize() * c;
+    DiyFp Wp = plus * c;
+    DiyFp Wm = minus * c;
+    Wm.f++;
+    Wp.f--;
+    digitGen(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+/**
+ * Lays out the len digits at b, which stand for digits * 10^K, as a JSON
+ * number and returns its length. Numbers from 1e-7 up to 1e21 are written
+ * without an exponent, like JavaScript does, except that whole numbers
+ * only go without one while they fit in a long: readers, this one
+ * included, take a number without a point or an exponent for a long.
+ * b must have room for 26 characters.
+ */
+int prettify(char* b, int len, int K)
+{
+    const int kk = len + K;     // 10^(kk - 1) <= v < 10^kk
+    if (K >= 0 && kk <= 18) {
+        // 1234e7 -> 12340000000
+        for (int i = len; i < kk; i++) {
+            b[i] = '0';
+        }
+        return kk;
+    } else if (K < 0 && 0 < kk && kk <= 21) {
+        // 1234e-2 -> 12.34
+        ::memmove(b + kk + 1, b + kk, len - kk);
+        b[kk] = '.';
+        return len + 1;
+    } else if (-6 < kk && kk <= 0) {
+        // 1234e-6 -> 0.001234
+        const int offset = 2 - kk;
+        ::memmove(b + offset, b, len);
+        b[0] = '0';
+        b[1] = '.';
+        for (int i = 2; i < offset; i++) {
+            b[i] = '0';
+        }
+        return len + offset;
+    } else {
+        // 1234e30 -> 1.234e+33
+        int n = len;
+        if (len > 1) {
+            ::memmove(b + 2, b + 1, len - 1);
+            b[1] = '.';
+            n++;
+        }
+        b[n++] = 'e';
+        const int x = kk - 1;
+        b[n++] = x < 0 ? '-' : '+';
+        return n + formatUnsigned(x < 0 ? -x : x, b + n);
+    }
+}
+
+/**
+ * Writes a floating point number with the given sign, significand and
+ * exponent at b and returns its length. b must have room for 32
+ * characters.
+ */
+int formatFloating(bool negative, uint64_t f, int e, int significandBits,
+    char* b)
+{
+    char* p = b;
+    if (negative) {
+        *p++ = '-';
+    }
+    if (f == 0) {
+        // "-0" would read back as the integer 0, losing the sign.
+        const char* z = negative ? "0.0" : "0";
+        const int n = static_cast<int>(::strlen(z));
+        ::memcpy(p, z, n);
+        return (p - b) + n;
+    }
+    int len;
+    int K;
+    grisu2(f, e, significandBits, p, len, K);
+    return (p - b) + prettify(p, len, K);
+}
+
+/**
+ * Writes infinities and NaNs the way iostreams do, for want of a JSON way.
+ */
+int formatSpecial(bool negative, bool nan, char* b)
+{
+    const char* s = nan ? "nan" : (negative ? "-inf" : "inf");
+    const int n = static_cast<int>(::strlen(s));
+    ::memcpy(b, s, n);
+    return n;
+}
+
+int formatDouble(double d, char* b)
+{
+    uint64_t u;
+    ::memcpy(&u, &d, sizeof(u));
+    const bool negative = (u >> 63) != 0;
+    const int biased = static_cast<int>((u >> 52) & 0x7ff);
+    const uint64_t significand = u & ((1ULL << 52) - 1);
+    if (biased == 0x7ff) {
+        return formatSpecial(negative, significand != 0, b);
+    } else if (biased == 0) {
+        return formatFloating(negative, significand, -1074, 53, b);
+    } else {
+        return formatFloating(negative, significand | (1ULL << 52),
+            biased - 1075, 53, b);
+    }
+}
+
+int formatFloat(float x, char* b)
+{
+    uint32_t u;
+    ::memcpy(&u, &x, sizeof(u));
+    const bool negative = (u >> 31) != 0;
+    const int biased = static_cast<int>((u >> 23) & 0xff);
+    const uint32_t significand = u & ((1U << 23) - 1);
+    if (biased == 0xff) {
+        return formatSpecial(negative, significand != 0, b);
+    } else if (biased == 0) {
+        return formatFloating(negative, significand, -149, 24, b);
+    } else {
+        return formatFloating(negative, significand | (1U << 23),
+            biased - 150, 24, b);
+    }
+}
+
+/**
+ * Whether c must be escaped in a JSON string. This matches what the
+ * generator always did: quotes, backslashes, slashes and ASCII control
+ * characters.
+ */
+inline bool needsEscape(uint8_t c)
+{
+    return c < 0x20 || c == '"' || c == '\\' || c == '/' || c == 0x7f;
+}
+
+/**
+ * Finds the first character at or after p that must be escaped.
+ */
+const uint8_t* scanEscape(const uint8_t* p, const uint8_t* end)
+{
+#if AVRO_JSON_SSE2
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)),
+            v);
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(ctl, special));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p != end && ! needsEscape(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+}   // namespace
+
+template <typename F, typename T>
+void JsonGenerator::writeNumber(F format, T t)
+{
+    sep();
+    // Format straight into the output window when there is room.
+    if (out_.end_ - out_.next_ >= maxNumberLength) {
+        out_.next_ += format(t, reinterpret_cast<char*>(out_.next_));
+    } else {
+        char buf[maxNumberLength];
+        write(buf, buf + format(t, buf));
+    }
+    sep2();
+}
+
+void JsonGenerator::encodeNumber(int32_t i)
+{
+    writeNumber(formatSigned, static_cast<int64_t>(i));
+}
+
+void JsonGenerator::encodeNumber(int64_t l)
+{
+    writeNumber(formatSigned, l);
+}
+
+void JsonGenerator::encodeNumber(float f)
+{
+    writeNumber(formatFloat, f);
+}
+
+void JsonGenerator::encodeNumber(double d)
+{
+    writeNumber(formatDouble, d);
+}
+
+void JsonGenerator::doEncodeString(const std::string& s)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(s.data());
+    const uint8_t* e = b + s.size();
+    out_.write('"');
+    for (; ;) {
+        // Copy the run that needs no escaping in one go.
+        const uint8_t* p = scanEscape(b, e);
+        write(reinterpret_cast<const char*>(b),
+            reinterpret_cast<const char*>(p));
+        if (p == e) {
+            break;
+        }
+        switch (*p) {
+        case '\b':
+            escape('b');
+            break;
+        case '\f':
+            escape('f');
+            break;
+        case '\n':
+            escape('n');
+            break;
+        case '\r':
+            escape('r');
+            break;
+        case '\t':
+            escape('t');
+            break;
+        case '\\':
+        case '"':
+        case '/':
+            escape(*p);
+            break;
+        default:
+            escapeCtl(*p);
+            break;
+        }
+        b = p + 1;
+    }
+    out_.write('"');
+}
+
+}
+}
@@ -21,6 +21,7 @@
 
 #include <stack>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <boost/utility.hpp>
 
@@ -59,7 +60,7 @@ private:
         stObjectN,  // Expect a ',' or '}'
         stKey       // Expect a ':'
     };
-    std::stack<State> stateStack;
+    std::vector<State> stateStack;
     State curState;
     bool hasNext;
     char nextChar;
@@ -75,6 +76,7 @@ private:
     Token doAdvance();
     Token tryLiteral(const char exp[], size_t n, Token tk);
     Token tryNumber(char ch);
+    Token parseNumber(char ch, const char* b, const char* e);
     bool decodeHexQuad(unichar &quad);
     Token tryString();
     Exception unexpected(unsigned char ch);
@@ -84,7 +86,22 @@ public:
     JsonParser() : curState(stValue), hasNext(false), peeked(false) { }
 
     void init(InputStream& is) {
+        // Forget where in a value a previous input, perhaps one that
+        // failed, left off.
         in_.reset(is);
+        stateStack.clear();
+        curState = stValue;
+        hasNext = false;
+        peeked = false;
+    }
+
+    /**
+     * Returns to the stream whatever the parser has read past the end of
+     * the value just parsed, so that the stream can be read on from there.
+     */
+    void drain() {
+        in_.drain(hasNext);
+        hasNext = false;
     }
 
     Token advance() {
@@ -120,7 +137,7 @@ public:
         return lv;
     }
 
-    std::string stringValue() {
+    const std::string& stringValue() {
         return sv;
     }
 
@@ -151,60 +168,24 @@ class AVRO_DECL JsonGenerator {
         }
     }
 
-    void escape(char c, const char* b, const char *p) {
-        write(b, p);
-        out_.write('\\');
-        out_.write(c);
+    void escape(char c) {
+        const char buf[2] = { '\\', c };
+        write(buf, buf + 2);
     }
 
     void escapeCtl(char c) {
-        out_.write('\\');
-        out_.write('U');
-        out_.write('0');
-        out_.write('0');
-        out_.write(toHex((static_cast<unsigned char>(c)) / 16));
-        out_.write(toHex((static_cast<unsigned char>(c)) % 16));
+        const char buf[6] = { '\\', 'U', '0', '0',
+            toHex((static_cast<unsigned char>(c)) / 16),
+            toHex((static_cast<unsigned char>(c)) % 16) };
+        write(buf, buf + 6);
     }
 
-    void doEncodeString(const std::string& s) {
-        const char* b = &s[0];
-        const char* e = b + s.size();
-        out_.write('"');
-        for (const char* p = b; p != e; p++) {
-            switch (*p) {
-            case '\\':
-            case '"':
-            case '/':
-                escape(*p, b, p);
-                break;
-            case '\b':
-                escape('b', b, p);
-                break;
-            case '\f':
-                escape('f', b, p);
-                break;
-            case '\n':
-                escape('n', b, p);
-                break;
-            case '\r':
-                escape('r', b, p);
-                break;
-            case '\t':
-                escape('t', b, p);
-                break;
-            default:
-                if (! iscntrl(*p)) {
-                    continue;
-                }
-                write(b, p);
-                escapeCtl(*p);
-                break;
-            }
-            b = p + 1;
-        }
-        write(b, e);
-        out_.write('"');
-    }
+    void doEncodeString(const std::string& s);
+
+    enum { maxNumberLength = 32 };
+
+    template <typename F, typename T>
+    void writeNumber(F format, T t);
 
     void sep() {
         if (top == stArrayN) {
@@ -247,6 +228,26 @@ public:
         sep2();
     }
 
+    /**
+     * Writes an integer.
+     */
+    void encodeNumber(int32_t i);
+
+    /**
+     * Writes an integer.
+     */
+    void encodeNumber(int64_t l);
+
+    /**
+     * Writes the shortest decimal that reads back as the same float.
+     */
+    void encodeNumber(float f);
+
+    /**
+     * Writes the shortest decimal that reads back as the same double.
+     */
+    void encodeNumber(double d);
+
     template <typename T>
     void encodeNumber(T t) {
         sep();
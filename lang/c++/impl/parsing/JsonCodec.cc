@@ -54,23 +54,23 @@ using avro::json::JsonParser;
 using avro::json::JsonGenerator;
 
 class JsonGrammarGenerator : public ValidatingGrammarGenerator {
-    Production doGenerate(const NodePtr& n,
-        std::map<NodePtr, boost::shared_ptr<Production> > &m);
+    Production doGenerate(const SchemaTable& t, size_t n,
+        std::map<size_t, boost::shared_ptr<Production> > &m);
 };
 
-static std::string nameOf(const NodePtr& n)
+static std::string nameOf(const SchemaTable& t, size_t n)
 {
-    if (n->hasName()) {
-        return n->name();
+    if (t.hasName(n)) {
+        return t.name(n);
     }
     std::ostringstream oss;
-    oss << n->type();
+    oss << t.type(n);
     return oss.str();
 }
 
-Production JsonGrammarGenerator::doGenerate(const NodePtr& n,
-    std::map<NodePtr, boost::shared_ptr<Production> > &m) {
-    switch (n->type()) {
+Production JsonGrammarGenerator::doGenerate(const SchemaTable& t, size_t n,
+    std::map<size_t, boost::shared_ptr<Production> > &m) {
+    switch (t.type(n)) {
     case AVRO_NULL:
     case AVRO_BOOL:
     case AVRO_INT:
@@ -83,20 +83,19 @@ Production JsonGrammarGenerator::doGenerate(const NodePtr& n,
     case AVRO_ARRAY:
     case AVRO_MAP:
     case AVRO_SYMBOLIC:
-        return ValidatingGrammarGenerator::doGenerate(n, m);
+        return ValidatingGrammarGenerator::doGenerate(t, n, m);
     case AVRO_RECORD:
         {
             Production result;
 
             m.erase(n);
 
-            size_t c = n->leaves();
+            size_t c = t.leaves(n);
             result.reserve(2 + 2 * c);
             result.push_back(Symbol::recordStartSymbol());
             for (size_t i = 0; i < c; ++i) {
-                const NodePtr& leaf = n->leafAt(i);
-                Production v = doGenerate(leaf, m);
-                result.push_back(Symbol::fieldSymbol(n->nameAt(i)));
+                Production v = doGenerate(t, t.leafAt(n, i), m);
+                result.push_back(Symbol::fieldSymbol(t.nameAt(n, i)));
                 copy(v.rbegin(), v.rend(), back_inserter(result));
             }
             result.push_back(Symbol::recordEndSymbol());
@@ -112,10 +111,10 @@ Production JsonGrammarGenerator::doGenerate(const NodePtr& n,
     case AVRO_ENUM:
         {
             vector<string> nn;
-            size_t c = n->names();
+            size_t c = t.names(n);
             nn.reserve(c);
             for (size_t i = 0; i < c; ++i) {
-                nn.push_back(n->nameAt(i));
+                nn.push_back(t.nameAt(n, i));
             }
             Symbol r[] = {
                 Symbol::nameListSymbol(nn),
@@ -126,7 +125,7 @@ Production JsonGrammarGenerator::doGenerate(const NodePtr& n,
         }
     case AVRO_UNION:
         {
-            size_t c = n->leaves();
+            size_t c = t.leaves(n);
 
             vector<Production> vv;
             vv.reserve(c);
@@ -135,16 +134,16 @@ Production JsonGrammarGenerator::doGenerate(const NodePtr& n,
             names.reserve(c);
 
             for (size_t i = 0; i < c; ++i) {
-                const NodePtr& nn = n->leafAt(i);
-                Production v = doGenerate(nn, m);
-                if (nn->type() != AVRO_NULL) {
+                size_t nn = t.leafAt(n, i);
+                Production v = doGenerate(t, nn, m);
+                if (t.type(nn) != AVRO_NULL) {
                     Production v2;
                     v2.push_back(Symbol::recordEndSymbol());
                     copy(v.begin(), v.end(), back_inserter(v2));
                     v.swap(v2);
                 }
                 vv.push_back(v);
-                names.push_back(nameOf(nn));
+                names.push_back(nameOf(t, nn));
             }
             Symbol r[] = {
                 Symbol::alternative(vv),
@@ -199,6 +198,7 @@ class JsonDecoder : public Decoder {
     JsonParser in_;
     JsonDecoderHandler handler_;
     P parser_;
+    Arena arena_;
 
     void init(InputStream& is);
     void decodeNull();
@@ -209,8 +209,10 @@ class JsonDecoder : public Decoder {
     double decodeDouble();
     void decodeString(string& value);
     void skipString();
+    void decodeStringView(StringView& value);
     void decodeBytes(vector<uint8_t>& value);
     void skipBytes();
+    void decodeBytesView(BytesView& value);
     void decodeFixed(size_t n, vector<uint8_t>& value);
     void skipFixed(size_t n);
     size_t decodeEnum();
@@ -238,6 +240,7 @@ template <typename P>
 void JsonDecoder<P>::init(InputStream& is)
 {
     in_.init(is);
+    arena_.clear();
 }
 
 template <typename P>
@@ -332,6 +335,16 @@ void JsonDecoder<P>::skipString()
     expect(JsonParser::tkString);
 }
 
+template <typename P>
+void JsonDecoder<P>::decodeStringView(StringView& value)
+{
+    parser_.advance(Symbol::sString);
+    expect(JsonParser::tkString);
+    const string& s = in_.stringValue();
+    value = StringView(reinterpret_cast<const char*>(arena_.copy(
+        reinterpret_cast<const uint8_t*>(s.data()), s.size())), s.size());
+}
+
 static vector<uint8_t> toBytes(const string& s)
 {
     return vector<uint8_t>(s.begin(), s.end());
@@ -352,6 +365,16 @@ void JsonDecoder<P>::skipBytes()
     expect(JsonParser::tkString);
 }
 
+template <typename P>
+void JsonDecoder<P>::decodeBytesView(BytesView& value)
+{
+    parser_.advance(Symbol::sBytes);
+    expect(JsonParser::tkString);
+    const string& s = in_.stringValue();
+    value = BytesView(arena_.copy(
+        reinterpret_cast<const uint8_t*>(s.data()), s.size()), s.size());
+}
+
 template <typename P>
 void JsonDecoder<P>::decodeFixed(size_t n, vector<uint8_t>& value)
 {
@@ -686,7 +709,7 @@ void JsonEncoder<P>::encodeUnionIndex(size_t e)
 {
     parser_.advance(Symbol::sUnion);
 
-    const std::string name = parser_.nameForIndex(e);
+    const std::string& name = parser_.nameForIndex(e);
 
     if (name != "null") {
         out_.objectStart();
@@ -54,52 +54,47 @@ using std::reverse;
 using std::ostringstream;
 using std::istringstream;
 using std::stack;
-using std::find_if;
 using std::make_pair;
 
-typedef pair<NodePtr, NodePtr> NodePair;
+typedef pair<size_t, size_t> NodePair;
 
 class ResolvingGrammarGenerator : public ValidatingGrammarGenerator {
-    Production doGenerate(const NodePtr& writer, const NodePtr& reader,
+    const SchemaTable writer_;
+    const SchemaTable reader_;
+
+    Production doGenerate(size_t writer, size_t reader,
         map<NodePair, shared_ptr<Production> > &m,
-        const map<NodePtr, shared_ptr<Production> > &m2);
-    Production resolveRecords(const NodePtr& writer, const NodePtr& reader,
+        const map<size_t, shared_ptr<Production> > &m2);
+    Production resolveRecords(size_t writer, size_t reader,
         map<NodePair, shared_ptr<Production> > &m,
-        const map<NodePtr, shared_ptr<Production> > &m2);
-    Production resolveUnion(const NodePtr& writer, const NodePtr& reader,
+        const map<size_t, shared_ptr<Production> > &m2);
+    Production resolveUnion(size_t writer, size_t reader,
         map<NodePair, shared_ptr<Production> > &m,
-        const map<NodePtr, shared_ptr<Production> > &m2);
-
-    static vector<pair<string, size_t> > fields(const NodePtr& n) {
-        vector<pair<string, size_t> > result;
-        size_t c = n->names();
-        for (size_t i = 0; i < c; ++i) {
-            result.push_back(make_pair(n->nameAt(i), i));
-        }
-        return result;
-    }
+        const map<size_t, shared_ptr<Production> > &m2);
 
-    static int bestBranch(const NodePtr& writer, const NodePtr& reader);
+    int bestBranch(size_t writer, size_t reader);
 
-    Production getWriterProduction(const NodePtr& n,
-        const map<NodePtr, shared_ptr<Production> >& m2);
+    Production getWriterProduction(size_t n,
+        const map<size_t, shared_ptr<Production> >& m2);
 
 public:
-    Symbol generate(
-        const ValidSchema& writer, const ValidSchema& reader);
+    ResolvingGrammarGenerator(const ValidSchema& writer,
+        const ValidSchema& reader) : writer_(writer), reader_(reader) { }
+
+    Symbol generate();
 };
 
-Symbol ResolvingGrammarGenerator::generate(
-    const ValidSchema& writer, const ValidSchema& reader) {
-    map<NodePtr, shared_ptr<Production> > m2;
+Symbol ResolvingGrammarGenerator::generate() {
+    map<size_t, shared_ptr<Production> > m2;
 
-    const NodePtr& rr = reader.root();
-    const NodePtr& rw = writer.root();
+    const size_t rr = reader_.root();
+    const size_t rw = writer_.root();
     // NOTE:
     // Oddly, this was left unreversed. Tests included in lang/c++/tests do
     // not detect this incorrect state because they do not read to the end of a
     // record with an added field
-    Production backup = ValidatingGrammarGenerator::doGenerate(rw, m2);
+    Production backup =
+        ValidatingGrammarGenerator::doGenerate(writer_, rw, m2);
     fixup(backup, m2);
 
     map<NodePair, shared_ptr<Production> > m;
@@ -113,17 +108,16 @@ Symbol ResolvingGrammarGenerator::generate(
     return Symbol::rootSymbol(main, backup);
 }
 
-int ResolvingGrammarGenerator::bestBranch(const NodePtr& writer,
-    const NodePtr& reader)
+int ResolvingGrammarGenerator::bestBranch(size_t writer, size_t reader)
 {
-    Type t = writer->type();
+    Type t = writer_.type(writer);
 
-    const size_t c = reader->leaves();
+    const size_t c = reader_.leaves(reader);
     for (size_t j = 0; j < c; ++j) {
-        const NodePtr& r = reader->leafAt(j);
-        if (t == r->type()) {
-            if (r->hasName()) {
-                if (r->name() == writer->name()) {
+        size_t r = reader_.leafAt(reader, j);
+        if (t == reader_.type(r)) {
+            if (reader_.hasName(r)) {
+                if (reader_.name(r) == writer_.name(writer)) {
                     return j;
                 }
             } else {
@@ -133,8 +127,7 @@ int ResolvingGrammarGenerator::bestBranch(const NodePtr& writer,
     }
 
     for (size_t j = 0; j < c; ++j) {
-        const NodePtr& r = reader->leafAt(j);
-        Type rt = r->type();
+        Type rt = reader_.type(reader_.leafAt(reader, j));
         switch (t) {
         case AVRO_INT:
             if (rt == AVRO_LONG || rt == AVRO_DOUBLE || rt == AVRO_FLOAT) {
@@ -154,51 +147,38 @@ int ResolvingGrammarGenerator::bestBranch(const NodePtr& writer,
     return -1;
 }
 
-template<typename T1, typename T2>
-struct equalsFirst
+Production ResolvingGrammarGenerator::getWriterProduction(size_t n,
+    const map<size_t, shared_ptr<Production> >& m2)
 {
-    const T1& v_;
-    equalsFirst(const T1& v) : v_(v) { }
-    bool operator()(const pair<T1, T2>& p) {
-        return p.first == v_;
-    }
-};
-
-Production ResolvingGrammarGenerator::getWriterProduction(const NodePtr& n,
-    const map<NodePtr, shared_ptr<Production> >& m2)
-{
-    const NodePtr& nn = (n->type() == AVRO_SYMBOLIC) ?
-        static_cast<const NodeSymbolic& >(*n).getNode() : n;
-    map<NodePtr, shared_ptr<Production> >::const_iterator it2 = m2.find(nn);
+    const size_t nn = writer_.resolve(n);
+    map<size_t, shared_ptr<Production> >::const_iterator it2 = m2.find(nn);
     return (it2 != m2.end()) ? *(it2->second) :
-        ValidatingGrammarGenerator::generate(nn);
+        ValidatingGrammarGenerator::generate(writer_, nn);
 }
 
 Production ResolvingGrammarGenerator::resolveRecords(
-    const NodePtr& writer, const NodePtr& reader,
+    size_t writer, size_t reader,
     map<NodePair, shared_ptr<Production> >& m,
-    const map<NodePtr, shared_ptr<Production> >& m2)
+    const map<size_t, shared_ptr<Production> >& m2)
 {
     Production result;
 
-    vector<pair<string, size_t> > wf = fields(writer);
-    vector<pair<string, size_t> > rf = fields(reader);
+    // Reader fields are found through the reader node's name index.
+    const Node& rn = *reader_.node(reader);
+    const size_t wc = writer_.names(writer);
     vector<size_t> fieldOrder;
-    fieldOrder.reserve(reader->names());
-
-    for (vector<pair<string, size_t> >::const_iterator it = wf.begin();
-        it != wf.end(); ++it) {
-        vector<pair<string, size_t> >::iterator it2 =
-            find_if(rf.begin(), rf.end(),
-                equalsFirst<string, size_t>(it->first));
-        if (it2 != rf.end()) {
-            Production p = doGenerate(writer->leafAt(it->second),
-                reader->leafAt(it2->second), m, m2);
+    fieldOrder.reserve(reader_.names(reader));
+
+    for (size_t i = 0; i < wc; ++i) {
+        size_t j;
+        if (rn.nameIndex(writer_.nameAt(writer, i), j)) {
+            Production p = doGenerate(writer_.leafAt(writer, i),
+                reader_.leafAt(reader, j), m, m2);
             copy(p.rbegin(), p.rend(), back_inserter(result));
-            fieldOrder.push_back(it2->second);
-            rf.erase(it2);
+            fieldOrder.push_back(j);
         } else {
-            Production p = getWriterProduction(writer->leafAt(it->second), m2);
+            Production p = getWriterProduction(
+                writer_.leafAt(writer, i), m2);
             result.push_back(Symbol::skipStart());
             if (p.size() == 1) {
                 result.push_back(p[0]);
@@ -208,7 +188,7 @@ Production ResolvingGrammarGenerator::resolveRecords(
         }
     }
 
-    if (! rf.empty()) {
+    if (fieldOrder.size() != reader_.names(reader)) {
         throw Exception("Don't know how to handle excess fields for reader.");
     }
     reverse(result.begin(), result.end());
@@ -220,15 +200,15 @@ Production ResolvingGrammarGenerator::resolveRecords(
 }
 
 Production ResolvingGrammarGenerator::resolveUnion(
-    const NodePtr& writer, const NodePtr& reader,
+    size_t writer, size_t reader,
     map<NodePair, shared_ptr<Production> >& m,
-    const map<NodePtr, shared_ptr<Production> >& m2)
+    const map<size_t, shared_ptr<Production> >& m2)
 {
     vector<Production> v;
-    size_t c = writer->leaves();
+    size_t c = writer_.leaves(writer);
     v.reserve(c);
     for (size_t i = 0; i < c; ++i) {
-        Production p = doGenerate(writer->leafAt(i), reader, m, m2);
+        Production p = doGenerate(writer_.leafAt(writer, i), reader, m, m2);
         v.push_back(p);
     }
     Symbol r[] = {
@@ -239,12 +219,12 @@ Production ResolvingGrammarGenerator::resolveUnion(
 }
 
 Production ResolvingGrammarGenerator::doGenerate(
-    const NodePtr& writer, const NodePtr& reader,
+    size_t writer, size_t reader,
     map<NodePair, shared_ptr<Production> > &m,
-    const map<NodePtr, shared_ptr<Production> > &m2)
+    const map<size_t, shared_ptr<Production> > &m2)
 {
-    Type writerType = writer->type();
-    Type readerType = reader->type();
+    Type writerType = writer_.type(writer);
+    Type readerType = reader_.type(reader);
 
     if (writerType == readerType) {
         switch (writerType) {
@@ -265,10 +245,10 @@ Production ResolvingGrammarGenerator::doGenerate(
         case AVRO_BYTES:
             return Production(1, Symbol::bytesSymbol());
         case AVRO_FIXED:
-            if (writer->name() == reader->name() &&
-                writer->fixedSize() == reader->fixedSize()) {
+            if (writer_.name(writer) == reader_.name(reader) &&
+                writer_.fixedSize(writer) == reader_.fixedSize(reader)) {
                 Symbol r[] = {
-                    Symbol::sizeCheckSymbol(reader->fixedSize()),
+                    Symbol::sizeCheckSymbol(reader_.fixedSize(reader)),
                     Symbol::fixedSymbol() };
                 Production result(r, r + 2);
                 m[make_pair(writer, reader)] = boost::make_shared<Production>(result);
@@ -276,8 +256,8 @@ Production ResolvingGrammarGenerator::doGenerate(
             }
             break;
         case AVRO_RECORD:
-            if (writer->name() == reader->name()) {
-                const pair<NodePtr, NodePtr> key(writer, reader);
+            if (writer_.name(writer) == reader_.name(reader)) {
+                const NodePair key(writer, reader);
                 m.erase(key);
                 Production result = resolveRecords(writer, reader, m, m2);
 
@@ -290,9 +270,10 @@ Production ResolvingGrammarGenerator::doGenerate(
             break;
 
         case AVRO_ENUM:
-            if (writer->name() == reader->name()) {
+            if (writer_.name(writer) == reader_.name(reader)) {
                 Symbol r[] = {
-                    Symbol::enumAdjustSymbol(writer, reader),
+                    Symbol::enumAdjustSymbol(writer_.node(writer),
+                        reader_.node(reader)),
                     Symbol::enumSymbol(),
                 };
                 Production result(r, r + 2);
@@ -303,22 +284,25 @@ Production ResolvingGrammarGenerator::doGenerate(
 
         case AVRO_ARRAY:
             {
-                Production p = getWriterProduction(writer->leafAt(0), m2);
+                Production p = getWriterProduction(
+                    writer_.leafAt(writer, 0), m2);
                 Symbol r[] = {
                     Symbol::arrayEndSymbol(),
                     Symbol::repeater(
-                        doGenerate(writer->leafAt(0), reader->leafAt(0), m, m2),
+                        doGenerate(writer_.leafAt(writer, 0),
+                            reader_.leafAt(reader, 0), m, m2),
                         p, true),
                     Symbol::arrayStartSymbol() };
                 return Production(r, r + 3);
             }
         case AVRO_MAP:
             {
-                Production v = doGenerate(writer->leafAt(1),
-                    reader->leafAt(1), m, m2);
+                Production v = doGenerate(writer_.leafAt(writer, 1),
+                    reader_.leafAt(reader, 1), m, m2);
                 v.push_back(Symbol::stringSymbol());
 
-                Production v2 = getWriterProduction(writer->leafAt(1), m2);
+                Production v2 = getWriterProduction(
+                    writer_.leafAt(writer, 1), m2);
                 v2.push_back(Symbol::stringSymbol());
 
                 Symbol r[] = {
@@ -331,11 +315,7 @@ Production ResolvingGrammarGenerator::doGenerate(
             return resolveUnion(writer, reader, m, m2);
         case AVRO_SYMBOLIC:
             {
-                shared_ptr<NodeSymbolic> w =
-                    static_pointer_cast<NodeSymbolic>(writer);
-                shared_ptr<NodeSymbolic> r =
-                    static_pointer_cast<NodeSymbolic>(reader);
-                NodePair p(w->getNode(), r->getNode());
+                NodePair p(writer_.resolve(writer), reader_.resolve(reader));
                 map<NodePair, shared_ptr<Production> >::iterator it = m.find(p);
                 if (it != m.end() && it->second) {
                     return *it->second;
@@ -378,7 +358,8 @@ Production ResolvingGrammarGenerator::doGenerate(
             {
                 int j = bestBranch(writer, reader);
                 if (j >= 0) {
-                    Production p = doGenerate(writer, reader->leafAt(j), m, m2);
+                    Production p = doGenerate(writer,
+                        reader_.leafAt(reader, j), m, m2);
                     Symbol r[] = {
                         Symbol::unionAdjustSymbol(j, p),
                         Symbol::unionSymbol()
@@ -401,7 +382,8 @@ Production ResolvingGrammarGenerator::doGenerate(
             throw Exception("Unknown node type");
         }
     }
-    return Production(1, Symbol::error(writer, reader));
+    return Production(1, Symbol::error(writer_.node(writer),
+        reader_.node(reader)));
 }
 
 class ResolvingDecoderHandler {
@@ -433,10 +415,13 @@ class ResolvingDecoderImpl : public ResolvingDecoder
     float decodeFloat();
     double decodeDouble();
     void decodeString(string& value);
+    void decodeStringView(StringView& value);
     void skipString();
     void decodeBytes(vector<uint8_t>& value);
+    void decodeBytesView(BytesView& value);
     void skipBytes();
     void decodeFixed(size_t n, vector<uint8_t>& value);
+    void decodeFixed(size_t n, uint8_t* value);
     void skipFixed(size_t n);
     size_t decodeEnum();
     size_t arrayStart();
@@ -458,7 +443,7 @@ public:
     // from the avro source base) indicate that all methods should be writer, reader
     // but this was not.
     //parser_(ResolvingGrammarGenerator().generate(reader, writer),
-    parser_(ResolvingGrammarGenerator().generate(writer, reader),
+    parser_(ResolvingGrammarGenerator(writer, reader).generate(),
             &(*base_), handler_)
     {
     }
@@ -525,6 +510,13 @@ void ResolvingDecoderImpl<P>::decodeString(string& value)
     base_->decodeString(value);
 }
 
+template <typename P>
+void ResolvingDecoderImpl<P>::decodeStringView(StringView& value)
+{
+    parser_.advance(Symbol::sString);
+    base_->decodeStringView(value);
+}
+
 template <typename P>
 void ResolvingDecoderImpl<P>::skipString()
 {
@@ -539,6 +531,13 @@ void ResolvingDecoderImpl<P>::decodeBytes(vector<uint8_t>& value)
     base_->decodeBytes(value);
 }
 
+template <typename P>
+void ResolvingDecoderImpl<P>::decodeBytesView(BytesView& value)
+{
+    parser_.advance(Symbol::sBytes);
+    base_->decodeBytesView(value);
+}
+
 template <typename P>
 void ResolvingDecoderImpl<P>::skipBytes()
 {
@@ -554,6 +553,14 @@ void ResolvingDecoderImpl<P>::decodeFixed(size_t n, vector<uint8_t>& value)
     return base_->decodeFixed(n, value);
 }
 
+template <typename P>
+void ResolvingDecoderImpl<P>::decodeFixed(size_t n, uint8_t* value)
+{
+    parser_.advance(Symbol::sFixed);
+    parser_.assertSize(n);
+    base_->decodeFixed(n, value);
+}
+
 template <typename P>
 void ResolvingDecoderImpl<P>::skipFixed(size_t n)
 {
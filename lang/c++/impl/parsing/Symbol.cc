@@ -19,6 +19,8 @@
 
 #include "Symbol.hh"
 
+#include <algorithm>
+
 namespace avro {
 namespace parsing {
 
@@ -69,13 +71,6 @@ const char* Symbol::stringValues[] = {
 
 Symbol Symbol::enumAdjustSymbol(const NodePtr& writer, const NodePtr& reader)
 {
-    vector<string> rs;
-    size_t rc = reader->names();
-    for (size_t i = 0; i < rc; ++i) {
-        rs.push_back(reader->nameAt(i));
-    }
-    sort(rs.begin(), rs.end());
-
     size_t wc = writer->names();
     vector<int> adj;
     adj.reserve(wc);
@@ -84,18 +79,49 @@ Symbol Symbol::enumAdjustSymbol(const NodePtr& writer, const NodePtr& reader)
 
     for (size_t i = 0; i < wc; ++i) {
         const string& s = writer->nameAt(i);
-        vector<string>::const_iterator it = find(rs.begin(), rs.end(), s);
-        if (it == rs.end()) {
+        size_t j;
+        if (reader->nameIndex(s, j)) {
+            adj.push_back(j);
+        } else {
             int pos = err.size() + 1;
             adj.push_back(-pos);
             err.push_back(s);
-        } else {
-            adj.push_back(it - rs.begin());
         }
     }
     return Symbol(sEnumAdjust, make_pair(adj, err));
 }
 
+struct NameList::Less {
+    const vector<string>& names_;
+
+    Less(const vector<string>& names) : names_(names) { }
+
+    bool operator()(size_t a, size_t b) const {
+        return names_[a] < names_[b];
+    }
+
+    bool operator()(size_t a, const string& b) const {
+        return names_[a] < b;
+    }
+};
+
+NameList::NameList(const vector<string>& names) :
+    names_(names), sorted_(names.size())
+{
+    for (size_t i = 0; i < sorted_.size(); ++i) {
+        sorted_[i] = i;
+    }
+    // Stable, so that of equal names the first comes first.
+    std::stable_sort(sorted_.begin(), sorted_.end(), Less(names_));
+}
+
+size_t NameList::indexOf(const string& name) const
+{
+    vector<size_t>::const_iterator it = std::lower_bound(sorted_.begin(),
+        sorted_.end(), name, Less(names_));
+    return (it != sorted_.end() && names_[*it] == name) ? *it : size();
+}
+
 Symbol Symbol::error(const NodePtr& writer, const NodePtr& reader)
 {
     ostringstream oss;
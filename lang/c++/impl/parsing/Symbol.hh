@@ -23,10 +23,12 @@
 #include <map>
 #include <stack>
 #include <sstream>
+#include <string>
 
 #include <boost/any.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/tuple/tuple.hpp>
 
 #include "Node.hh"
@@ -38,6 +40,37 @@ namespace parsing {
 
 class Symbol;
 
+/**
+ * The names of an enum's symbols or of a union's branches, in order, with
+ * an index sorted by name so that a name can be looked up by binary search
+ * without allocating. It is built once, with the grammar, and shared by
+ * every copy of its symbol.
+ */
+class NameList {
+    std::vector<std::string> names_;
+    std::vector<size_t> sorted_;
+
+    struct Less;
+public:
+    explicit NameList(const std::vector<std::string>& names);
+
+    size_t size() const {
+        return names_.size();
+    }
+
+    const std::string& nameAt(size_t i) const {
+        return names_[i];
+    }
+
+    /**
+     * Returns the index of the first of the names that equals the given
+     * one, or size() if there is none.
+     */
+    size_t indexOf(const std::string& name) const;
+};
+
+typedef boost::shared_ptr<const NameList> NameListPtr;
+
 typedef std::vector<Symbol> Production;
 typedef boost::tuple<size_t, bool, Production, Production> RepeaterInfo;
 typedef boost::tuple<Production, Production> RootInfo;
@@ -63,7 +96,7 @@ public:
         sUnion,
         sTerminalHigh,
         sSizeCheck,     // Extra has size
-        sNameList,      // Extra has a vector<string>
+        sNameList,      // Extra has a NameListPtr
         sRoot,          // Root for a schema, extra is Symbol
         sRepeater,      // Array or Map, extra is symbol
         sAlternative,   // One of many (union), extra is Union
@@ -236,7 +269,7 @@ public:
 
     static Symbol nameListSymbol(
         const std::vector<std::string>& v) {
-        return Symbol(sNameList, v);
+        return Symbol(sNameList, NameListPtr(new NameList(v)));
     }
 
     template <typename T>
@@ -259,8 +292,9 @@ public:
         return Symbol(sUnionAdjust, std::make_pair(branch, p));
     }
 
-    static Symbol sizeListAction(std::vector<size_t> order) {
-        return Symbol(sSizeList, order);
+    static Symbol sizeListAction(const std::vector<size_t>& order) {
+        return Symbol(sSizeList,
+            boost::make_shared<std::vector<size_t> >(order));
     }
 
     static Symbol recordAction() {
@@ -605,15 +639,18 @@ public:
         return p.first;
     }
 
-    std::string nameForIndex(size_t e) {
+    /**
+     * Returns the name with the given index. The name belongs to the
+     * grammar and lives as long as it does.
+     */
+    const std::string& nameForIndex(size_t e) {
         const Symbol& s = parsingStack.top();
         assertMatch(Symbol::sNameList, s.kind());
-        const std::vector<std::string> names =
-            s.extra<std::vector<std::string> >();
+        const NameList& names = **s.extrap<NameListPtr>();
         if (e >= names.size()) {
             throw Exception("Not that many names");
         }
-        std::string result = names[e];
+        const std::string& result = names.nameAt(e);
         parsingStack.pop();
         return result;
     }
@@ -621,14 +658,11 @@ public:
     size_t indexForName(const std::string &name) {
         const Symbol& s = parsingStack.top();
         assertMatch(Symbol::sNameList, s.kind());
-        const std::vector<std::string> names =
-            s.extra<std::vector<std::string> >();
-        std::vector<std::string>::const_iterator it =
-            std::find(names.begin(), names.end(), name);
-        if (it == names.end()) {
+        const NameList& names = **s.extrap<NameListPtr>();
+        size_t result = names.indexOf(name);
+        if (result == names.size()) {
             throw Exception("No such enum symbol");
         }
-        size_t result = it - names.begin();
         parsingStack.pop();
         return result;
     }
@@ -664,10 +698,14 @@ public:
         append(v[n]);
     }
 
+    /**
+     * Returns the list of sizes at the top of the stack. The list is shared
+     * with the grammar, so it stays valid after the symbol is popped.
+     */
     const std::vector<size_t>& sizeList() {
         const Symbol& s = parsingStack.top();
         assertMatch(Symbol::sSizeList, s.kind());
-        return *s.extrap<std::vector<size_t> >();
+        return **s.extrap<boost::shared_ptr<std::vector<size_t> > >();
     }
 
     Symbol::Kind top() const {
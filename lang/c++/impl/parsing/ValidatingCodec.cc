@@ -47,22 +47,24 @@ using std::reverse;
 using std::ostringstream;
 
 /** Follows the design of Avro Parser in Java. */
-Production ValidatingGrammarGenerator::generate(const NodePtr& n)
+Production ValidatingGrammarGenerator::generate(const SchemaTable& t,
+    size_t n)
 {
-    map<NodePtr, shared_ptr<Production> > m;
-    Production result = doGenerate(n, m);
+    map<size_t, shared_ptr<Production> > m;
+    Production result = doGenerate(t, n, m);
     fixup(result, m);
     return result;
 }
 
 Symbol ValidatingGrammarGenerator::generate(const ValidSchema& schema)
 {
-    return Symbol::rootSymbol(generate(schema.root()));
+    const SchemaTable t(schema);
+    return Symbol::rootSymbol(generate(t, t.root()));
 }
 
-Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
-    map<NodePtr, shared_ptr<Production> > &m) {
-    switch (n->type()) {
+Production ValidatingGrammarGenerator::doGenerate(const SchemaTable& t,
+    size_t n, map<size_t, shared_ptr<Production> > &m) {
+    switch (t.type(n)) {
     case AVRO_NULL:
         return Production(1, Symbol::nullSymbol());
     case AVRO_BOOL:
@@ -82,7 +84,7 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
     case AVRO_FIXED:
         {
             Symbol r[] = {
-                Symbol::sizeCheckSymbol(n->fixedSize()),
+                Symbol::sizeCheckSymbol(t.fixedSize(n)),
                 Symbol::fixedSymbol() };
             Production result(r, r + 2);
             m[n] = boost::make_shared<Production>(result);
@@ -92,10 +94,9 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
             Production result;
 
             m.erase(n);
-            size_t c = n->leaves();
+            size_t c = t.leaves(n);
             for (size_t i = 0; i < c; ++i) {
-                const NodePtr& leaf = n->leafAt(i);
-                Production v = doGenerate(leaf, m);
+                Production v = doGenerate(t, t.leafAt(n, i), m);
                 copy(v.rbegin(), v.rend(), back_inserter(result));
             }
             reverse(result.begin(), result.end());
@@ -110,7 +111,7 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
     case AVRO_ENUM:
         {
             Symbol r[] = {
-                Symbol::sizeCheckSymbol(n->names()),
+                Symbol::sizeCheckSymbol(t.names(n)),
                 Symbol::enumSymbol() };
             Production result(r, r + 2);
             m[n] = boost::make_shared<Production>(result);
@@ -120,13 +121,13 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
         {
             Symbol r[] = {
                 Symbol::arrayEndSymbol(),
-                Symbol::repeater(doGenerate(n->leafAt(0), m), true),
+                Symbol::repeater(doGenerate(t, t.leafAt(n, 0), m), true),
                 Symbol::arrayStartSymbol() };
             return Production(r, r + 3);
         }
     case AVRO_MAP:
         {
-            Production v = doGenerate(n->leafAt(1), m);
+            Production v = doGenerate(t, t.leafAt(n, 1), m);
             v.push_back(Symbol::stringSymbol());
             Symbol r[] = {
                 Symbol::mapEndSymbol(),
@@ -137,10 +138,10 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
     case AVRO_UNION:
         {
             vector<Production> vv;
-            size_t c = n->leaves();
+            size_t c = t.leaves(n);
             vv.reserve(c);
             for (size_t i = 0; i < c; ++i) {
-                vv.push_back(doGenerate(n->leafAt(i), m));
+                vv.push_back(doGenerate(t, t.leafAt(n, i), m));
             }
             Symbol r[] = {
                 Symbol::alternative(vv),
@@ -150,10 +151,8 @@ Production ValidatingGrammarGenerator::doGenerate(const NodePtr& n,
         }
     case AVRO_SYMBOLIC:
         {
-            shared_ptr<NodeSymbolic> ns = static_pointer_cast<NodeSymbolic>(n);
-            NodePtr nn = ns->getNode();
-            map<NodePtr, shared_ptr<Production> >::iterator it =
-                m.find(nn);
+            size_t nn = t.resolve(n);
+            map<size_t, shared_ptr<Production> >::iterator it = m.find(nn);
             if (it != m.end() && it->second) {
                 return *it->second;
             } else {
@@ -186,10 +185,13 @@ class ValidatingDecoder : public Decoder {
     float decodeFloat();
     double decodeDouble();
     void decodeString(string& value);
+    void decodeStringView(StringView& value);
     void skipString();
     void decodeBytes(vector<uint8_t>& value);
+    void decodeBytesView(BytesView& value);
     void skipBytes();
     void decodeFixed(size_t n, vector<uint8_t>& value);
+    void decodeFixed(size_t n, uint8_t* value);
     void skipFixed(size_t n);
     size_t decodeEnum();
     size_t arrayStart();
@@ -263,6 +265,13 @@ void ValidatingDecoder<P>::decodeString(string& value)
     base->decodeString(value);
 }
 
+template <typename P>
+void ValidatingDecoder<P>::decodeStringView(StringView& value)
+{
+    parser.advance(Symbol::sString);
+    base->decodeStringView(value);
+}
+
 template <typename P>
 void ValidatingDecoder<P>::skipString()
 {
@@ -277,6 +286,13 @@ void ValidatingDecoder<P>::decodeBytes(vector<uint8_t>& value)
     base->decodeBytes(value);
 }
 
+template <typename P>
+void ValidatingDecoder<P>::decodeBytesView(BytesView& value)
+{
+    parser.advance(Symbol::sBytes);
+    base->decodeBytesView(value);
+}
+
 template <typename P>
 void ValidatingDecoder<P>::skipBytes()
 {
@@ -292,6 +308,14 @@ void ValidatingDecoder<P>::decodeFixed(size_t n, vector<uint8_t>& value)
     base->decodeFixed(n, value);
 }
 
+template <typename P>
+void ValidatingDecoder<P>::decodeFixed(size_t n, uint8_t* value)
+{
+    parser.advance(Symbol::sFixed);
+    parser.assertSize(n);
+    base->decodeFixed(n, value);
+}
+
 template <typename P>
 void ValidatingDecoder<P>::skipFixed(size_t n)
 {
@@ -26,6 +26,7 @@
 #include "Symbol.hh"
 #include "ValidSchema.hh"
 #include "NodeImpl.hh"
+#include "SchemaTable.hh"
 
 namespace avro {
 namespace parsing {
@@ -39,10 +40,10 @@ protected:
     template<typename T>
     static void doFixup(Symbol &s,
         const std::map<T, boost::shared_ptr<Production> > &m);
-    virtual Production doGenerate(const NodePtr& n,
-        std::map<NodePtr, boost::shared_ptr<Production> > &m);
+    virtual Production doGenerate(const SchemaTable& t, size_t n,
+        std::map<size_t, boost::shared_ptr<Production> > &m);
 
-    Production generate(const NodePtr& schema);
+    Production generate(const SchemaTable& t, size_t n);
 public:
     Symbol generate(const ValidSchema& schema);
 
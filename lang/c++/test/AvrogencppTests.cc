@@ -25,9 +25,15 @@
 #include "recursive.hh"
 #include "circulardep.hh"
 #include "reuse.hh"
+#include "sortorder.hh"
+#include "views.hh"
 #include "Compiler.hh"
+#include "BinaryCodec.hh"
+#include "DataFile.hh"
 
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 #include <boost/test/included/unit_test_framework.hpp>
 
 #ifdef min
@@ -208,6 +214,585 @@ void testEncoding2()
     check(t2, t1);
 }
 
+void testUnionCopy()
+{
+    map<string, int32_t> m;
+    m["one"] = 1;
+
+    testgen::_bigrecord_Union__0__ u1;
+    BOOST_CHECK(u1.is_null());
+    u1.set_map(m);
+    BOOST_CHECK_EQUAL(u1.idx(), 1U);
+
+    testgen::_bigrecord_Union__0__ u2(u1);
+    BOOST_CHECK(u2.get_map() == m);
+    u2.get_map()["two"] = 2;
+    BOOST_CHECK_EQUAL(u1.get_map().size(), 1U);
+
+    u1 = u2;
+    BOOST_CHECK(u1.get_map() == u2.get_map());
+
+    u2.set_float(1.5f);
+    BOOST_CHECK_EQUAL(u2.idx(), 2U);
+    BOOST_CHECK_EQUAL(u2.get_float(), 1.5f);
+    BOOST_CHECK_THROW(u2.get_map(), avro::Exception);
+
+    u1 = u2;
+    BOOST_CHECK_EQUAL(u1.get_float(), 1.5f);
+    u1.emplace_map()["three"] = 3;
+    BOOST_CHECK_EQUAL(u1.get_map().size(), 1U);
+    u1.set_null();
+    BOOST_CHECK(u1.is_null());
+}
+
+void testRecursive()
+{
+    ValidSchema s;
+    ifstream ifs("jsonschemas/recursive");
+    compileJsonSchema(ifs, s);
+
+    rec::LongList t1;
+    t1.value = 1;
+    t1.next.emplace_LongList().value = 2;
+    t1.next.get_LongList().next.set_null();
+
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(s, binaryEncoder());
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+
+    DecoderPtr d = validatingDecoder(s, binaryDecoder());
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    rec::LongList t2;
+    avro::decode(*d, t2);
+
+    BOOST_CHECK_EQUAL(t2.value, 1);
+    BOOST_REQUIRE_EQUAL(t2.next.idx(), 0U);
+    BOOST_CHECK_EQUAL(t2.next.get_LongList().value, 2);
+    BOOST_CHECK(t2.next.get_LongList().next.is_null());
+
+    rec::LongList t3 = t2;
+    t2.next.get_LongList().value = 3;
+    BOOST_CHECK_EQUAL(t3.next.get_LongList().value, 2);
+}
+
+/**
+ * A default-constructed recursive value ends at its non-recursive branch,
+ * so it can be encoded, sized and hashed.
+ */
+void testRecursiveDefault()
+{
+    ValidSchema s;
+    ifstream ifs("jsonschemas/recursive");
+    compileJsonSchema(ifs, s);
+
+    const rec::LongList t1 = rec::LongList();
+    BOOST_CHECK(t1.next.is_null());
+
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(s, binaryEncoder());
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+    BOOST_CHECK_EQUAL(avro::encodedSize(t1), os->byteCount());
+
+    DecoderPtr d = validatingDecoder(s, binaryDecoder());
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    rec::LongList t2;
+    t2.next.emplace_LongList().value = 5;
+    avro::decode(*d, t2);
+    BOOST_CHECK(t2.next.is_null());
+    BOOST_CHECK(t2 == t1);
+    BOOST_CHECK(! (t2 < t1));
+    BOOST_CHECK_EQUAL(avro::hash(t2), avro::hash(t1));
+}
+
+static vector<uint8_t> toBytes(const OutputStream& os)
+{
+    vector<uint8_t> result;
+    auto_ptr<InputStream> is = memoryInputStream(os);
+    const uint8_t* b;
+    size_t n;
+    while (is->next(&b, &n)) {
+        result.insert(result.end(), b, b + n);
+    }
+    return result;
+}
+
+void testBinaryCodec()
+{
+    testgen::RootRecord t1;
+    setRecord(t1);
+
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, t1);
+    e->flush();
+    vector<uint8_t> expected = toBytes(*os);
+
+    BOOST_CHECK_EQUAL(avro::encodedSize(t1), expected.size());
+
+    vector<uint8_t> buf(expected.size());
+    uint8_t* p = &buf[0];
+    BOOST_CHECK(! avro::encodeBinary(t1, p, p + buf.size() - 1));
+    BOOST_CHECK(p == &buf[0]);
+    BOOST_REQUIRE(avro::encodeBinary(t1, p, p + buf.size()));
+    BOOST_CHECK(p == &buf[0] + buf.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(buf.begin(), buf.end(),
+        expected.begin(), expected.end());
+
+    testgen::RootRecord t2;
+    const uint8_t* q = &buf[0];
+    BOOST_CHECK(! avro::decodeBinary(q, q + buf.size() - 1, t2));
+    BOOST_CHECK(q == &buf[0]);
+    BOOST_REQUIRE(avro::decodeBinary(q, q + buf.size(), t2));
+    BOOST_CHECK(q == &buf[0] + buf.size());
+    check(t2, t1);
+
+    testgen3::AvroPoint point;
+    point.latitude = 42.3570;
+    point.longitude = -71.1109;
+    uint8_t b[avro::binary_codec_traits<testgen3::AvroPoint>::maxSize];
+    p = b;
+    avro::binary::put(p, point);
+    BOOST_CHECK_EQUAL(p - b, 16);
+    BOOST_CHECK_EQUAL(avro::encodedSize(point), 16U);
+}
+
+/**
+ * Block counts come from the data and must not be trusted to size
+ * anything before the items are there.
+ */
+void testBinaryCodecCounts()
+{
+    uint8_t buf[32];
+    uint8_t* p = buf;
+    avro::binary::encodeLong(p, buf + sizeof(buf), int64_t(1) << 40);
+    avro::binary::encodeLong(p, buf + sizeof(buf), 7);
+    const uint8_t* q = buf;
+    vector<int32_t> v;
+    BOOST_CHECK(! avro::decodeBinary(q, static_cast<const uint8_t*>(p), v));
+    BOOST_CHECK(v.capacity() < 16);
+    map<string, int32_t> m;
+    q = buf;
+    BOOST_CHECK(! avro::decodeBinary(q, static_cast<const uint8_t*>(p), m));
+
+    p = buf;
+    avro::binary::encodeLong(p, buf + sizeof(buf),
+        std::numeric_limits<int64_t>::min());
+    avro::binary::encodeLong(p, buf + sizeof(buf), 0);
+    q = buf;
+    BOOST_CHECK_THROW(avro::decodeBinary(q, static_cast<const uint8_t*>(p), v),
+        avro::Exception);
+
+    p = buf;
+    avro::binary::encodeLong(p, buf + sizeof(buf), -1);
+    avro::binary::encodeLong(p, buf + sizeof(buf), -4);
+    q = buf;
+    BOOST_CHECK_THROW(avro::decodeBinary(q, static_cast<const uint8_t*>(p), v),
+        avro::Exception);
+}
+
+void testBinaryCodecStream()
+{
+    const size_t count = 20;
+    testgen::RootRecord t1;
+    setRecord(t1);
+
+    // Small chunks make many records straddle a chunk boundary.
+    auto_ptr<OutputStream> os = memoryOutputStream(256);
+    for (size_t i = 0; i < count; ++i) {
+        t1.mylong = i;
+        avro::encodeBinary(*os, t1);
+    }
+
+    DecoderPtr d = binaryDecoder();
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    for (size_t i = 0; i < count; ++i) {
+        testgen::RootRecord t2;
+        avro::decode(*d, t2);
+        t1.mylong = i;
+        check(t2, t1);
+    }
+
+    is = memoryInputStream(*os);
+    testgen::RootRecord t2;
+    for (size_t i = 0; i < count; ++i) {
+        avro::decodeBinary(*is, t2);
+        t1.mylong = i;
+        check(t2, t1);
+    }
+    const uint8_t* b;
+    size_t n;
+    BOOST_CHECK(! is->next(&b, &n));
+}
+
+void testDecodeOnly()
+{
+    ValidSchema s;
+    ifstream ifs("jsonschemas/bigrecord");
+    compileJsonSchema(ifs, s);
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(s, binaryEncoder());
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    avro::encode(*e, t1);
+    t1.mylong = 313;
+    avro::encode(*e, t1);
+    e->flush();
+
+    DecoderPtr d = validatingDecoder(s, binaryDecoder());
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    testgen::RootRecord t2;
+    testgen::decodeOnly_route(*d, t2);
+    BOOST_CHECK_EQUAL(t2.mylong, 212);
+    BOOST_CHECK_EQUAL(t2.nestedrecord.inval2, "hello world");
+    BOOST_CHECK_EQUAL(t2.anotherint, 4534);
+    BOOST_CHECK(t2.mymap.empty());
+    BOOST_CHECK(t2.anothernested.inval2.empty());
+
+    // The skipped fields were consumed, so the next record follows.
+    testgen::RootRecord t3;
+    avro::decode(*d, t3);
+    check(t3, t1);
+
+    rec::LongList l1;
+    l1.value = 1;
+    l1.next.emplace_LongList().value = 2;
+    l1.next.get_LongList().next.set_null();
+    os = memoryOutputStream();
+    e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, l1);
+    l1.value = 3;
+    avro::encode(*e, l1);
+    e->flush();
+
+    d = binaryDecoder();
+    is = memoryInputStream(*os);
+    d->init(*is);
+    rec::LongList l2;
+    rec::decodeOnly_value(*d, l2);
+    BOOST_CHECK_EQUAL(l2.value, 1);
+    rec::decodeOnly_value(*d, l2);
+    BOOST_CHECK_EQUAL(l2.value, 3);
+}
+
+void testSchemaTraits()
+{
+    typedef avro::schema_traits<testgen::RootRecord> traits;
+    ValidSchema s;
+    ifstream ifs("jsonschemas/bigrecord");
+    compileJsonSchema(ifs, s);
+
+    const uint64_t fp = traits::fingerprint;
+    BOOST_CHECK_EQUAL(fp, s.fingerprint());
+    BOOST_CHECK_EQUAL(traits::schema().fingerprint(), s.fingerprint());
+    BOOST_CHECK(&traits::schema() == &traits::schema());
+
+    std::ostringstream expected;
+    s.toJson(expected);
+    std::ostringstream actual;
+    traits::schema().toJson(actual);
+    BOOST_CHECK_EQUAL(actual.str(), expected.str());
+
+    // The schema the traits give works with the generated code.
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(traits::schema(), binaryEncoder());
+    e->init(*os);
+    testgen::RootRecord t1;
+    setRecord(t1);
+    avro::encode(*e, t1);
+    e->flush();
+
+    BOOST_CHECK_EQUAL(avro::schema_traits<rec::LongList>::fingerprint,
+        avro::schema_traits<rec::LongList>::schema().fingerprint());
+}
+
+void testSortOrder()
+{
+    ValidSchema s;
+    ifstream ifs("jsonschemas/sortorder");
+    compileJsonSchema(ifs, s);
+    const avro::NodePtr& root = s.root();
+    BOOST_CHECK_EQUAL(root->sortOrderAt(0), avro::AVRO_ASCENDING);
+    BOOST_CHECK_EQUAL(root->sortOrderAt(1), avro::AVRO_DESCENDING);
+    BOOST_CHECK_EQUAL(root->sortOrderAt(2), avro::AVRO_IGNORE);
+
+    so::Ordered a;
+    a.key = "k";
+    a.rank = 1;
+    a.note = "first";
+    a.tags.resize(1);
+    a.tags[0].name = "t";
+    a.tags[0].weight.set_double(0.5);
+    a.id.assign(7);
+
+    // Ignored fields take no part in equality or hashing.
+    so::Ordered b = a;
+    b.note = "second";
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(! (a < b) && ! (b < a));
+    BOOST_CHECK_EQUAL(avro::hash(a), avro::hash(b));
+    BOOST_CHECK_EQUAL(so::hash_value(a), avro::hash(b));
+
+    // Descending fields sort higher values first.
+    b.rank = 2;
+    BOOST_CHECK(a != b);
+    BOOST_CHECK(b < a);
+
+    // Earlier fields decide before later ones.
+    b.key = "l";
+    BOOST_CHECK(a < b);
+
+    // Union values order by branch first; null is branch 0.
+    b = a;
+    b.tags[0].weight.set_null();
+    BOOST_CHECK(b < a);
+    BOOST_CHECK(avro::hash(a) != avro::hash(b));
+    b.tags[0].weight.set_double(0.25);
+    BOOST_CHECK(b < a);
+
+    // Arrays compare element by element, a prefix first.
+    b = a;
+    b.tags.push_back(a.tags[0]);
+    BOOST_CHECK(a < b);
+
+    // Fixed compares as unsigned bytes.
+    b = a;
+    b.id[3] = 0x80;
+    BOOST_CHECK(a < b);
+}
+
+/**
+ * Reads data written with an older LongList, whose fields come in another
+ * order and include one the generated type lacks, into rec::LongList.
+ */
+void testResolving()
+{
+    ValidSchema writer = avro::compileJsonSchemaFromString(
+        "{\"type\":\"record\",\"name\":\"LongList\",\"fields\":["
+        "{\"name\":\"comment\",\"type\":\"string\"},"
+        "{\"name\":\"next\",\"type\":[\"LongList\",\"null\"]},"
+        "{\"name\":\"value\",\"type\":\"long\"}]}");
+    ValidSchema reader;
+    ifstream ifs("jsonschemas/recursive");
+    compileJsonSchema(ifs, reader);
+
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = validatingEncoder(writer, binaryEncoder());
+    e->init(*os);
+    e->encodeString("first");
+    e->encodeUnionIndex(0);
+    e->encodeString("second");
+    e->encodeUnionIndex(1);
+    e->encodeNull();
+    e->encodeLong(2);
+    e->encodeLong(1);
+    e->flush();
+
+    DecoderPtr d = avro::resolvingDecoder(writer, reader, binaryDecoder());
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    d->init(*is);
+    rec::LongList l;
+    avro::decode(*d, l);
+
+    BOOST_CHECK_EQUAL(l.value, 1);
+    BOOST_REQUIRE_EQUAL(l.next.idx(), 0U);
+    BOOST_CHECK_EQUAL(l.next.get_LongList().value, 2);
+    BOOST_CHECK(l.next.get_LongList().next.is_null());
+}
+
+static void checkViews(const vw::Message& m)
+{
+    BOOST_CHECK_EQUAL(toString(m.id), "message-id");
+    BOOST_CHECK(toBytes(m.payload) == vector<uint8_t>(100, 0x5a));
+    BOOST_REQUIRE_EQUAL(m.tags.size(), 2U);
+    BOOST_CHECK_EQUAL(toString(m.tags[0]), "first");
+    BOOST_CHECK_EQUAL(toString(m.tags[1]), "second");
+    BOOST_REQUIRE_EQUAL(m.attrs.size(), 1U);
+    BOOST_CHECK_EQUAL(m.attrs.find("k")->second.size(), 3U);
+    BOOST_REQUIRE_EQUAL(m.note.idx(), 1U);
+    BOOST_CHECK_EQUAL(toString(m.note.get_string()), "a note");
+}
+
+static bool within(const void* p, const vector<uint8_t>& buf)
+{
+    const uint8_t* q = static_cast<const uint8_t*>(p);
+    return q >= &buf[0] && q < &buf[0] + buf.size();
+}
+
+/**
+ * Decodes strings and bytes as views, in place when the input is in
+ * contiguous memory and through an arena when values straddle chunks.
+ */
+void testViews()
+{
+    const string id = "message-id";
+    const vector<uint8_t> payload(100, 0x5a);
+    const string tags[] = { "first", "second" };
+    const string note = "a note";
+    const uint8_t attr[] = { 1, 2, 3 };
+
+    vw::Message m;
+    m.id = avro::StringView(id);
+    m.payload = avro::BytesView(payload);
+    m.tags.push_back(avro::StringView(tags[0]));
+    m.tags.push_back(avro::StringView(tags[1]));
+    m.attrs["k"] = avro::BytesView(attr, sizeof(attr));
+    m.note.set_string(avro::StringView(note));
+
+    // Small chunks make several values straddle a chunk boundary.
+    auto_ptr<OutputStream> os = memoryOutputStream(16);
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    avro::encode(*e, m);
+    e->flush();
+    vector<uint8_t> buf = toBytes(*os);
+    BOOST_CHECK_EQUAL(avro::encodedSize(m), buf.size());
+
+    DecoderPtr d = binaryDecoder();
+    auto_ptr<InputStream> is = memoryInputStream(&buf[0], buf.size());
+    d->init(*is);
+    vw::Message m2;
+    avro::decode(*d, m2);
+    checkViews(m2);
+    BOOST_CHECK(within(m2.id.data(), buf));
+    BOOST_CHECK(within(m2.payload.data(), buf));
+    BOOST_CHECK(within(m2.note.get_string().data(), buf));
+
+    const uint8_t* p = &buf[0];
+    vw::Message m3;
+    BOOST_REQUIRE(avro::decodeBinary(p, p + buf.size(), m3));
+    checkViews(m3);
+    BOOST_CHECK(within(m3.payload.data(), buf));
+
+    avro::Arena arena;
+    d = validatingDecoder(
+        avro::schema_traits<vw::Message>::schema(), binaryDecoder(arena));
+    is = memoryInputStream(*os);
+    d->init(*is);
+    vw::Message m4;
+    avro::decode(*d, m4);
+    d.reset();
+    checkViews(m4);
+
+    // File streams reuse their buffers, so views from them are copied
+    // into the arena and outlive the stream.
+    BOOST_STATIC_ASSERT(avro::holds_views<vw::Message>::value);
+    const char* filename = "test_views.bin";
+    {
+        auto_ptr<OutputStream> fos = avro::fileOutputStream(filename, 16);
+        avro::encodeBinary(*fos, m);
+        fos->flush();
+    }
+    vw::Message m5;
+    {
+        auto_ptr<InputStream> fis = avro::fileInputStream(filename, 16);
+        BOOST_CHECK(! fis->stable());
+        avro::decodeBinary(*fis, m5, arena);
+    }
+    checkViews(m5);
+    std::remove(filename);
+
+    is = memoryInputStream(&buf[0], buf.size());
+    vw::Message m6;
+    avro::decodeBinary(*is, m6, arena);
+    checkViews(m6);
+    BOOST_CHECK(within(m6.payload.data(), buf));
+}
+
+/**
+ * Map keys are not views, so a record whose only strings are map keys
+ * can be decoded from any stream without an arena.
+ */
+void testViewsMapKeys()
+{
+    BOOST_STATIC_ASSERT(! avro::holds_views<vw::Counts>::value);
+
+    vw::Counts c;
+    c.hits["first"] = 1;
+    c.hits["second"] = 2;
+    auto_ptr<OutputStream> os = memoryOutputStream(4);
+    avro::encodeBinary(*os, c);
+    os->flush();
+
+    auto_ptr<InputStream> is = memoryInputStream(*os);
+    vw::Counts c2;
+    avro::decodeBinary(*is, c2);
+    BOOST_CHECK(c2.hits == c.hits);
+}
+
+/**
+ * Generated types skip validation only against the schema they were
+ * generated from.
+ */
+void testCheckedEncoder()
+{
+    ValidSchema bigrecord;
+    ifstream ifs("jsonschemas/bigrecord");
+    compileJsonSchema(ifs, bigrecord);
+    ValidSchema other = avro::compileJsonSchemaFromString("\"long\"");
+
+    BOOST_CHECK(avro::has_schema_fingerprint<testgen::RootRecord>::value);
+    BOOST_CHECK(! avro::has_schema_fingerprint<int64_t>::value);
+    BOOST_CHECK(avro::conformsTo<testgen::RootRecord>(bigrecord));
+    BOOST_CHECK(! avro::conformsTo<testgen::RootRecord>(other));
+    BOOST_CHECK(! avro::conformsTo<int64_t>(other));
+
+    EncoderPtr base = binaryEncoder();
+    BOOST_CHECK(avro::checkedEncoder<testgen::RootRecord>(bigrecord, base)
+        == base);
+    EncoderPtr e = avro::checkedEncoder<testgen::RootRecord>(other, base);
+    BOOST_CHECK(e != base);
+
+    testgen::RootRecord t1;
+    setRecord(t1);
+    auto_ptr<OutputStream> os = memoryOutputStream();
+    e->init(*os);
+    BOOST_CHECK_THROW(avro::encode(*e, t1), avro::Exception);
+
+    // Written through the data file's own schema string, which must parse
+    // back, so this uses a schema without fixed types.
+    ValidSchema recursive;
+    ifstream rfs("jsonschemas/recursive");
+    compileJsonSchema(rfs, recursive);
+    rec::LongList l1;
+    l1.next.set_null();
+    const char* filename = "test_checked.df";
+    std::remove(filename);
+    {
+        avro::DataFileWriter<rec::LongList> df(filename, other);
+        BOOST_CHECK_THROW(df.write(l1), avro::Exception);
+    }
+    {
+        avro::DataFileWriter<rec::LongList> df(filename, recursive);
+        for (int i = 0; i < 3; ++i) {
+            l1.value = i;
+            df.write(l1);
+        }
+        df.close();
+    }
+    {
+        avro::DataFileReader<rec::LongList> df(filename, recursive);
+        rec::LongList l2;
+        for (int i = 0; i < 3; ++i) {
+            BOOST_REQUIRE(df.read(l2));
+            BOOST_CHECK_EQUAL(l2.value, i);
+            BOOST_CHECK(l2.next.is_null());
+        }
+        BOOST_CHECK(! df.read(l2));
+    }
+    std::remove(filename);
+}
+
 boost::unit_test::test_suite*
 init_unit_test_suite(int argc, char* argv[]) 
 {
@@ -216,6 +801,19 @@ init_unit_test_suite(int argc, char* argv[])
     ts->add(BOOST_TEST_CASE(testEncoding2<uau::r1>));
     ts->add(BOOST_TEST_CASE(testEncoding2<umu::r1>));
     ts->add(BOOST_TEST_CASE(testNamespace));
+    ts->add(BOOST_TEST_CASE(testUnionCopy));
+    ts->add(BOOST_TEST_CASE(testRecursive));
+    ts->add(BOOST_TEST_CASE(testRecursiveDefault));
+    ts->add(BOOST_TEST_CASE(testBinaryCodec));
+    ts->add(BOOST_TEST_CASE(testBinaryCodecCounts));
+    ts->add(BOOST_TEST_CASE(testBinaryCodecStream));
+    ts->add(BOOST_TEST_CASE(testSchemaTraits));
+    ts->add(BOOST_TEST_CASE(testDecodeOnly));
+    ts->add(BOOST_TEST_CASE(testSortOrder));
+    ts->add(BOOST_TEST_CASE(testResolving));
+    ts->add(BOOST_TEST_CASE(testViews));
+    ts->add(BOOST_TEST_CASE(testViewsMapKeys));
+    ts->add(BOOST_TEST_CASE(testCheckedEncoder));
     return ts;
 }
 
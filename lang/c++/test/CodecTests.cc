@@ -24,11 +24,17 @@
 #include "ValidSchema.hh"
 #include "Generic.hh"
 #include "Specific.hh"
+#include "Transcoder.hh"
+#include "FieldPath.hh"
+#include "BinaryComparator.hh"
 
 #include <stdint.h>
+#include <list>
 #include <vector>
 #include <stack>
+#include <set>
 #include <string>
+#include <limits>
 #include <functional>
 #include <boost/bind.hpp>
 
@@ -38,6 +44,19 @@
 #include <boost/random/mersenne_twister.hpp>
 
 namespace avro {
+
+static std::string toString(const OutputStream& os)
+{
+    std::auto_ptr<InputStream> in = memoryInputStream(os);
+    std::string result;
+    const uint8_t* b;
+    size_t n;
+    while (in->next(&b, &n)) {
+        result.append(reinterpret_cast<const char*>(b), n);
+    }
+    return result;
+}
+
 namespace parsing {
 
 static const unsigned int count = 10;
@@ -773,9 +792,24 @@ void testGeneric(const TestData& td) {
         avro::encode(*e2, datum);
         e2->flush();
 
+        // GenericReader and GenericWriter, which walk the schema rather
+        // than the datum, must agree.
+        DecoderPtr d3 = CodecFactory::newDecoder(vs);
+        auto_ptr<InputStream> in3 = memoryInputStream(*p);
+        d3->init(*in3);
+        GenericDatum datum3;
+        GenericReader(vs, d3).read(datum3);
+        EncoderPtr e3 = CodecFactory::newEncoder(vs);
+        auto_ptr<OutputStream> ob3 = memoryOutputStream();
+        e3->init(*ob3);
+        GenericWriter(vs, e3).write(datum3);
+        e3->flush();
+        BOOST_CHECK_EQUAL(toString(*ob3), toString(*ob));
+
         BOOST_TEST_CHECKPOINT("Test: " << testNo << ' '
             << " schema: " << td.schema
             << " calls: " << td.calls);
+        BOOST_CHECK_EQUAL(encodedSize(datum), ob->byteCount());
         auto_ptr<InputStream> in2 = memoryInputStream(*ob);
         testDecoder(CodecFactory::newDecoder(vs), v, *in2,
             td.calls, td.depth);
@@ -1256,6 +1290,13 @@ static const TestData4 data4[] = {
         "e0",
         { NULL }, 1 },
 
+    { "{\"type\":\"enum\",\"name\":\"e\",\"symbols\":[\"x\",\"y\",\"z\"]}",
+        "e0",
+        { NULL },
+        "{\"type\":\"enum\",\"name\":\"e\",\"symbols\":[ \"z\", \"x\" ]}",
+        "e1",
+        { NULL }, 1 },
+
 
     // Union
     { "\"int\"", "I", { "100", NULL },
@@ -1418,6 +1459,623 @@ static void testStreamLifetimes()
 
 }
 
+/**
+ * Decodes the symbols of a wide enum and the branches of a wide union from
+ * JSON, in an order unrelated to that of the schema.
+ */
+static void testJsonNameLookup()
+{
+    const size_t n = 300;
+    std::ostringstream schema;
+    schema << "{\"type\":\"record\",\"name\":\"r\",\"fields\":["
+        "{\"name\":\"e\",\"type\":{\"type\":\"enum\",\"name\":\"E\","
+        "\"symbols\":[";
+    for (size_t i = 0; i < n; ++i) {
+        schema << (i == 0 ? "" : ",") << "\"S" << (i * 7919) % 1000 << '"';
+    }
+    schema << "]}},{\"name\":\"u\",\"type\":[\"int\"";
+    for (size_t i = 0; i < n; ++i) {
+        schema << ",{\"type\":\"fixed\",\"name\":\"F" << i << "\",\"size\":1}";
+    }
+    schema << ",\"null\"]}]}";
+    ValidSchema vs = parsing::makeValidSchema(schema.str().c_str());
+
+    std::ostringstream json;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t k = (i * 37) % n;
+        json << "{\"e\":\"S" << (k * 7919) % 1000 << "\",\"u\":";
+        if (k == 0) {
+            json << "null}";
+        } else {
+            json << "{\"F" << k << "\":\"x\"}}";
+        }
+    }
+    json << "{\"e\":\"T1\",\"u\":null}";
+    const std::string text = json.str();
+    std::auto_ptr<InputStream> in = memoryInputStream(
+        reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    DecoderPtr d = jsonDecoder(vs);
+    d->init(*in);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t k = (i * 37) % n;
+        BOOST_CHECK_EQUAL(d->decodeEnum(), k);
+        if (k == 0) {
+            BOOST_CHECK_EQUAL(d->decodeUnionIndex(), n + 1);
+            d->decodeNull();
+        } else {
+            BOOST_CHECK_EQUAL(d->decodeUnionIndex(), k + 1);
+            BOOST_CHECK_EQUAL(d->decodeFixed(1)[0], 'x');
+        }
+    }
+    BOOST_CHECK_THROW(d->decodeEnum(), Exception);
+}
+
+struct TranscoderData {
+    const char* schema;
+    const char* json;
+};
+
+static const TranscoderData transcoderData[] = {
+    { "\"int\"", "-17" },
+    { "{\"type\":\"record\",\"name\":\"r\",\"fields\":["
+        "{\"name\":\"n\",\"type\":\"null\"},"
+        "{\"name\":\"b\",\"type\":\"boolean\"},"
+        "{\"name\":\"i\",\"type\":\"int\"},"
+        "{\"name\":\"l\",\"type\":\"long\"},"
+        "{\"name\":\"f\",\"type\":\"float\"},"
+        "{\"name\":\"d\",\"type\":\"double\"},"
+        "{\"name\":\"s\",\"type\":\"string\"},"
+        "{\"name\":\"e\",\"type\":"
+            "{\"type\":\"enum\",\"name\":\"E\",\"symbols\":[\"X\",\"Y\"]}}"
+        "]}",
+        "{\"n\":null,\"b\":true,\"i\":-3,\"l\":1234567890123,"
+        "\"f\":1.5,\"d\":-0.25,\"s\":\"caf\\u00e9 \\\"au\\\" lait\","
+        "\"e\":\"Y\"}" },
+    { "{\"type\":\"map\",\"values\":{\"type\":\"array\","
+        "\"items\":[\"null\",\"string\"]}}",
+        "{\"a\":[null,{\"string\":\"x\"}],\"b\":[],\"c\":[null]}" },
+    { "{\"type\":\"record\",\"name\":\"Node\",\"fields\":["
+        "{\"name\":\"value\",\"type\":\"long\"},"
+        "{\"name\":\"children\",\"type\":"
+            "{\"type\":\"array\",\"items\":\"Node\"}},"
+        "{\"name\":\"next\",\"type\":[\"null\",\"Node\"]}]}",
+        "{\"value\":1,\"children\":[{\"value\":2,\"children\":[],"
+        "\"next\":null},{\"value\":3,\"children\":[{\"value\":4,"
+        "\"children\":[],\"next\":null}],\"next\":null}],"
+        "\"next\":{\"Node\":{\"value\":5,\"children\":[],"
+        "\"next\":null}}}" },
+};
+
+/**
+ * Transcodes the JSON of each schema to binary and back, and checks the
+ * results against those of going through a GenericDatum.
+ */
+static void testTranscoder()
+{
+    for (size_t i = 0; i < sizeof(transcoderData) / sizeof(transcoderData[0]);
+        ++i) {
+        const TranscoderData& td = transcoderData[i];
+        BOOST_TEST_CHECKPOINT("Schema: " << td.schema);
+        ValidSchema vs = parsing::makeValidSchema(td.schema);
+        const uint8_t* json = reinterpret_cast<const uint8_t*>(td.json);
+        const size_t jsonLength = ::strlen(td.json);
+
+        std::auto_ptr<InputStream> in1 = memoryInputStream(json, jsonLength);
+        DecoderPtr d = jsonDecoder(vs);
+        d->init(*in1);
+        GenericDatum datum(vs);
+        avro::decode(*d, datum);
+
+        std::auto_ptr<OutputStream> out1 = memoryOutputStream();
+        EncoderPtr e = binaryEncoder();
+        e->init(*out1);
+        avro::encode(*e, datum);
+        e->flush();
+
+        std::auto_ptr<OutputStream> out2 = memoryOutputStream();
+        e = jsonEncoder(vs);
+        e->init(*out2);
+        avro::encode(*e, datum);
+        e->flush();
+
+        std::auto_ptr<InputStream> in2 = memoryInputStream(json, jsonLength);
+        std::auto_ptr<OutputStream> out3 = memoryOutputStream();
+        TranscoderPtr t = jsonToBinaryTranscoder(vs);
+        t->init(*in2, *out3);
+        t->transcode();
+        t->flush();
+        BOOST_CHECK_EQUAL(toString(*out3), toString(*out1));
+
+        std::auto_ptr<InputStream> in3 = memoryInputStream(*out3);
+        std::auto_ptr<OutputStream> out4 = memoryOutputStream();
+        t = binaryToJsonTranscoder(vs);
+        t->init(*in3, *out4);
+        t->transcode();
+        t->flush();
+        BOOST_CHECK_EQUAL(toString(*out4), toString(*out2));
+    }
+}
+
+/**
+ * Transcodes an array too long for one block, followed by a second value,
+ * and reads them back.
+ */
+static void testTranscoderBlocks()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"array\",\"items\":\"long\"}");
+    const size_t count = 100000;
+    std::ostringstream oss;
+    oss << '[';
+    for (size_t i = 0; i < count; ++i) {
+        oss << (i == 0 ? "" : ",") << i * 1000;
+    }
+    oss << "] [7]";
+    const std::string json = oss.str();
+
+    std::auto_ptr<InputStream> in = memoryInputStream(
+        reinterpret_cast<const uint8_t*>(json.data()), json.size());
+    std::auto_ptr<OutputStream> out = memoryOutputStream();
+    TranscoderPtr t = jsonToBinaryTranscoder(vs);
+    t->init(*in, *out);
+    t->transcode();
+    t->transcode();
+    t->flush();
+
+    std::auto_ptr<InputStream> in2 = memoryInputStream(*out);
+    DecoderPtr d = binaryDecoder();
+    d->init(*in2);
+    std::vector<int64_t> v;
+    avro::decode(*d, v);
+    BOOST_REQUIRE_EQUAL(v.size(), count);
+    for (size_t i = 0; i < count; ++i) {
+        BOOST_REQUIRE_EQUAL(v[i], static_cast<int64_t>(i * 1000));
+    }
+    avro::decode(*d, v);
+    BOOST_REQUIRE_EQUAL(v.size(), 1U);
+    BOOST_CHECK_EQUAL(v[0], 7);
+
+    // More than one block was needed.
+    in2 = memoryInputStream(*out);
+    d->init(*in2);
+    BOOST_CHECK(d->arrayStart() < count);
+}
+
+/**
+ * Feeds JSON texts to a transcoder one at a time, keeping the streams of
+ * each until the next is set, as Transcoder::init() requires.
+ */
+class JsonFeeder {
+    Transcoder& t_;
+    std::list<std::string> texts_;
+    std::auto_ptr<InputStream> in_;
+    std::auto_ptr<OutputStream> out_;
+
+public:
+    JsonFeeder(Transcoder& t) : t_(t) { }
+
+    std::string transcode(const std::string& json) {
+        texts_.push_back(json);
+        const std::string& text = texts_.back();
+        std::auto_ptr<InputStream> in = memoryInputStream(
+            reinterpret_cast<const uint8_t*>(text.data()), text.size());
+        std::auto_ptr<OutputStream> out = memoryOutputStream();
+        t_.init(*in, *out);
+        in_ = in;
+        out_ = out;
+        t_.transcode();
+        t_.flush();
+        return toString(*out_);
+    }
+};
+
+/**
+ * A transcoder used again after a value failed starts afresh: the items
+ * read before the failure are not written out with the next value, and
+ * the JSON nesting the failure left behind is forgotten.
+ */
+static void testTranscoderReuse()
+{
+    ValidSchema arrays = parsing::makeValidSchema(
+        "{\"type\":\"array\",\"items\":{\"type\":\"array\",\"items\":\"int\"}}");
+    TranscoderPtr t1 = jsonToBinaryTranscoder(arrays);
+    JsonFeeder f1(*t1);
+    BOOST_CHECK_THROW(f1.transcode("[[1, 2], [3, 3000000000]]"), Exception);
+    BOOST_CHECK_EQUAL(f1.transcode("[[5]]"),
+        std::string("\x02\x02\x0a\x00\x00", 5));
+
+    ValidSchema records = parsing::makeValidSchema(
+        "{\"type\":\"array\",\"items\":{\"type\":\"record\","
+        "\"name\":\"R\",\"fields\":[{\"name\":\"a\",\"type\":\"int\"},"
+        "{\"name\":\"b\",\"type\":\"int\"}]}}");
+    TranscoderPtr t2 = jsonToBinaryTranscoder(records);
+    JsonFeeder f2(*t2);
+    BOOST_CHECK_THROW(f2.transcode("[{\"a\": 1, \"b\": 2}, {\"a\": 3,"),
+        Exception);
+    BOOST_CHECK_EQUAL(f2.transcode("[{\"a\": 4, \"b\": 5}]"),
+        std::string("\x02\x08\x0a\x00", 4));
+
+    ValidSchema scalar = parsing::makeValidSchema("\"int\"");
+    TranscoderPtr t3 = jsonToBinaryTranscoder(scalar);
+    JsonFeeder f3(*t3);
+    BOOST_CHECK_THROW(f3.transcode("{\"a\": 1,"), Exception);
+    BOOST_CHECK_EQUAL(f3.transcode("42"), std::string("\x54", 1));
+}
+
+static void testFieldPath()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"record\",\"name\":\"com.x.Order\",\"fields\":["
+        "{\"name\":\"id\",\"type\":\"long\"},"
+        "{\"name\":\"customer\",\"type\":{\"type\":\"record\","
+        "\"name\":\"Customer\",\"fields\":[{\"name\":\"name\","
+        "\"type\":\"string\"},{\"name\":\"address\",\"type\":{"
+        "\"type\":\"record\",\"name\":\"Address\",\"fields\":["
+        "{\"name\":\"city\",\"type\":\"string\"}]}}]}},"
+        "{\"name\":\"note\",\"type\":[\"null\",\"string\"]},"
+        "{\"name\":\"ship\",\"type\":[\"null\",\"Address\"]}]}");
+
+    const FieldPath id(vs, "id");
+    const FieldPath city(vs, "customer.address.city");
+    const FieldPath note(vs, "note");
+    const FieldPath noteText(vs, "note[string]");
+    const FieldPath ship(vs, "ship");
+    const FieldPath shipCity(vs, "ship.city");
+    const FieldPath shipCity2(vs, "ship[com.x.Address].city");
+    const FieldPath shipCity3(vs, "ship[1].city");
+    BOOST_CHECK_EQUAL(shipCity2.path(), "ship[com.x.Address].city");
+
+    GenericDatum d1(vs);
+    GenericDatum d2(vs);
+    id.get(d1).value<int64_t>() = 1;
+    id.get(d2).value<int64_t>() = 2;
+    city.get(d1).value<std::string>() = "Oslo";
+    BOOST_CHECK_EQUAL(d1.value<GenericRecord>().fieldAt(1).value<GenericRecord>()
+        .fieldAt(1).value<GenericRecord>().fieldAt(0).value<std::string>(),
+        "Oslo");
+    BOOST_CHECK_EQUAL(id.get(d2).value<int64_t>(), 2);
+    BOOST_CHECK_EQUAL(city.get(d2).value<std::string>(), "");
+
+    // Until the unions hold the right branch, the values are not there.
+    BOOST_CHECK(noteText.find(d1) == 0);
+    BOOST_CHECK(shipCity.find(d1) == 0);
+    BOOST_CHECK_THROW(shipCity.get(d1), Exception);
+    note.get(d1).selectBranch(1);
+    ship.get(d1).selectBranch(1);
+    noteText.get(d1).value<std::string>() = "fragile";
+    shipCity.get(d1).value<std::string>() = "Bergen";
+    BOOST_CHECK_EQUAL(note.get(d1).value<std::string>(), "fragile");
+    BOOST_CHECK_EQUAL(shipCity2.get(d1).value<std::string>(), "Bergen");
+    BOOST_CHECK_EQUAL(shipCity3.get(d1).value<std::string>(), "Bergen");
+    const GenericDatum& cd1 = d1;
+    BOOST_CHECK(shipCity.find(cd1) == &shipCity.get(d1));
+
+    const char* bad[] = {
+        "", "nosuch", "id.x", "customer..name", "customer.", "note[int]",
+        "ship[2].city", "ship[com.x.Address", "id[long]", "note.x",
+        "customer[Customer]",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        BOOST_CHECK_THROW(FieldPath(vs, bad[i]), Exception);
+    }
+}
+
+
+static int sign(int n)
+{
+    return n < 0 ? -1 : n > 0 ? 1 : 0;
+}
+
+/**
+ * Checks that a orders against b as expected, the same way with and
+ * without the schema, and that equal data hash alike.
+ */
+static void checkOrder(const GenericComparator& c,
+    const GenericDatum& a, const GenericDatum& b, int expected)
+{
+    BOOST_CHECK_EQUAL(sign(c.compare(a, b)), expected);
+    BOOST_CHECK_EQUAL(sign(c.compare(b, a)), -expected);
+    BOOST_CHECK_EQUAL(sign(compare(a, b)), expected);
+    BOOST_CHECK_EQUAL(c.equals(a, b), expected == 0);
+    BOOST_CHECK_EQUAL(a == b, expected == 0);
+    BOOST_CHECK_EQUAL(a < b, expected < 0);
+    if (expected == 0) {
+        BOOST_CHECK_EQUAL(c.hash(a), c.hash(b));
+    }
+    BOOST_CHECK_EQUAL(c.hash(a), avro::hash(a));
+}
+
+static void testGenericCompare()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+        "{\"name\":\"k\",\"type\":\"int\"},"
+        "{\"name\":\"name\",\"type\":\"string\",\"order\":\"descending\"},"
+        "{\"name\":\"note\",\"type\":\"string\",\"order\":\"ignore\"},"
+        "{\"name\":\"u\",\"type\":[\"null\",\"double\"]},"
+        "{\"name\":\"a\",\"type\":{\"type\":\"array\",\"items\":\"long\"}},"
+        "{\"name\":\"e\",\"type\":{\"type\":\"enum\",\"name\":\"E\","
+        "\"symbols\":[\"A\",\"B\",\"C\"]}},"
+        "{\"name\":\"f\",\"type\":{\"type\":\"fixed\",\"name\":\"F\","
+        "\"size\":1}}]}");
+    const GenericComparator c(vs);
+    const FieldPath k(vs, "k");
+    const FieldPath name(vs, "name");
+    const FieldPath note(vs, "note");
+    const FieldPath u(vs, "u");
+    const FieldPath a(vs, "a");
+    const FieldPath e(vs, "e");
+    const FieldPath f(vs, "f");
+
+    GenericDatum d1(vs);
+    GenericDatum d2(vs);
+    checkOrder(c, d1, d2, 0);
+
+    k.get(d2).value<int32_t>() = 1;
+    checkOrder(c, d1, d2, -1);
+    k.get(d1).value<int32_t>() = 1;
+
+    // Descending fields order backwards, ignored ones not at all.
+    name.get(d1).value<std::string>() = "a";
+    name.get(d2).value<std::string>() = "b";
+    checkOrder(c, d1, d2, 1);
+    name.get(d2).value<std::string>() = "a";
+    note.get(d1).value<std::string>() = "x";
+    checkOrder(c, d1, d2, 0);
+
+    // Unions order by branch first; -0 is 0 and NaN is NaN.
+    u.get(d1).selectBranch(0);
+    u.get(d2).selectBranch(0);
+    checkOrder(c, d1, d2, 0);
+    u.get(d2).selectBranch(1);
+    checkOrder(c, d1, d2, -1);
+    u.get(d1).selectBranch(1);
+    u.get(d1).value<double>() = -0.0;
+    checkOrder(c, d1, d2, 0);
+    u.get(d1).value<double>() = std::numeric_limits<double>::quiet_NaN();
+    checkOrder(c, d1, d2, 1);
+    u.get(d2).value<double>() = -std::numeric_limits<double>::quiet_NaN();
+    checkOrder(c, d1, d2, 0);
+
+    GenericArray::Value& a1 = a.get(d1).value<GenericArray>().value();
+    GenericArray::Value& a2 = a.get(d2).value<GenericArray>().value();
+    a1.push_back(GenericDatum(int64_t(1)));
+    a2.push_back(GenericDatum(int64_t(1)));
+    a2.push_back(GenericDatum(int64_t(0)));
+    checkOrder(c, d1, d2, -1);
+    a1[0] = GenericDatum(int64_t(2));
+    checkOrder(c, d1, d2, 1);
+    a1 = a2;
+
+    e.get(d1).value<GenericEnum>().set("C");
+    e.get(d2).value<GenericEnum>().set("B");
+    checkOrder(c, d1, d2, 1);
+    e.get(d2).value<GenericEnum>().set("C");
+
+    // Bytes compare unsigned.
+    f.get(d1).value<GenericFixed>().value()[0] = 0xff;
+    f.get(d2).value<GenericFixed>().value()[0] = 0x7f;
+    checkOrder(c, d1, d2, 1);
+    f.get(d2).value<GenericFixed>().value()[0] = 0xff;
+    checkOrder(c, d1, d2, 0);
+
+    std::set<GenericDatum> s;
+    s.insert(d1);
+    s.insert(d2);
+    BOOST_CHECK_EQUAL(s.size(), 1U);
+}
+
+static void testGenericCompareMaps()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"map\",\"values\":\"int\"}");
+    const GenericComparator c(vs);
+    GenericDatum d1(vs);
+    GenericDatum d2(vs);
+    GenericMap::Value& m1 = d1.value<GenericMap>().value();
+    GenericMap::Value& m2 = d2.value<GenericMap>().value();
+    m1.push_back(std::make_pair("x", GenericDatum(1)));
+    m1.push_back(std::make_pair("y", GenericDatum(2)));
+    m2.push_back(std::make_pair("y", GenericDatum(2)));
+    m2.push_back(std::make_pair("x", GenericDatum(1)));
+
+    // Maps are equal whatever the order of their entries, but unordered.
+    BOOST_CHECK(c.equals(d1, d2));
+    BOOST_CHECK(d1 == d2);
+    BOOST_CHECK_EQUAL(c.hash(d1), c.hash(d2));
+    BOOST_CHECK_EQUAL(avro::hash(d1), c.hash(d2));
+    BOOST_CHECK_THROW(c.compare(d1, d2), Exception);
+    BOOST_CHECK_THROW(compare(d1, d2), Exception);
+
+    m2[0].second = GenericDatum(3);
+    BOOST_CHECK(! c.equals(d1, d2));
+    BOOST_CHECK(d1 != d2);
+    m2.pop_back();
+    BOOST_CHECK(! c.equals(d1, d2));
+}
+
+
+static std::string encodeBinary(const GenericDatum& d)
+{
+    std::auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    GenericWriter::write(*e, d);
+    e->flush();
+    return toString(*os);
+}
+
+static int binaryCompare(const BinaryComparator& c,
+    const std::string& a, const std::string& b)
+{
+    return sign(c.compare(reinterpret_cast<const uint8_t*>(a.data()),
+        a.size(), reinterpret_cast<const uint8_t*>(b.data()), b.size()));
+}
+
+/**
+ * Fills d with values from a small range, so that random data often tie
+ * on the leading fields.
+ */
+static void randomize(GenericDatum& d, boost::mt19937& rnd)
+{
+    GenericRecord& r = d.value<GenericRecord>();
+    r.fieldAt(0).value<int32_t>() = rnd() % 3 - 1;
+    r.fieldAt(1).value<std::string>() = std::string(rnd() % 3, 'a');
+    r.fieldAt(2).value<std::string>() = std::string(rnd() % 3, 'x');
+    GenericMap::Value& m = r.fieldAt(3).value<GenericMap>().value();
+    m.clear();
+    for (size_t i = rnd() % 3; i > 0; --i) {
+        m.push_back(std::make_pair(std::string(i, 'k'),
+            GenericDatum(int32_t(i))));
+    }
+    GenericDatum& u = r.fieldAt(4);
+    u.selectBranch(rnd() % 2);
+    if (u.unionBranch() == 1) {
+        u.value<double>() = static_cast<double>(rnd() % 3) - 1;
+    }
+    GenericArray::Value& a = r.fieldAt(5).value<GenericArray>().value();
+    a.clear();
+    for (size_t i = rnd() % 3; i > 0; --i) {
+        a.push_back(GenericDatum(int64_t(rnd() % 2)));
+    }
+    r.fieldAt(6).value<GenericEnum>().set(rnd() % 3);
+    std::vector<uint8_t>& f = r.fieldAt(7).value<GenericFixed>().value();
+    f[0] = (rnd() % 2) ? 0x7f : 0xff;
+    f[1] = rnd() % 2;
+}
+
+static void testBinaryComparator()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+        "{\"name\":\"k\",\"type\":\"int\"},"
+        "{\"name\":\"name\",\"type\":\"string\",\"order\":\"descending\"},"
+        "{\"name\":\"note\",\"type\":\"string\",\"order\":\"ignore\"},"
+        "{\"name\":\"m\",\"type\":{\"type\":\"map\",\"values\":\"int\"},"
+        "\"order\":\"ignore\"},"
+        "{\"name\":\"u\",\"type\":[\"null\",\"double\"]},"
+        "{\"name\":\"a\",\"type\":{\"type\":\"array\",\"items\":\"long\"}},"
+        "{\"name\":\"e\",\"type\":{\"type\":\"enum\",\"name\":\"E\","
+        "\"symbols\":[\"A\",\"B\",\"C\"]}},"
+        "{\"name\":\"f\",\"type\":{\"type\":\"fixed\",\"name\":\"F\","
+        "\"size\":2}}]}");
+    const BinaryComparator bc(vs);
+    const GenericComparator gc(vs);
+
+    boost::mt19937 rnd(42);
+    GenericDatum d1(vs);
+    GenericDatum d2(vs);
+    for (int i = 0; i < 2000; ++i) {
+        randomize(d1, rnd);
+        randomize(d2, rnd);
+        const std::string b1 = encodeBinary(d1);
+        const std::string b2 = encodeBinary(d2);
+        const int expected = sign(gc.compare(d1, d2));
+        BOOST_REQUIRE_EQUAL(binaryCompare(bc, b1, b2), expected);
+        BOOST_REQUIRE_EQUAL(binaryCompare(bc, b2, b1), -expected);
+        BOOST_REQUIRE_EQUAL(binaryCompare(bc, b1, b1), 0);
+    }
+
+    // Running out of bytes within a value is an error; trailing bytes are
+    // not looked at.
+    const std::string b = encodeBinary(d1);
+    BOOST_CHECK_THROW(binaryCompare(bc, b, b.substr(0, b.size() - 1)),
+        Exception);
+    BOOST_CHECK_EQUAL(binaryCompare(bc, b, b + "x"), 0);
+
+    ValidSchema ms = parsing::makeValidSchema(
+        "{\"type\":\"map\",\"values\":\"int\"}");
+    const std::string empty(1, '\0');
+    BOOST_CHECK_THROW(binaryCompare(BinaryComparator(ms), empty, empty),
+        Exception);
+}
+
+static void testBinaryComparatorBlocks()
+{
+    ValidSchema vs = parsing::makeValidSchema(
+        "{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+        "{\"name\":\"m\",\"type\":{\"type\":\"map\",\"values\":\"int\"},"
+        "\"order\":\"ignore\"},"
+        "{\"name\":\"a\",\"type\":{\"type\":\"array\",\"items\":\"int\"}}]}");
+    const BinaryComparator c(vs);
+
+    // The map {"k": 1} in one block, counted by size, then arrays of
+    // 1, 2, 3 in blocks of different sizes.
+    const char sized[] = "\x01\x06\x02k\x02\x00" "\x02\x02\x04\x04\x06\x00";
+    const char plain[] = "\x00" "\x06\x02\x04\x06\x00";
+    const char shorter[] = "\x00" "\x04\x02\x04\x00";
+    const char later[] = "\x00" "\x03\x04\x02\x04\x00";
+    const std::string a(sized, sizeof(sized) - 1);
+    const std::string b(plain, sizeof(plain) - 1);
+    const std::string s(shorter, sizeof(shorter) - 1);
+    const std::string l(later, sizeof(later) - 1);
+    BOOST_CHECK_EQUAL(binaryCompare(c, a, b), 0);
+    BOOST_CHECK_EQUAL(binaryCompare(c, a, s), 1);
+    BOOST_CHECK_EQUAL(binaryCompare(c, s, b), -1);
+    // [1, 2], counted by size, sorts before [1, 2, 3].
+    BOOST_CHECK_EQUAL(binaryCompare(c, l, b), -1);
+}
+
+/**
+ * Returns the binary encoding of the given longs, one after another.
+ */
+static std::string encodeLongs(const int64_t* v, size_t n)
+{
+    std::auto_ptr<OutputStream> os = memoryOutputStream();
+    EncoderPtr e = binaryEncoder();
+    e->init(*os);
+    for (size_t i = 0; i < n; ++i) {
+        e->encodeLong(v[i]);
+    }
+    e->flush();
+    return toString(*os);
+}
+
+static void testBinaryComparatorCounts()
+{
+    const int64_t huge = int64_t(1) << 62;
+    const int64_t minCount = std::numeric_limits<int64_t>::min();
+
+    // Nulls take no bytes, so any count of them is there in full.
+    ValidSchema ns = parsing::makeValidSchema(
+        "{\"type\":\"array\",\"items\":\"null\"}");
+    const BinaryComparator nc(ns);
+    const int64_t manyNulls[] = { huge, huge, 0 };
+    const int64_t fewNulls[] = { 3, 0 };
+    const std::string many = encodeLongs(manyNulls, 3);
+    const std::string few = encodeLongs(fewNulls, 2);
+    BOOST_CHECK_EQUAL(binaryCompare(nc, many, few), 1);
+    BOOST_CHECK_EQUAL(binaryCompare(nc, many, many), 0);
+
+    // Other items need a byte each, so a count beyond the bytes left is
+    // cut short.
+    ValidSchema is = parsing::makeValidSchema(
+        "{\"type\":\"array\",\"items\":\"int\"}");
+    const BinaryComparator ic(is);
+    const int64_t manyInts[] = { huge, 1, 0 };
+    const int64_t badCount[] = { minCount, 1, 1, 0 };
+    const std::string ints = encodeLongs(manyInts, 3);
+    const std::string bad = encodeLongs(badCount, 4);
+    BOOST_CHECK_THROW(binaryCompare(ic, ints, ints), Exception);
+    BOOST_CHECK_THROW(binaryCompare(ic, bad, bad), Exception);
+
+    ValidSchema rs = parsing::makeValidSchema(
+        "{\"type\":\"record\",\"name\":\"R\",\"fields\":["
+        "{\"name\":\"n\",\"type\":{\"type\":\"array\",\"items\":\"null\"},"
+        "\"order\":\"ignore\"},"
+        "{\"name\":\"a\",\"type\":{\"type\":\"array\",\"items\":\"int\"},"
+        "\"order\":\"ignore\"},"
+        "{\"name\":\"k\",\"type\":\"int\"}]}");
+    const BinaryComparator rc(rs);
+    const int64_t r1[] = { huge, 0, 0, 1 };
+    const int64_t r2[] = { 0, 0, 2 };
+    const int64_t r3[] = { 0, huge, 1, 0, 1 };
+    BOOST_CHECK_EQUAL(binaryCompare(rc, encodeLongs(r1, 4),
+        encodeLongs(r2, 3)), -1);
+    BOOST_CHECK_THROW(binaryCompare(rc, encodeLongs(r3, 5),
+        encodeLongs(r2, 3)), Exception);
+}
+
 }   // namespace avro
 
 boost::unit_test::test_suite*
@@ -1428,6 +2086,16 @@ init_unit_test_suite( int argc, char* argv[] )
     test_suite* ts= BOOST_TEST_SUITE("Avro C++ unit tests for codecs");
     avro::parsing::add_tests(*ts);
     ts->add(BOOST_TEST_CASE(avro::testStreamLifetimes));
+    ts->add(BOOST_TEST_CASE(avro::testJsonNameLookup));
+    ts->add(BOOST_TEST_CASE(avro::testTranscoder));
+    ts->add(BOOST_TEST_CASE(avro::testTranscoderBlocks));
+    ts->add(BOOST_TEST_CASE(avro::testTranscoderReuse));
+    ts->add(BOOST_TEST_CASE(avro::testFieldPath));
+    ts->add(BOOST_TEST_CASE(avro::testGenericCompare));
+    ts->add(BOOST_TEST_CASE(avro::testGenericCompareMaps));
+    ts->add(BOOST_TEST_CASE(avro::testBinaryComparator));
+    ts->add(BOOST_TEST_CASE(avro::testBinaryComparatorBlocks));
+    ts->add(BOOST_TEST_CASE(avro::testBinaryComparatorCounts));
 
     return ts;
 }
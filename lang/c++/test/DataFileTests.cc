@@ -284,6 +284,101 @@ public:
         BOOST_CHECK_EQUAL(i, 1000);
     }
 
+    /**
+     * Reads the file as a sequence of byte ranges, each with a reader of
+     * its own, and checks that every object is read exactly once.
+     */
+    void testReadSplits() {
+        const int64_t size = boost::filesystem::file_size(filename);
+        const int64_t splitSizes[] = { 10, 100, 1000, size };
+        for (size_t k = 0; k < sizeof(splitSizes) / sizeof(splitSizes[0]);
+            ++k) {
+            int i = 0;
+            int64_t re = 3;
+            int64_t im = 5;
+            for (int64_t start = 0; start < size; start += splitSizes[k]) {
+                avro::DataFileReader<ComplexInteger> df(filename,
+                    writerSchema);
+                df.sync(start);
+                ComplexInteger ci;
+                while (! df.pastSync(start + splitSizes[k]) && df.read(ci)) {
+                    BOOST_CHECK_EQUAL(ci.re, re);
+                    BOOST_CHECK_EQUAL(ci.im, im);
+                    re *= im;
+                    im += 3;
+                    ++i;
+                }
+            }
+            BOOST_CHECK_EQUAL(i, 1000);
+        }
+    }
+
+    /**
+     * Reads the first object of every block, skipping the rest.
+     */
+    void testSkipBlock() {
+        vector<pair<int64_t, int64_t> > firsts;
+        {
+            avro::DataFileReader<ComplexInteger> df(filename, writerSchema);
+            ComplexInteger ci;
+            int64_t block = -1;
+            while (df.read(ci)) {
+                if (df.previousSync() != block) {
+                    block = df.previousSync();
+                    firsts.push_back(std::make_pair(ci.re, ci.im));
+                }
+            }
+        }
+        BOOST_CHECK(firsts.size() > 1);
+
+        avro::DataFileReader<ComplexInteger> df(filename, writerSchema);
+        ComplexInteger ci;
+        size_t i = 0;
+        while (df.read(ci)) {
+            BOOST_REQUIRE(i < firsts.size());
+            BOOST_CHECK_EQUAL(ci.re, firsts[i].first);
+            BOOST_CHECK_EQUAL(ci.im, firsts[i].second);
+            df.skipBlock();
+            ++i;
+        }
+        BOOST_CHECK_EQUAL(i, firsts.size());
+    }
+
+    void testCountRecords() {
+        {
+            avro::DataFileReader<ComplexInteger> df(filename, writerSchema);
+            BOOST_CHECK_EQUAL(df.countRecords(), 1000);
+        }
+        avro::DataFileReader<ComplexInteger> df(filename, writerSchema);
+        ComplexInteger ci;
+        for (int i = 0; i < 5; ++i) {
+            BOOST_REQUIRE(df.read(ci));
+        }
+        BOOST_CHECK_EQUAL(df.countRecords(), 995);
+        BOOST_CHECK(! df.read(ci));
+    }
+
+    /**
+     * Seeks back to a block start obtained through previousSync().
+     */
+    void testSeek() {
+        avro::DataFileReader<ComplexInteger> df(filename, writerSchema);
+        df.sync(boost::filesystem::file_size(filename) / 2);
+        const int64_t position = df.previousSync();
+        ComplexInteger first;
+        BOOST_REQUIRE(df.read(first));
+        ComplexInteger ci;
+        while (df.read(ci)) {
+        }
+        BOOST_CHECK(df.pastSync(position));
+
+        df.seek(position);
+        BOOST_CHECK_EQUAL(df.previousSync(), position);
+        BOOST_REQUIRE(df.read(ci));
+        BOOST_CHECK_EQUAL(ci.re, first.re);
+        BOOST_CHECK_EQUAL(ci.im, first.im);
+    }
+
     /**
      * Constructs the DataFileReader in two steps.
      */
@@ -339,6 +434,10 @@ void addReaderTests(test_suite* ts, const shared_ptr<DataFileTest>& t)
     ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testReaderGeneric, t));
     ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testReaderGenericProjection,
         t));
+    ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testReadSplits, t));
+    ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testSeek, t));
+    ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testSkipBlock, t));
+    ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testCountRecords, t));
     ts->add(BOOST_CLASS_TEST_CASE(&DataFileTest::testCleanup, t));
 
 }
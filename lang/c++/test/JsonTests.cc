@@ -17,13 +17,17 @@
  */
 
 
+#include <stdlib.h>
+#include <string.h>
 #include <limits>
 
 #include <boost/test/included/unit_test_framework.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/parameterized_test.hpp>
 
+#include "Exception.hh"
 #include "../impl/json/JsonDom.hh"
+#include "../impl/json/JsonIO.hh"
 
 #define S(x) #x
 
@@ -48,6 +52,7 @@ TestData<int64_t> longData[] = {
     { "1", etLong, 1 },
     { "9223372036854775807", etLong, 9223372036854775807LL },
     { "-9223372036854775807", etLong, -9223372036854775807LL },
+    { "123456789012345678", etLong, 123456789012345678LL },
 };
 
 TestData<double> doubleData[] = {
@@ -56,6 +61,11 @@ TestData<double> doubleData[] = {
     { "1.0", etDouble, 1.0 },
     { "4.7e3", etDouble, 4700.0 },
     { "-7.2e-4", etDouble, -0.00072 },
+    { "1e5", etDouble, 100000.0 },
+    { "1.5E+2", etDouble, 150.0 },
+    { "0.1", etDouble, 0.1 },
+    { "3.14159265358979323846", etDouble, 3.14159265358979323846 },
+    { "2.5e-300", etDouble, 2.5e-300 },
 };
 
 TestData<const char*> stringData[] = {
@@ -65,6 +75,10 @@ TestData<const char*> stringData[] = {
     { "\"\\u000a\"", etString, "\n" },
     { "\"\\\"\"", etString, "\"" },
     { "\"\\/\"", etString, "/" },
+    { "\"a string longer than sixteen bytes\"", etString,
+        "a string longer than sixteen bytes" },
+    { "\"sixteen bytes in\\n the middle of a long string\"", etString,
+        "sixteen bytes in\n the middle of a long string" },
 };
 
 template <typename T>
@@ -171,6 +185,156 @@ static void testObject2()
     BOOST_CHECK_EQUAL(a[1].value<std::string>(), "v0");
 }
 
+static void testWhitespace()
+{
+    Entity n = loadEntity("\n{\n                                \"k1\"\t:\r\n"
+        "                                [\n      100 ,\n    \"v\"   ]   }\n");
+    BOOST_CHECK_EQUAL(n.type(), etObject);
+    const std::map<std::string, Entity>& m =
+        n.value<std::map<std::string, Entity> >();
+    BOOST_CHECK_EQUAL(m.size(), 1);
+    BOOST_CHECK_EQUAL(m.begin()->second.type(), etArray);
+}
+
+static void testMismatchedEnd()
+{
+    BOOST_CHECK_THROW(loadEntity("[1}"), Exception);
+    BOOST_CHECK_THROW(loadEntity("{\"k\"]"), Exception);
+    BOOST_CHECK_THROW(loadEntity("{\"k\"}"), Exception);
+    BOOST_CHECK_THROW(loadEntity("[1.]"), Exception);
+    BOOST_CHECK_THROW(loadEntity("[-]"), Exception);
+    BOOST_CHECK_THROW(loadEntity("[1e+]"), Exception);
+}
+
+/**
+ * Tokenizes input spread over many small chunks, so that strings,
+ * numbers and whitespace runs straddle chunk boundaries.
+ */
+static void testChunked()
+{
+    const std::string text = "[\"a string that is long enough to span chunks"
+        " \\u00e9\", 1234567890123, -2.5e-3,          true, null,"
+        " {\"key\": 9876.54321}]";
+    for (size_t size = 1; size < 16; ++size) {
+        std::auto_ptr<OutputStream> os = memoryOutputStream(size);
+        StreamWriter w(*os);
+        w.writeBytes(reinterpret_cast<const uint8_t*>(text.data()),
+            text.size());
+        w.flush();
+        std::auto_ptr<InputStream> is = memoryInputStream(*os);
+        JsonParser p;
+        p.init(*is);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkArrayStart);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkString);
+        BOOST_CHECK_EQUAL(p.stringValue(),
+            "a string that is long enough to span chunks \xc3\xa9");
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkLong);
+        BOOST_CHECK_EQUAL(p.longValue(), 1234567890123LL);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkDouble);
+        BOOST_CHECK_EQUAL(p.doubleValue(), -2.5e-3);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkBool);
+        BOOST_CHECK(p.boolValue());
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkNull);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkObjectStart);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkString);
+        BOOST_CHECK_EQUAL(p.stringValue(), "key");
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkDouble);
+        BOOST_CHECK_EQUAL(p.doubleValue(), 9876.54321);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkObjectEnd);
+        BOOST_CHECK_EQUAL(p.advance(), JsonParser::tkArrayEnd);
+    }
+}
+
+template <typename T>
+static std::string generate(T t)
+{
+    std::auto_ptr<OutputStream> os = memoryOutputStream();
+    JsonGenerator g;
+    g.init(*os);
+    g.encodeNumber(t);
+    g.flush();
+    std::auto_ptr<InputStream> is = memoryInputStream(*os);
+    std::string result;
+    const uint8_t* b;
+    size_t n;
+    while (is->next(&b, &n)) {
+        result.append(reinterpret_cast<const char*>(b), n);
+    }
+    return result;
+}
+
+static void testGenerateNumbers()
+{
+    BOOST_CHECK_EQUAL(generate(int32_t(0)), "0");
+    BOOST_CHECK_EQUAL(generate(std::numeric_limits<int32_t>::min()),
+        "-2147483648");
+    BOOST_CHECK_EQUAL(generate(std::numeric_limits<int64_t>::min()),
+        "-9223372036854775808");
+    BOOST_CHECK_EQUAL(generate(std::numeric_limits<int64_t>::max()),
+        "9223372036854775807");
+    BOOST_CHECK_EQUAL(generate(0.0), "0");
+    BOOST_CHECK_EQUAL(generate(-0.0), "-0.0");
+    BOOST_CHECK_EQUAL(generate(-0.0f), "-0.0");
+    BOOST_CHECK_EQUAL(generate(0.1), "0.1");
+    BOOST_CHECK_EQUAL(generate(-1.5), "-1.5");
+    BOOST_CHECK_EQUAL(generate(100.0), "100");
+    BOOST_CHECK_EQUAL(generate(1e17), "100000000000000000");
+    BOOST_CHECK_EQUAL(generate(1e20), "1e+20");
+    BOOST_CHECK_EQUAL(generate(1.5e20), "1.5e+20");
+    BOOST_CHECK_EQUAL(generate(1e21), "1e+21");
+    BOOST_CHECK_EQUAL(generate(1e-6), "0.000001");
+    BOOST_CHECK_EQUAL(generate(1.25e-7), "1.25e-7");
+    BOOST_CHECK_EQUAL(generate(3.141592653589793), "3.141592653589793");
+    BOOST_CHECK_EQUAL(generate(std::numeric_limits<double>::max()),
+        "1.7976931348623157e+308");
+    BOOST_CHECK_EQUAL(generate(std::numeric_limits<double>::denorm_min()),
+        "5e-324");
+    BOOST_CHECK_EQUAL(generate(0.1f), "0.1");
+    BOOST_CHECK_EQUAL(generate(16777216.0f), "16777216");
+
+    // Every double written must read back as itself, sign of zero
+    // included.
+    srand(7);
+    for (int i = 0; i < 100002; ++i) {
+        const uint64_t u = i == 0 ? 0 : i == 1 ? 1ULL << 63 :
+            (static_cast<uint64_t>(rand()) << 42) ^
+            (static_cast<uint64_t>(rand()) << 21) ^ rand();
+        double d;
+        ::memcpy(&d, &u, sizeof(d));
+        if (d != d || d - d != 0) {
+            continue;
+        }
+        const std::string s = generate(d);
+        Entity n = loadEntity(s.c_str());
+        const double r = n.type() == etLong ?
+            static_cast<double>(n.value<int64_t>()) : n.value<double>();
+        BOOST_CHECK_MESSAGE(::memcmp(&r, &d, sizeof(d)) == 0, s);
+    }
+}
+
+static void testGenerateString()
+{
+    std::string s = "a run long enough to be copied in bulk, then \"quotes\", "
+        "a / slash, a \\ backslash, a \n newline, \x01 and \x7f, "
+        "and caf\xc3\xa9";
+    std::auto_ptr<OutputStream> os = memoryOutputStream(7);
+    JsonGenerator g;
+    g.init(*os);
+    g.encodeString(s);
+    g.flush();
+    std::auto_ptr<InputStream> is = memoryInputStream(*os);
+    std::string result;
+    const uint8_t* b;
+    size_t n;
+    while (is->next(&b, &n)) {
+        result.append(reinterpret_cast<const char*>(b), n);
+    }
+    BOOST_CHECK_EQUAL(result, "\"a run long enough to be copied in bulk, "
+        "then \\\"quotes\\\", a \\/ slash, a \\\\ backslash, a \\n newline, "
+        "\\U0001 and \\U007f, and caf\xc3\xa9\"");
+    BOOST_CHECK_EQUAL(loadEntity(result.c_str()).value<std::string>(), s);
+}
+
 }
 }
 
@@ -205,5 +369,11 @@ init_unit_test_suite( int argc, char* argv[] )
     ts->add(BOOST_TEST_CASE(&avro::json::testObject1));
     ts->add(BOOST_TEST_CASE(&avro::json::testObject2));
 
+    ts->add(BOOST_TEST_CASE(&avro::json::testWhitespace));
+    ts->add(BOOST_TEST_CASE(&avro::json::testMismatchedEnd));
+    ts->add(BOOST_TEST_CASE(&avro::json::testChunked));
+    ts->add(BOOST_TEST_CASE(&avro::json::testGenerateNumbers));
+    ts->add(BOOST_TEST_CASE(&avro::json::testGenerateString));
+
     return ts;
 }
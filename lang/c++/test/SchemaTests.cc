@@ -18,6 +18,10 @@
 
 #include "Compiler.hh"
 #include "ValidSchema.hh"
+#include "SchemaTable.hh"
+#include "Stream.hh"
+
+#include <sstream>
 
 #include <boost/test/included/unit_test_framework.hpp>
 #include <boost/test/unit_test.hpp>
@@ -125,6 +129,86 @@ const char* basicSchemaErrors[] = {
     "{\"type\": \"fixed\", \"size\": 314}",
 };
 
+/**
+ * Schemas, their Parsing Canonical Form and fingerprint, taken from
+ * share/test/data/schema-tests.txt.
+ */
+struct CanonicalSchema {
+    const char* schema;
+    const char* canonical;
+    int64_t fingerprint;
+};
+
+const CanonicalSchema canonicalSchemas[] = {
+    { "\"null\"", "\"null\"", 7195948357588979594LL },
+    { "{\"type\":\"boolean\"}", "\"boolean\"", -6970731678124411036LL },
+    { "[ \"int\" , {\"type\":\"boolean\"} ]", "[\"int\",\"boolean\"]",
+        5392556393470105090LL },
+    { "{\"fields\":[], \"type\":\"record\", \"name\":\"a.b.foo\", "
+        "\"namespace\":\"x.y\"}",
+        "{\"name\":\"a.b.foo\",\"type\":\"record\",\"fields\":[]}",
+        -4616218487480524110LL },
+    { "{\"fields\":[], \"type\":\"record\", \"name\":\"foo\", \"doc\":\"foo\", "
+        "\"aliases\":[\"foo\",\"bar\"]}",
+        "{\"name\":\"foo\",\"type\":\"record\",\"fields\":[]}",
+        -4824392279771201922LL },
+    { "{ \"fields\":[{\"type\":\"boolean\", \"aliases\":[], \"name\":\"f1\", "
+        "\"default\":\"true\"}, {\"order\":\"descending\",\"name\":\"f2\","
+        "\"doc\":\"Hello\",\"type\":\"int\"}], \"type\":\"record\", \"name\":\"foo\"}",
+        "{\"name\":\"foo\",\"type\":\"record\",\"fields\":[{\"name\":\"f1\","
+        "\"type\":\"boolean\"},{\"name\":\"f2\",\"type\":\"int\"}]}",
+        -4860222112080293046LL },
+    { "{\"namespace\":\"x.y.z\", \"type\":\"enum\", \"name\":\"foo\", "
+        "\"doc\":\"foo bar\", \"symbols\":[\"A1\", \"A2\"]}",
+        "{\"name\":\"x.y.z.foo\",\"type\":\"enum\",\"symbols\":[\"A1\",\"A2\"]}",
+        -4448647247586288245LL },
+    { "{\"namespace\":\"x.y.z\", \"type\":\"fixed\", \"name\":\"foo\", "
+        "\"doc\":\"foo bar\", \"size\":32}",
+        "{\"name\":\"x.y.z.foo\",\"type\":\"fixed\",\"size\":32}",
+        -3064184465700546786LL },
+    { "{ \"items\":{\"type\":\"null\"}, \"type\":\"array\"}",
+        "{\"type\":\"array\",\"items\":\"null\"}",
+        -589620603366471059LL },
+    { "{ \"values\":\"string\", \"type\":\"map\"}",
+        "{\"type\":\"map\",\"values\":\"string\"}",
+        -8732877298790414990LL },
+    { "{\"name\":\"PigValue\",\"type\":\"record\", \"fields\":[{\"name\":\"value\", "
+        "\"type\":[\"null\", \"int\", \"long\", \"PigValue\"]}]}",
+        "{\"name\":\"PigValue\",\"type\":\"record\",\"fields\":[{\"name\":\"value\","
+        "\"type\":[\"null\",\"int\",\"long\",\"PigValue\"]}]}",
+        -1759257747318642341LL },
+};
+
+/**
+ * Pairs of schemas that differ only in the order of their members, and in
+ * members that are ignored, which must compile alike.
+ */
+struct ReorderedSchema {
+    const char* ordered;
+    const char* reordered;
+};
+
+const ReorderedSchema reorderedSchemas[] = {
+    { "{\"type\":\"record\",\"name\":\"R\",\"namespace\":\"n\",\"fields\":["
+        "{\"name\":\"e\",\"type\":{\"type\":\"enum\",\"name\":\"E\","
+        "\"symbols\":[\"A\",\"B\"]}},{\"name\":\"f\",\"type\":\"E\"}]}",
+      "{\"fields\":[{\"type\":{\"symbols\":[\"A\",\"B\"],\"name\":\"E\","
+        "\"type\":\"enum\"},\"name\":\"e\"},{\"type\":\"E\",\"name\":\"f\"}],"
+        "\"name\":\"R\",\"type\":\"record\",\"namespace\":\"n\"}" },
+    { "{\"type\":\"record\",\"name\":\"R\",\"fields\":[{\"name\":\"a\","
+        "\"type\":{\"type\":\"array\",\"items\":{\"type\":\"fixed\","
+        "\"name\":\"F\",\"size\":4}}},{\"name\":\"m\",\"type\":{\"type\":"
+        "\"map\",\"values\":[\"null\",\"F\",\"R\"]}}]}",
+      "{\"name\":\"R\",\"fields\":[{\"type\":{\"items\":{\"size\":4,"
+        "\"name\":\"F\",\"type\":\"fixed\"},\"type\":\"array\"},\"name\":\"a\"},"
+        "{\"name\":\"m\",\"type\":{\"values\":[\"null\",\"F\",\"R\"],"
+        "\"type\":\"map\"}}],\"type\":\"record\"}" },
+    { "{\"type\":\"enum\",\"name\":\"E\",\"namespace\":\"x.y\","
+        "\"symbols\":[\"A\"]}",
+      "{\"symbols\":[\"A\"],\"doc\":{\"a\":[1,2.5,null]},\"name\":\"E\","
+        "\"namespace\":\"x.y\",\"type\":\"enum\"}" },
+};
+
 static void testBasic(const char* schema)
 {
     BOOST_CHECKPOINT(schema);
@@ -137,6 +221,163 @@ static void testBasic_fail(const char* schema)
     BOOST_CHECK_THROW(compileJsonSchemaFromString(schema), Exception);
 }
 
+static void testCanonical(const CanonicalSchema& cs)
+{
+    BOOST_CHECKPOINT(cs.schema);
+    ValidSchema s = compileJsonSchemaFromString(cs.schema);
+    std::ostringstream oss;
+    s.toCanonicalJson(oss);
+    BOOST_CHECK_EQUAL(oss.str(), cs.canonical);
+    BOOST_CHECK_EQUAL(static_cast<int64_t>(s.fingerprint()), cs.fingerprint);
+}
+
+static std::string canonical(const ValidSchema& s)
+{
+    std::ostringstream oss;
+    s.toCanonicalJson(oss);
+    return oss.str();
+}
+
+static void testReordered(const ReorderedSchema& rs)
+{
+    BOOST_CHECKPOINT(rs.reordered);
+    BOOST_CHECK_EQUAL(canonical(compileJsonSchemaFromString(rs.ordered)),
+        canonical(compileJsonSchemaFromString(rs.reordered)));
+}
+
+static void testNameIndex()
+{
+    const size_t n = 500;
+    std::ostringstream oss;
+    oss << "{\"type\":\"record\",\"name\":\"R\",\"fields\":[";
+    for (size_t i = 0; i < n; ++i) {
+        oss << (i == 0 ? "" : ",") << "{\"name\":\"f" << i
+            << "\",\"type\":\"int\"}";
+    }
+    oss << "]}";
+    ValidSchema s = compileJsonSchemaFromString(oss.str());
+    const NodePtr& r = s.root();
+    for (size_t i = 0; i < n; ++i) {
+        size_t index = n;
+        BOOST_CHECK(r->nameIndex(r->nameAt(i), index));
+        BOOST_CHECK_EQUAL(index, i);
+    }
+    size_t index;
+    BOOST_CHECK(! r->nameIndex("f500", index));
+    BOOST_CHECK(! r->nameIndex("", index));
+
+    BOOST_CHECK_THROW(compileJsonSchemaFromString(
+        "{\"type\":\"enum\",\"name\":\"E\",\"symbols\":[\"A\",\"B\",\"A\"]}"),
+        Exception);
+}
+
+static void testSchemaTable()
+{
+    ValidSchema s = compileJsonSchemaFromString(
+        "{\"type\":\"record\",\"name\":\"n.Node\",\"fields\":["
+        "{\"name\":\"kind\",\"type\":{\"type\":\"enum\",\"name\":\"Kind\","
+        "\"symbols\":[\"leaf\",\"kind\"]}},"
+        "{\"name\":\"id\",\"type\":{\"type\":\"fixed\",\"name\":\"Id\","
+        "\"size\":16}},"
+        "{\"name\":\"children\",\"type\":{\"type\":\"array\","
+        "\"items\":\"Node\"}},"
+        "{\"name\":\"parent\",\"type\":[\"null\",\"Node\"]}]}");
+    SchemaTable t(s);
+
+    const size_t r = t.root();
+    BOOST_CHECK_EQUAL(t.type(r), AVRO_RECORD);
+    BOOST_CHECK_EQUAL(t.name(r), "n.Node");
+    BOOST_CHECK(t.node(r) == s.root());
+    BOOST_REQUIRE_EQUAL(t.leaves(r), 4);
+    BOOST_CHECK_EQUAL(t.names(r), 4);
+    BOOST_CHECK_EQUAL(t.nameAt(r, 3), "parent");
+
+    const size_t e = t.leafAt(r, 0);
+    BOOST_CHECK_EQUAL(t.type(e), AVRO_ENUM);
+    BOOST_CHECK_EQUAL(t.name(e), "n.Kind");
+    BOOST_CHECK_EQUAL(t.names(e), 2);
+    BOOST_CHECK_EQUAL(t.nameAt(e, 1), "kind");
+    // Names are kept once.
+    BOOST_CHECK_EQUAL(&t.nameAt(e, 1), &t.nameAt(r, 0));
+    BOOST_CHECK_EQUAL(t.resolve(e), e);
+
+    const size_t f = t.leafAt(r, 1);
+    BOOST_CHECK_EQUAL(t.type(f), AVRO_FIXED);
+    BOOST_CHECK_EQUAL(t.fixedSize(f), 16);
+
+    // Both references to Node share an entry, which leads back to the root.
+    const size_t a = t.leafAt(r, 2);
+    BOOST_CHECK_EQUAL(t.type(a), AVRO_ARRAY);
+    const size_t ref = t.leafAt(a, 0);
+    BOOST_CHECK_EQUAL(t.type(ref), AVRO_SYMBOLIC);
+    BOOST_CHECK_EQUAL(t.resolve(ref), r);
+    BOOST_CHECK_EQUAL(t.name(ref), "n.Node");
+
+    const size_t u = t.leafAt(r, 3);
+    BOOST_CHECK_EQUAL(t.type(u), AVRO_UNION);
+    BOOST_REQUIRE_EQUAL(t.leaves(u), 2);
+    BOOST_CHECK_EQUAL(t.type(t.leafAt(u, 0)), AVRO_NULL);
+    BOOST_CHECK(! t.hasName(t.leafAt(u, 0)));
+    BOOST_CHECK_EQUAL(t.leafAt(u, 1), ref);
+}
+
+static void testSchemaCache()
+{
+    const std::string a = "{\"type\":\"array\",\"items\":\"int\"}";
+    const std::string b = "{\"type\":\"map\",\"values\":\"int\"}";
+    const std::string c = "{\"type\":\"array\",\"items\":\"long\"}";
+
+    SchemaCache cache(2);
+    NodePtr ra = cache.compile(a).root();
+    NodePtr rb = cache.compile(b).root();
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(cache.compile(a).root() == ra);
+    BOOST_CHECK_EQUAL(canonical(cache.compile(a)), canonical(
+        compileJsonSchemaFromString(a)));
+
+    // b is now the least recently used, so c pushes it out.
+    cache.compile(c);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(cache.compile(a).root() == ra);
+    BOOST_CHECK(cache.compile(b).root() != rb);
+
+    BOOST_CHECK_THROW(cache.compile("{\"type\":\"nosuchtype\"}"), Exception);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK(cache.compile(a).root() != ra);
+}
+
+/**
+ * Compiling from a stream reads the schema and no further, whether the
+ * streaming compiler takes it or leaves it to the DOM-based one, and
+ * however the stream comes in chunks.
+ */
+static void testStreamRest()
+{
+    const char* schemas[] = {
+        reorderedSchemas[0].ordered,
+        reorderedSchemas[0].reordered,
+        "\"int\""
+    };
+    for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); ++i) {
+        for (size_t bufferSize = 1; bufferSize < 64; bufferSize += 7) {
+            std::istringstream iss(std::string(schemas[i]) + "  rest");
+            std::auto_ptr<InputStream> in = istreamInputStream(iss,
+                bufferSize);
+            BOOST_CHECK_EQUAL(canonical(compileJsonSchemaFromStream(*in)),
+                canonical(compileJsonSchemaFromString(schemas[i])));
+            std::string rest;
+            StreamReader r(*in);
+            while (r.hasMore()) {
+                rest.push_back(r.read());
+            }
+            BOOST_CHECK_EQUAL(rest, "  rest");
+        }
+    }
+}
+
 }
 }
 
@@ -155,6 +396,14 @@ init_unit_test_suite(int argc, char* argv[])
     ADD_PARAM_TEST(ts, avro::schema::testBasic, avro::schema::basicSchemas);
     ADD_PARAM_TEST(ts, avro::schema::testBasic_fail,
         avro::schema::basicSchemaErrors);
+    ADD_PARAM_TEST(ts, avro::schema::testCanonical,
+        avro::schema::canonicalSchemas);
+    ADD_PARAM_TEST(ts, avro::schema::testReordered,
+        avro::schema::reorderedSchemas);
+    ts->add(BOOST_TEST_CASE(&avro::schema::testNameIndex));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testSchemaTable));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testSchemaCache));
+    ts->add(BOOST_TEST_CASE(&avro::schema::testStreamRest));
 
     return ts;
 }
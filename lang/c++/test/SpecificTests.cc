@@ -158,6 +158,43 @@ void testArray()
     BOOST_CHECK_EQUAL_COLLECTIONS(b.begin(), b.end(), n.begin(), n.end());
 }
 
+void testBoolArray()
+{
+    vector<bool> n;
+    n.push_back(true);
+    n.push_back(false);
+    n.push_back(true);
+    vector<bool> b = encodeAndDecode(n);
+
+    BOOST_CHECK(b == n);
+}
+
+void testArrayReuse()
+{
+    vector<string> n;
+    n.push_back("first");
+    n.push_back("second");
+
+    Test tst;
+    tst.encode(n);
+
+    vector<string> b(5, string(100, 'x'));
+    const char* p = b[0].data();
+    tst.decode(b);
+    BOOST_CHECK_EQUAL_COLLECTIONS(b.begin(), b.end(), n.begin(), n.end());
+    BOOST_CHECK(b[0].data() == p);
+}
+
+void testArrayCount()
+{
+    Test tst;
+    tst.encode(int64_t(1) << 40);
+    tst.encode(int32_t(7));
+
+    vector<int32_t> b;
+    BOOST_CHECK_THROW(tst.decode(b), Exception);
+}
+
 void testMap()
 {
     map<string, int32_t> n;
@@ -194,6 +231,9 @@ init_unit_test_suite( int argc, char* argv[] )
     ts->add(BOOST_TEST_CASE(avro::specific::testBytes));
     ts->add(BOOST_TEST_CASE(avro::specific::testFixed));
     ts->add(BOOST_TEST_CASE(avro::specific::testArray));
+    ts->add(BOOST_TEST_CASE(avro::specific::testBoolArray));
+    ts->add(BOOST_TEST_CASE(avro::specific::testArrayReuse));
+    ts->add(BOOST_TEST_CASE(avro::specific::testArrayCount));
     ts->add(BOOST_TEST_CASE(avro::specific::testMap));
     ts->add(BOOST_TEST_CASE(avro::specific::testCustom));
     return ts;
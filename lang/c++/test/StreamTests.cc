@@ -18,7 +18,9 @@
 
 #include "boost/filesystem.hpp"
 #include "Stream.hh"
+#include "ChunkPool.hh"
 #include "Exception.hh"
+#include "buffer/Buffer.hh"
 #include <boost/test/included/unit_test_framework.hpp>
 #include <boost/test/parameterized_test.hpp>
 
@@ -131,6 +133,81 @@ void testNonEmpty2(const TestData& td) {
     Verify1()(*is, td.dataSize);
 }
 
+template <typename V>
+void testEmpty_bufferStream() {
+    OutputBuffer ob;
+    {
+        std::auto_ptr<OutputStream> os = bufferOutputStream(ob);
+        os->flush();
+    }
+    std::auto_ptr<InputStream> is = bufferInputStream(ob);
+    V()(*is);
+}
+
+template <typename F, typename V>
+void testNonEmpty_bufferStream(const TestData& td)
+{
+    OutputBuffer ob;
+    std::auto_ptr<OutputStream> os = bufferOutputStream(ob);
+    F()(*os, td.dataSize);
+    BOOST_CHECK_EQUAL(ob.size(), td.dataSize);
+
+    std::auto_ptr<InputStream> is = bufferInputStream(ob);
+    V()(*is, td.dataSize);
+}
+
+/**
+ * Checks that the streams use the buffer's chunks rather than copies.
+ */
+void testBufferStreamSharesChunks()
+{
+    OutputBuffer ob;
+    std::auto_ptr<OutputStream> os = bufferOutputStream(ob);
+    Fill1()(*os, 10000);
+
+    InputBuffer ib = ob.extractData();
+    std::auto_ptr<InputStream> is = bufferInputStream(ib);
+    const uint8_t* b;
+    size_t n;
+    for (InputBuffer::const_iterator it = ib.begin(); it != ib.end(); ++it) {
+        BOOST_REQUIRE(is->next(&b, &n));
+        BOOST_CHECK(reinterpret_cast<const char*>(b) == it->data());
+        BOOST_CHECK_EQUAL(n, it->size());
+    }
+    BOOST_CHECK(! is->next(&b, &n));
+}
+
+/**
+ * Checks that memory streams take their chunks from the installed pool
+ * and that released chunks are reused.
+ */
+void testChunkPool()
+{
+    const ChunkPoolPtr original = chunkPool();
+    const ChunkPoolPtr pool = cachingChunkPool(1024 * 1024, 4);
+    setChunkPool(pool);
+    {
+        std::auto_ptr<OutputStream> os = memoryOutputStream(4096);
+        Fill1()(*os, 3 * 4096);
+        ChunkPoolStats s = pool->stats();
+        BOOST_CHECK_EQUAL(s.live, 3U);
+        BOOST_CHECK_EQUAL(s.pooled, 0U);
+        BOOST_CHECK_EQUAL(s.allocated, 3U);
+    }
+    ChunkPoolStats s = pool->stats();
+    BOOST_CHECK_EQUAL(s.live, 0U);
+    BOOST_CHECK_EQUAL(s.pooled, 3U);
+    {
+        std::auto_ptr<OutputStream> os = memoryOutputStream(3000);
+        Fill1()(*os, 2 * 3000);
+        ChunkPoolStats s = pool->stats();
+        BOOST_CHECK_EQUAL(s.live, 2U);
+        BOOST_CHECK_EQUAL(s.pooled, 1U);
+        BOOST_CHECK_EQUAL(s.allocated, 3U);
+    }
+    setChunkPool(original);
+}
+
 static const char filename[] = "test_str.bin";
 
 struct FileRemover {
@@ -212,6 +289,27 @@ init_unit_test_suite( int argc, char* argv[] )
         avro::stream::data +
         sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
 
+    ts->add(BOOST_TEST_CASE(
+        &avro::stream::testEmpty_bufferStream<avro::stream::CheckEmpty1>));
+    ts->add(BOOST_TEST_CASE(
+        &avro::stream::testEmpty_bufferStream<avro::stream::CheckEmpty2>));
+
+    ts->add(BOOST_PARAM_TEST_CASE(
+        (&avro::stream::testNonEmpty_bufferStream<avro::stream::Fill1,
+            avro::stream::Verify1>),
+        avro::stream::data,
+        avro::stream::data +
+        sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
+    ts->add(BOOST_PARAM_TEST_CASE(
+        (&avro::stream::testNonEmpty_bufferStream<avro::stream::Fill2,
+            avro::stream::Verify2>),
+        avro::stream::data,
+        avro::stream::data +
+        sizeof(avro::stream::data) / sizeof(avro::stream::data[0])));
+    ts->add(BOOST_TEST_CASE(
+        &avro::stream::testBufferStreamSharesChunks));
+    ts->add(BOOST_TEST_CASE(&avro::stream::testChunkPool));
+
     ts->add(BOOST_TEST_CASE(
         &avro::stream::testEmpty_fileStream<avro::stream::CheckEmpty1>));
     ts->add(BOOST_TEST_CASE(
@@ -32,6 +32,9 @@
 #include "buffer/BufferStream.hh"
 #include "buffer/BufferReader.hh"
 #include "buffer/BufferPrint.hh"
+#ifndef _WIN32
+#include "buffer/BufferIO.hh"
+#endif
 
 using namespace avro;
 using std::cout;
@@ -1113,6 +1116,123 @@ void TestPrinter()
     }
 }
 
+void TestChunkPool()
+{
+    BOOST_MESSAGE( "TestChunkPool");
+    {
+        const ChunkPoolPtr original = chunkPool();
+        const ChunkPoolPtr pool = newDeleteChunkPool();
+        setChunkPool(pool);
+        {
+            OutputBuffer ob;
+            addDataToBuffer(ob, 2 * kDefaultBlockSize);
+            BOOST_CHECK_EQUAL(pool->stats().live, 2U);
+
+            // the chunks go back to their own pool
+            setChunkPool(original);
+            InputBuffer ib = ob.extractData();
+            ob.discardData();
+            BOOST_CHECK_EQUAL(pool->stats().live, 2U);
+        }
+        BOOST_CHECK_EQUAL(pool->stats().live, 0U);
+        BOOST_CHECK_EQUAL(pool->stats().allocated, 2U);
+    }
+}
+
+#ifndef _WIN32
+struct PoolUser {
+    ChunkPool *pool;
+    ChunkPool *before;
+    ChunkPool *after;
+    bool synced;
+    int toMain[2];
+    int toThread[2];
+};
+
+void *useChunkPool(void *p)
+{
+    PoolUser *u = static_cast<PoolUser *>(p);
+    u->pool->release(u->pool->allocate(1024), 1024);
+    u->before = chunkPool().get();
+    // the checks are left to the main thread, as Boost.Test is not
+    // thread-safe
+    char c = 0;
+    u->synced = ::write(u->toMain[1], &c, 1) == 1 &&
+        ::read(u->toThread[0], &c, 1) == 1;
+    u->after = chunkPool().get();
+    return 0;
+}
+
+void TestChunkPoolLifetime()
+{
+    BOOST_MESSAGE( "TestChunkPoolLifetime");
+    {
+        const ChunkPoolPtr original = chunkPool();
+        const ChunkPoolPtr other = newDeleteChunkPool();
+        boost::weak_ptr<ChunkPool> weak;
+        {
+            ChunkPoolPtr pool = cachingChunkPool();
+            weak = pool;
+            PoolUser u;
+            u.pool = pool.get();
+            BOOST_REQUIRE_EQUAL(::pipe(u.toMain), 0);
+            BOOST_REQUIRE_EQUAL(::pipe(u.toThread), 0);
+            pthread_t t;
+            BOOST_REQUIRE_EQUAL(::pthread_create(&t, 0, useChunkPool, &u), 0);
+            char c;
+            BOOST_CHECK_EQUAL(::read(u.toMain[0], &c, 1), 1);
+
+            // the thread's cache does not keep the pool, and the thread
+            // picks up the pool installed meanwhile
+            pool.reset();
+            BOOST_CHECK(weak.expired());
+            setChunkPool(other);
+            BOOST_CHECK_EQUAL(::write(u.toThread[1], &c, 1), 1);
+            ::pthread_join(t, 0);
+            BOOST_CHECK(u.synced);
+            BOOST_CHECK(u.before == original.get());
+            BOOST_CHECK(u.after == other.get());
+            for (int i = 0; i < 2; ++i) {
+                ::close(u.toMain[i]);
+                ::close(u.toThread[i]);
+            }
+        }
+        setChunkPool(original);
+    }
+}
+
+void TestWritevReadv()
+{
+    BOOST_MESSAGE( "TestWritevReadv");
+    {
+        // more chunks than can be passed to a single writev
+        const size_t size = (detail::kMaxIovecs + 100) * kDefaultBlockSize + 10;
+
+        OutputBuffer ob;
+        addDataToBuffer(ob, size);
+        BOOST_CHECK(ob.numDataChunks() > detail::kMaxIovecs);
+
+        FILE *f = tmpfile();
+        BOOST_REQUIRE(f);
+        int fd = fileno(f);
+
+        BOOST_CHECK_EQUAL(writeBuffer(fd, ob), size);
+        BOOST_REQUIRE_EQUAL(::lseek(fd, 0, SEEK_SET), 0);
+
+        // ask for more than there is to check reading stops at end of file
+        InputBuffer ib = readBuffer(fd, size + 100);
+        fclose(f);
+        BOOST_CHECK_EQUAL(ib.size(), size);
+
+        avro::istream is(ib);
+        std::string result;
+        result.resize(size);
+        is.read(&result[0], size);
+        BOOST_CHECK(result == makeString(size));
+    }
+}
+#endif
+
 struct BufferTestSuite : public boost::unit_test::test_suite
 {
     BufferTestSuite()  : 
@@ -1139,6 +1259,11 @@ struct BufferTestSuite : public boost::unit_test::test_suite
         add (BOOST_TEST_CASE( TestForeign));
         add (BOOST_TEST_CASE( TestForeignDiscard));
         add (BOOST_TEST_CASE( TestPrinter));
+        add (BOOST_TEST_CASE( TestChunkPool));
+#ifndef _WIN32
+        add (BOOST_TEST_CASE( TestChunkPoolLifetime));
+        add (BOOST_TEST_CASE( TestWritevReadv));
+#endif
     }
 };
 
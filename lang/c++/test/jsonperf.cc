@@ -0,0 +1,201 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures the throughput of the JSON tokenizer.
+ *
+ * Usage: jsonperf [-n count] [file ...]
+ *
+ * Each file is tokenized repeatedly, then a corpus of count tweet-like
+ * records (100000 by default) is generated in memory and tokenized.
+ * Without files, the schemas in jsonschemas/ are used, so run it from the
+ * source directory.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+
+#include "Exception.hh"
+#include "Stream.hh"
+#include "../impl/json/JsonIO.hh"
+
+using std::string;
+using std::vector;
+using avro::json::JsonParser;
+
+/**
+ * Tokenizes count top-level values from text and returns the number of
+ * tokens.
+ */
+static size_t tokenize(const string& text, size_t count)
+{
+    std::auto_ptr<avro::InputStream> is = avro::memoryInputStream(
+        reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    JsonParser p;
+    p.init(*is);
+    size_t tokens = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int depth = 0;
+        do {
+            switch (p.advance()) {
+            case JsonParser::tkArrayStart:
+            case JsonParser::tkObjectStart:
+                ++depth;
+                break;
+            case JsonParser::tkArrayEnd:
+            case JsonParser::tkObjectEnd:
+                --depth;
+                break;
+            default:
+                break;
+            }
+            ++tokens;
+        } while (depth > 0);
+    }
+    return tokens;
+}
+
+/**
+ * Tokenizes text, which holds count values, repeatedly for about a second
+ * and reports the throughput.
+ */
+static void run(const string& name, const string& text, size_t count)
+{
+    size_t rounds = 0;
+    size_t tokens = 0;
+    const clock_t start = clock();
+    clock_t now;
+    do {
+        tokens += tokenize(text, count);
+        ++rounds;
+        now = clock();
+    } while (now - start < CLOCKS_PER_SEC);
+
+    const double seconds = static_cast<double>(now - start) / CLOCKS_PER_SEC;
+    const double mb = static_cast<double>(text.size()) * rounds / 1e6;
+    std::cout << name << ": " << text.size() << " bytes, "
+        << mb / seconds << " MB/s, "
+        << tokens / seconds / 1e6 << " Mtokens/s" << std::endl;
+}
+
+static string readFile(const string& filename)
+{
+    std::ifstream in(filename.c_str());
+    std::ostringstream oss;
+    oss << in.rdbuf();
+    return oss.str();
+}
+
+/**
+ * Generates count records in the style of the tweet schema, with escapes,
+ * non-ASCII text, nulls, integers and doubles.
+ */
+static string makeTweets(size_t count)
+{
+    static const char* const words[] = {
+        "avro", "schema", "record", "union", "caf\\u00e9", "\\\"quoted\\\"",
+        "line\\nbreak", "https:\\/\\/example.com\\/a\\/b", "tokenizer", "json"
+    };
+    const size_t nwords = sizeof(words) / sizeof(words[0]);
+
+    std::ostringstream oss;
+    oss.precision(17);
+    srand(42);
+    for (size_t i = 0; i < count; ++i) {
+        oss << "{\"ID\": " << 1000000000000LL + i << ", \"text\": \"";
+        const size_t n = 8 + rand() % 16;
+        for (size_t j = 0; j < n; ++j) {
+            oss << (j == 0 ? "" : " ") << words[rand() % nwords];
+        }
+        oss << "\", \"authorScreenName\": \"user" << rand() % 10000 << "\""
+            << ", \"authorProfileImageURL\": \"http:\\/\\/example.com\\/"
+            << "profile_images\\/" << rand() << "\\/avatar_normal.png\""
+            << ", \"authorUserID\": ";
+        if (i % 3 == 0) {
+            oss << "null";
+        } else {
+            oss << "{\"long\": " << rand() << "}";
+        }
+        oss << ", \"location\": ";
+        if (i % 2 == 0) {
+            oss << "null";
+        } else {
+            oss << "{\"com.bifflabs.grok.model.common.avro.AvroPoint\": "
+                << "{\"latitude\": " << rand() / (RAND_MAX / 180.0) - 90
+                << ", \"longitude\": " << rand() / (RAND_MAX / 360.0) - 180
+                << "}}";
+        }
+        oss << ", \"tags\": [\"avro\", \"json\", \"perf\"]}\n";
+    }
+    return oss.str();
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 100000;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "-n" && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    try {
+        if (files.empty()) {
+            namespace fs = boost::filesystem;
+            for (fs::directory_iterator it("jsonschemas");
+                it != fs::directory_iterator(); ++it) {
+                files.push_back(it->path().string());
+            }
+        }
+
+        string all;
+        size_t parsed = 0;
+        for (vector<string>::const_iterator it = files.begin();
+            it != files.end(); ++it) {
+            const string text = readFile(*it);
+            try {
+                run(*it, text, 1);
+            } catch (avro::Exception& e) {
+                // Some schemas are not strict JSON.
+                std::cout << *it << ": skipped, " << e.what() << std::endl;
+                continue;
+            }
+            all += text;
+            ++parsed;
+        }
+        if (parsed > 1) {
+            run("all files", all, parsed);
+        }
+
+        run("tweets", makeTweets(count), count);
+    } catch (std::exception& e) {
+        std::cerr << "Failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}